@@ -0,0 +1,121 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   BufferPool.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "BufferPool.hpp"
+#include <pthread.h>
+#include <new>
+
+static pthread_key_t pool_key;
+static pthread_once_t pool_key_once = PTHREAD_ONCE_INIT;
+
+static void createPoolKey()
+{
+	pthread_key_create(&pool_key, NULL);
+}
+
+BufferPool::BufferPool() : hits(0), misses(0)
+{
+	for (int i = 0; i < CLASS_COUNT; ++i)
+	{
+		free_lists[i] = NULL;
+		free_counts[i] = 0;
+	}
+}
+
+BufferPool::~BufferPool()
+{
+	for (int i = 0; i < CLASS_COUNT; ++i)
+	{
+		while (free_lists[i] != NULL)
+		{
+			FreeBlock *block = free_lists[i];
+			free_lists[i] = block->next;
+			::operator delete(block);
+		}
+	}
+}
+
+void BufferPool::bind(BufferPool *pool)
+{
+	pthread_once(&pool_key_once, createPoolKey);
+	pthread_setspecific(pool_key, pool);
+}
+
+BufferPool *BufferPool::current()
+{
+	pthread_once(&pool_key_once, createPoolKey);
+	return static_cast<BufferPool*>(pthread_getspecific(pool_key));
+}
+
+// Plus petite classe qui contient `bytes`, -1 au-dela de la plus grande
+int BufferPool::classOf(size_t bytes)
+{
+	size_t size = static_cast<size_t>(1) << MIN_SHIFT;
+	for (int i = 0; i < CLASS_COUNT; ++i, size <<= 1)
+		if (bytes <= size)
+			return i;
+	return -1;
+}
+
+void *BufferPool::allocate(size_t bytes)
+{
+	int size_class = classOf(bytes);
+	if (size_class < 0)
+		return ::operator new(bytes);
+	// Toujours la taille pleine de la classe : le bloc peut etre libere par un
+	// autre thread et servir ensuite a tout message de sa classe
+	size_t class_size = static_cast<size_t>(1) << (MIN_SHIFT + size_class);
+	BufferPool *pool = current();
+	if (pool == NULL)
+		return ::operator new(class_size);
+	FreeBlock *block = pool->free_lists[size_class];
+	if (block != NULL)
+	{
+		pool->free_lists[size_class] = block->next;
+		--pool->free_counts[size_class];
+		++pool->hits;
+		return block;
+	}
+	++pool->misses;
+	return ::operator new(class_size);
+}
+
+// `bytes` doit etre la taille demandee a allocate() : elle redonne la classe
+void BufferPool::release(void *block, size_t bytes)
+{
+	int size_class = classOf(bytes);
+	BufferPool *pool = size_class < 0 ? NULL : current();
+	if (pool == NULL)
+	{
+		::operator delete(block);
+		return;
+	}
+	FreeBlock *free_block = static_cast<FreeBlock*>(block);
+	free_block->next = pool->free_lists[size_class];
+	pool->free_lists[size_class] = free_block;
+	++pool->free_counts[size_class];
+}
+
+void BufferPool::trim()
+{
+	for (int i = 0; i < CLASS_COUNT; ++i)
+	{
+		size_t keep = KEEP_BYTES >> (MIN_SHIFT + i);
+		while (free_counts[i] > keep)
+		{
+			FreeBlock *block = free_lists[i];
+			free_lists[i] = block->next;
+			--free_counts[i];
+			::operator delete(block);
+		}
+	}
+}
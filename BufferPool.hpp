@@ -0,0 +1,64 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   BufferPool.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef BUFFERPOOL_HPP
+#define BUFFERPOOL_HPP
+
+#include <cstddef>
+#include <stdint.h>
+
+// Blocs des messages sortants, ranges par classes de taille (64 a 1024
+// octets). Chaque reacteur lie sa propre reserve a son thread : un bloc libere
+// retourne dans la reserve du thread qui le libere et sert au prochain
+// message de meme classe, sans passer par malloc. trim() en fin de tour
+// rend au systeme ce qui depasse la reserve gardee par classe.
+// Sans reserve liee (thread sans reacteur, arret), allocation directe.
+class BufferPool
+{
+	public:
+		enum
+		{
+			MIN_SHIFT = 6, // 64 octets
+			CLASS_COUNT = 5, // 64, 128, 256, 512, 1024
+			KEEP_BYTES = 256 * 1024 // Gardes par classe apres trim()
+		};
+
+		BufferPool();
+		~BufferPool();
+
+		static void bind(BufferPool *pool); // Pour le thread appelant
+		static void *allocate(size_t bytes);
+		static void release(void *block, size_t bytes);
+
+		void trim();
+		uint64_t getHits() const { return hits; }
+		uint64_t getMisses() const { return misses; }
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock *next;
+		};
+
+		FreeBlock *free_lists[CLASS_COUNT];
+		size_t free_counts[CLASS_COUNT];
+		uint64_t hits; // Allocations servies par la reserve
+		uint64_t misses; // Allocations passees a operator new
+
+		static BufferPool *current();
+		static int classOf(size_t bytes);
+
+		BufferPool(const BufferPool&);
+		BufferPool& operator=(const BufferPool&);
+};
+
+#endif
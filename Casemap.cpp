@@ -0,0 +1,38 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Casemap.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Casemap.hpp"
+
+static unsigned char foldChar(unsigned char c)
+{
+	if (c >= 'A' && c <= '^') // A-Z puis [ \ ] ^
+		return c + 32;
+	return c;
+}
+
+std::string ircFold(const std::string& str)
+{
+	std::string folded(str);
+	for (std::string::size_type i = 0; i < folded.size(); ++i)
+		folded[i] = foldChar(folded[i]);
+	return folded;
+}
+
+bool ircEquals(const std::string& a, const std::string& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (std::string::size_type i = 0; i < a.size(); ++i)
+		if (foldChar(a[i]) != foldChar(b[i]))
+			return false;
+	return true;
+}
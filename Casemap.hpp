@@ -0,0 +1,23 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Casemap.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CASEMAP_HPP
+#define CASEMAP_HPP
+
+#include <string>
+
+// Casemapping RFC 1459 : A-Z -> a-z et []\^ -> {}|~
+// Deux pseudos (ou canaux) sont identiques si leurs formes repliees le sont.
+std::string	ircFold(const std::string& str);
+bool		ircEquals(const std::string& a, const std::string& b);
+
+#endif
@@ -0,0 +1,219 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Channel.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Channel.hpp"
+#include <algorithm>
+
+Channel::Channel(unsigned int id, const std::string& name) : id(id), name(name), modes(0), limit(0), topic_time(0), persisted_hash(0) {}
+
+unsigned int Channel::getId() const
+{
+	return id;
+}
+
+const std::string& Channel::getName() const
+{
+	return name;
+}
+
+int Channel::memberPosition(Client *client) const
+{
+	for (size_t i = 0; i < members.size(); ++i)
+	{
+		if (members[i] == client)
+			return i;
+	}
+	return -1;
+}
+
+const std::vector<Client*>& Channel::getMembers() const
+{
+	return members;
+}
+
+size_t Channel::memberCount() const
+{
+	return members.size();
+}
+
+bool Channel::isMember(Client *client) const
+{
+	return memberPosition(client) != -1;
+}
+
+void Channel::addMember(Client *client, bool op)
+{
+	if (isMember(client))
+		return;
+	members.push_back(client);
+	member_flags.push_back(op ? MEMBER_OPERATOR : 0);
+}
+
+void Channel::removeMember(Client *client)
+{
+	int pos = memberPosition(client);
+	if (pos == -1)
+		return;
+	members.erase(members.begin() + pos);
+	member_flags.erase(member_flags.begin() + pos);
+}
+
+bool Channel::isOperator(Client *client) const
+{
+	int pos = memberPosition(client);
+	return pos != -1 && (member_flags[pos] & MEMBER_OPERATOR);
+}
+
+bool Channel::setOperator(Client *client, bool op)
+{
+	int pos = memberPosition(client);
+	if (pos == -1)
+		return false;
+	if (op)
+		member_flags[pos] |= MEMBER_OPERATOR;
+	else
+		member_flags[pos] &= ~MEMBER_OPERATOR;
+	return true;
+}
+
+bool Channel::hasMode(Mode mode) const
+{
+	return (modes & mode) != 0;
+}
+
+unsigned int Channel::getModes() const
+{
+	return modes;
+}
+
+void Channel::setMode(Mode mode, bool enabled)
+{
+	if (enabled)
+		modes |= mode;
+	else
+		modes &= ~mode;
+}
+
+const std::string& Channel::getKey() const
+{
+	return key;
+}
+
+void Channel::setKey(const std::string& key)
+{
+	this->key = key;
+}
+
+size_t Channel::getLimit() const
+{
+	return limit;
+}
+
+void Channel::setLimit(size_t limit)
+{
+	this->limit = limit;
+}
+
+bool Channel::hasTopic() const
+{
+	return !topic_set_by.empty();
+}
+
+const std::string& Channel::getTopic() const
+{
+	return topic;
+}
+
+time_t Channel::getTopicTime() const
+{
+	return topic_time;
+}
+
+const std::string& Channel::getTopicSetBy() const
+{
+	return topic_set_by;
+}
+
+void Channel::setTopic(const std::string& topic, const std::string& set_by, time_t when)
+{
+	this->topic = topic;
+	topic_set_by = set_by;
+	topic_time = when;
+}
+
+void Channel::clearTopic()
+{
+	topic.clear();
+	topic_set_by.clear();
+	topic_time = 0;
+}
+
+void Channel::addInvitation(const std::string& folded_nick)
+{
+	if (std::find(invitations.begin(), invitations.end(), folded_nick) == invitations.end())
+		invitations.push_back(folded_nick);
+}
+
+bool Channel::consumeInvitation(const std::string& folded_nick)
+{
+	std::vector<std::string>::iterator it = std::find(invitations.begin(), invitations.end(), folded_nick);
+	if (it == invitations.end())
+		return false;
+	invitations.erase(it);
+	return true;
+}
+
+const std::vector<std::string>& Channel::getInvitations() const
+{
+	return invitations;
+}
+
+void Channel::addPendingOperator(const std::string& folded_nick)
+{
+	if (std::find(pending_operators.begin(), pending_operators.end(), folded_nick) == pending_operators.end())
+		pending_operators.push_back(folded_nick);
+}
+
+bool Channel::consumePendingOperator(const std::string& folded_nick)
+{
+	std::vector<std::string>::iterator it = std::find(pending_operators.begin(), pending_operators.end(), folded_nick);
+	if (it == pending_operators.end())
+		return false;
+	pending_operators.erase(it);
+	return true;
+}
+
+const std::vector<std::string>& Channel::getPendingOperators() const
+{
+	return pending_operators;
+}
+
+uint32_t Channel::getPersistedHash() const
+{
+	return persisted_hash;
+}
+
+void Channel::setPersistedHash(uint32_t hash)
+{
+	persisted_hash = hash;
+}
+
+ChannelHistory& Channel::getHistory()
+{
+	return history;
+}
+
+// Un canal qui attend le retour de ses operateurs est conserve
+bool Channel::isDisposable() const
+{
+	return members.empty() && modes == 0 && !hasTopic() && pending_operators.empty();
+}
@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Channel.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHANNEL_HPP
+#define CHANNEL_HPP
+
+#include <string>
+#include <vector>
+#include <ctime>
+#include <stdint.h>
+#include "Client.hpp"
+#include "ChannelHistory.hpp"
+
+// Tout l'etat d'un canal dans un seul objet : membres (avec leur drapeau
+// operateur), modes en bitset, cle, limite, sujet et invitations.
+class Channel
+{
+	public:
+		enum Mode
+		{
+			MODE_INVITE = 1 << 0, // +i
+			MODE_TOPIC = 1 << 1, // +t
+			MODE_KEY = 1 << 2, // +k
+			MODE_LIMIT = 1 << 3 // +l
+		};
+		enum MemberFlag
+		{
+			MEMBER_OPERATOR = 1 << 0
+		};
+
+	private:
+		unsigned int id;
+		std::string name;
+		std::vector<Client*> members;
+		std::vector<unsigned char> member_flags; // meme position que members
+		unsigned int modes;
+		std::string key;
+		size_t limit;
+		std::string topic;
+		time_t topic_time;
+		std::string topic_set_by;
+		std::vector<std::string> invitations; // pseudos replies (RFC 1459)
+		std::vector<std::string> pending_operators; // relus du disque, op a leur retour
+		uint32_t persisted_hash; // Empreinte du dernier etat journalise (0 : jamais)
+		ChannelHistory history; // Derniers PRIVMSG/NOTICE, pour CHATHISTORY
+
+		int memberPosition(Client *client) const;
+
+	public:
+		Channel(unsigned int id, const std::string& name);
+
+		unsigned int getId() const;
+		const std::string& getName() const;
+
+		const std::vector<Client*>& getMembers() const;
+		size_t memberCount() const;
+		bool isMember(Client *client) const;
+		void addMember(Client *client, bool op);
+		void removeMember(Client *client);
+		bool isOperator(Client *client) const;
+		bool setOperator(Client *client, bool op); // false si non membre
+
+		bool hasMode(Mode mode) const;
+		unsigned int getModes() const;
+		void setMode(Mode mode, bool enabled);
+		const std::string& getKey() const;
+		void setKey(const std::string& key);
+		size_t getLimit() const;
+		void setLimit(size_t limit);
+
+		bool hasTopic() const;
+		const std::string& getTopic() const;
+		time_t getTopicTime() const;
+		const std::string& getTopicSetBy() const;
+		void setTopic(const std::string& topic, const std::string& set_by, time_t when);
+		void clearTopic();
+
+		void addInvitation(const std::string& folded_nick);
+		bool consumeInvitation(const std::string& folded_nick);
+		const std::vector<std::string>& getInvitations() const;
+
+		void addPendingOperator(const std::string& folded_nick);
+		bool consumePendingOperator(const std::string& folded_nick);
+		const std::vector<std::string>& getPendingOperators() const;
+		uint32_t getPersistedHash() const;
+		void setPersistedHash(uint32_t hash);
+		ChannelHistory& getHistory();
+
+		// Vide et sans etat a conserver : peut etre libere
+		bool isDisposable() const;
+};
+
+#endif
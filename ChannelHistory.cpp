@@ -0,0 +1,254 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelHistory.cpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ChannelHistory.hpp"
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+
+//----------------------ARENA-----------------------------------------
+
+HistoryArena::HistoryArena() : write_pos(0), last_id(0) {}
+
+void HistoryArena::init(size_t size)
+{
+	bytes.assign(size, 0);
+	write_pos = 0;
+}
+
+bool HistoryArena::isEnabled() const
+{
+	return !bytes.empty();
+}
+
+// Sous history_lock pour les lignes gardees ; hors verrou pour les messages
+// prives, par plusieurs reacteurs a la fois
+uint64_t HistoryArena::nextId()
+{
+	return __sync_add_and_fetch(&last_id, 1);
+}
+
+uint64_t HistoryArena::store(const char *head, size_t head_size, const char *body, size_t body_size)
+{
+	size_t size = head_size + body_size;
+	size_t offset = write_pos % bytes.size();
+	// Pas de ligne a cheval sur la fin : le reste du tour est abandonne
+	if (offset + size > bytes.size())
+	{
+		write_pos += bytes.size() - offset;
+		offset = 0;
+	}
+	uint64_t pos = write_pos;
+	std::memcpy(&bytes[offset], head, head_size);
+	std::memcpy(&bytes[offset + head_size], body, body_size);
+	write_pos += size;
+	return pos;
+}
+
+bool HistoryArena::isLive(uint64_t pos) const
+{
+	return !bytes.empty() && pos + bytes.size() >= write_pos;
+}
+
+const char *HistoryArena::at(uint64_t pos) const
+{
+	return &bytes[pos % bytes.size()];
+}
+
+//----------------------REFERENCE-----------------------------------------
+
+// "msgid=42", "timestamp=2026-10-17T21:00:00.000Z" ou "*"
+bool HistoryRef::parse(const std::string& text)
+{
+	type = NONE;
+	value = 0;
+	if (text == "*")
+		return true;
+	if (text.compare(0, 6, "msgid=") == 0)
+	{
+		const char *digits = text.c_str() + 6;
+		if (*digits == '\0' || std::strspn(digits, "0123456789") != std::strlen(digits))
+			return false;
+		type = MSGID;
+		value = std::strtoull(digits, NULL, 10);
+		return true;
+	}
+	if (text.compare(0, 10, "timestamp=") == 0)
+	{
+		struct tm parts;
+		std::memset(&parts, 0, sizeof(parts));
+		int millis = 0;
+		int consumed = 0;
+		const char *stamp = text.c_str() + 10;
+		if (std::sscanf(stamp, "%4d-%2d-%2dT%2d:%2d:%2d%n", &parts.tm_year, &parts.tm_mon, &parts.tm_mday,
+				&parts.tm_hour, &parts.tm_min, &parts.tm_sec, &consumed) != 6)
+			return false;
+		stamp += consumed;
+		if (*stamp == '.')
+		{
+			if (std::sscanf(stamp, ".%3d%n", &millis, &consumed) != 1)
+				return false;
+			stamp += consumed;
+		}
+		if (std::strcmp(stamp, "Z") != 0)
+			return false;
+		parts.tm_year -= 1900;
+		parts.tm_mon -= 1;
+		time_t seconds = timegm(&parts);
+		if (seconds < 0)
+			return false;
+		type = TIME;
+		value = static_cast<uint64_t>(seconds) * 1000 + millis;
+		return true;
+	}
+	return false;
+}
+
+//----------------------CHANNEL-HISTORY-----------------------------------------
+
+ChannelHistory::ChannelHistory() : head(0), count(0) {}
+
+void ChannelHistory::append(HistoryArena& arena, size_t capacity, const MessageTags& tags,
+	const char *line, size_t line_size)
+{
+	if (slots.size() != capacity)
+	{
+		slots.assign(capacity, Entry());
+		head = 0;
+		count = 0;
+	}
+	// L'horloge murale peut reculer ; l'ordre des horodatages ne le doit pas.
+	// Un msgid pris hors history_lock peut arriver apres un plus recent : il
+	// est ramene au dernier, les recherches dichotomiques supposent l'ordre.
+	uint64_t time_ms = tags.time_ms;
+	uint64_t id = tags.id;
+	if (count > 0 && time_ms < at(count - 1).time_ms)
+		time_ms = at(count - 1).time_ms;
+	if (count > 0 && id < at(count - 1).id)
+		id = at(count - 1).id;
+	Entry& entry = slots[(head + count) % capacity];
+	entry.pos = arena.store(tags.text, tags.size, line, line_size);
+	entry.id = id;
+	entry.time_ms = time_ms;
+	entry.length = static_cast<uint32_t>(tags.size + line_size);
+	entry.tags_length = static_cast<uint16_t>(tags.size);
+	entry.time_offset = static_cast<uint16_t>(tags.time_offset);
+	// Anneau plein : l'entree ecrite remplace la plus ancienne
+	if (count == capacity)
+		head = (head + 1) % capacity;
+	else
+		++count;
+}
+
+void ChannelHistory::prune(const HistoryArena& arena)
+{
+	while (count > 0 && !arena.isLive(slots[head].pos))
+	{
+		head = (head + 1) % slots.size();
+		--count;
+	}
+}
+
+size_t ChannelHistory::size() const
+{
+	return count;
+}
+
+const ChannelHistory::Entry& ChannelHistory::at(size_t index) const
+{
+	return slots[(head + index) % slots.size()];
+}
+
+uint64_t ChannelHistory::key(size_t index, HistoryRef::Type type) const
+{
+	return type == HistoryRef::TIME ? at(index).time_ms : at(index).id;
+}
+
+// msgid et horodatage ne decroissent jamais avec l'index : recherche dichotomique
+size_t ChannelHistory::lowerBound(const HistoryRef& ref) const
+{
+	size_t low = 0;
+	size_t high = count;
+	while (low < high)
+	{
+		size_t mid = low + (high - low) / 2;
+		if (key(mid, ref.type) < ref.value)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+size_t ChannelHistory::upperBound(const HistoryRef& ref) const
+{
+	size_t low = 0;
+	size_t high = count;
+	while (low < high)
+	{
+		size_t mid = low + (high - low) / 2;
+		if (key(mid, ref.type) <= ref.value)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+// Les plus recentes, eventuellement seulement celles apres la reference
+void ChannelHistory::latest(const HistoryRef& after, size_t limit, size_t& first, size_t& last) const
+{
+	size_t low = after.type == HistoryRef::NONE ? 0 : upperBound(after);
+	last = count;
+	first = last - low > limit ? last - limit : low;
+}
+
+void ChannelHistory::before(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const
+{
+	last = lowerBound(ref);
+	first = last > limit ? last - limit : 0;
+}
+
+void ChannelHistory::after(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const
+{
+	first = upperBound(ref);
+	last = count - first > limit ? first + limit : count;
+}
+
+// Moitie avant la reference, le reste apres
+void ChannelHistory::around(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const
+{
+	size_t middle = lowerBound(ref);
+	first = middle > limit / 2 ? middle - limit / 2 : 0;
+	last = count - first > limit ? first + limit : count;
+	first = last > limit ? last - limit : 0;
+}
+
+// Bornes exclues ; si from est apres to, ce sont les plus recentes qui sont gardees
+void ChannelHistory::between(const HistoryRef& from, const HistoryRef& to, size_t limit, size_t& first, size_t& last) const
+{
+	size_t low = upperBound(from);
+	size_t high = lowerBound(to);
+	if (low <= high)
+	{
+		first = low;
+		last = high - low > limit ? low + limit : high;
+		return;
+	}
+	low = upperBound(to);
+	high = lowerBound(from);
+	if (low > high)
+		low = high;
+	last = high;
+	first = high - low > limit ? high - limit : low;
+}
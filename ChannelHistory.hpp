@@ -0,0 +1,106 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelHistory.hpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHANNELHISTORY_HPP
+#define CHANNELHISTORY_HPP
+
+#include "MessageTags.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// Arene commune a tous les historiques : un anneau d'octets de taille fixe
+// (history_memory) ou les lignes sont copiees deja serialisees. Les positions
+// sont absolues et ne font que croitre ; une ligne est vivante tant que
+// l'ecriture ne l'a pas depassee d'un tour. Le plafond memoire global est
+// donc la taille de l'anneau, et l'eviction (la ligne la plus ancienne,
+// tous canaux confondus) ne coute rien.
+class HistoryArena
+{
+	private:
+		std::vector<char> bytes;
+		uint64_t write_pos; // Prochaine position absolue
+		uint64_t last_id; // Dernier msgid attribue
+
+		HistoryArena(const HistoryArena&);
+		HistoryArena& operator=(const HistoryArena&);
+
+	public:
+		HistoryArena();
+
+		void init(size_t size);
+		bool isEnabled() const;
+		uint64_t nextId();
+		// Copie head puis body d'un bloc, sans jamais couper une ligne en fin
+		// d'anneau ; renvoie la position absolue de la ligne
+		uint64_t store(const char *head, size_t head_size, const char *body, size_t body_size);
+		bool isLive(uint64_t pos) const;
+		const char *at(uint64_t pos) const;
+};
+
+// Reference de CHATHISTORY : msgid=<id> ou timestamp=<ISO 8601>, ou '*'
+struct HistoryRef
+{
+	enum Type { NONE, MSGID, TIME };
+
+	Type type;
+	uint64_t value; // msgid, ou millisecondes depuis l'epoque
+
+	HistoryRef() : type(NONE), value(0) {}
+	bool parse(const std::string& text);
+};
+
+// Historique d'un canal : anneau de capacite fixe d'entrees vers l'arene,
+// du plus ancien au plus recent. Alloue au premier message seulement.
+class ChannelHistory
+{
+	public:
+		struct Entry
+		{
+			uint64_t pos; // Dans l'arene
+			uint64_t id;
+			uint64_t time_ms;
+			uint32_t length; // Etiquettes comprises
+			uint16_t tags_length; // "@msgid=...;time=... "
+			uint16_t time_offset; // Debut de "time=" dans les etiquettes
+		};
+
+	private:
+		std::vector<Entry> slots;
+		size_t head; // Plus ancienne entree
+		size_t count;
+
+		uint64_t key(size_t index, HistoryRef::Type type) const;
+		size_t lowerBound(const HistoryRef& ref) const; // Premiere entree >= ref
+		size_t upperBound(const HistoryRef& ref) const; // Premiere entree > ref
+
+	public:
+		ChannelHistory();
+
+		// Ligne stockee precedee de ses etiquettes : la relecture choisit le
+		// point de depart selon les capacites du client
+		void append(HistoryArena& arena, size_t capacity, const MessageTags& tags,
+			const char *line, size_t line_size);
+		void prune(const HistoryArena& arena); // Oublie les lignes ecrasees dans l'arene
+		size_t size() const;
+		const Entry& at(size_t index) const; // 0 : la plus ancienne
+
+		// Sous-commandes de CHATHISTORY : plage [first, last) d'au plus limit entrees
+		void latest(const HistoryRef& after, size_t limit, size_t& first, size_t& last) const;
+		void before(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const;
+		void after(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const;
+		void around(const HistoryRef& ref, size_t limit, size_t& first, size_t& last) const;
+		void between(const HistoryRef& from, const HistoryRef& to, size_t limit, size_t& first, size_t& last) const;
+};
+
+#endif
@@ -0,0 +1,420 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelStore.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ChannelStore.hpp"
+#include "Logger.hpp"
+#include <cstring>
+#include <cstdio> // rename
+#include <cerrno>
+#include <fcntl.h> // open
+#include <unistd.h> // write, fdatasync, usleep
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+
+#define SNAPSHOT_MAGIC "IRCSNAP1"
+
+//----------------------RECORD-----------------------------------------
+
+static void writeList(StateWriter& writer, const std::vector<std::string>& list)
+{
+	writer.putU32(list.size());
+	for (size_t i = 0; i < list.size(); ++i)
+		writer.putString(list[i]);
+}
+
+static void readList(StateReader& reader, std::vector<std::string>& list)
+{
+	uint32_t count = reader.getU32();
+	for (uint32_t i = 0; i < count && reader.ok(); ++i)
+		list.push_back(reader.getString());
+}
+
+void ChannelRecord::write(StateWriter& writer) const
+{
+	writer.putString(name);
+	writer.putU32(modes);
+	writer.putString(key);
+	writer.putU64(limit);
+	writer.putU8(has_topic);
+	writer.putString(topic);
+	writer.putString(topic_set_by);
+	writer.putU64(topic_time);
+	writeList(writer, invitations);
+	writeList(writer, operators);
+}
+
+bool ChannelRecord::read(StateReader& reader)
+{
+	name = reader.getString();
+	modes = reader.getU32();
+	key = reader.getString();
+	limit = reader.getU64();
+	has_topic = reader.getU8();
+	topic = reader.getString();
+	topic_set_by = reader.getString();
+	topic_time = reader.getU64();
+	readList(reader, invitations);
+	readList(reader, operators);
+	return reader.ok() && !name.empty();
+}
+
+//----------------------FILES-----------------------------------------
+
+// FNV-1a : detecte une trame tronquee ou ecrite a moitie
+static uint32_t checksum(const char *data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+// Fichier entier en lecture seule ; absent ou vide : NULL et taille 0
+class MappedFile
+{
+	private:
+		void *base;
+		size_t length;
+
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+	public:
+		explicit MappedFile(const std::string& path) : base(NULL), length(0)
+		{
+			int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return;
+			struct stat info;
+			if (fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (base == MAP_FAILED)
+					base = NULL;
+				else
+					length = info.st_size;
+			}
+			::close(fd);
+		}
+		~MappedFile()
+		{
+			if (base != NULL)
+				munmap(base, length);
+		}
+		const char *data() const { return static_cast<const char*>(base); }
+		size_t size() const { return length; }
+};
+
+//----------------------STORE-----------------------------------------
+
+ChannelStore::ChannelStore() : journal_fd(-1), journal_size(0), torn(false), running(false), stopping(false)
+{
+}
+
+ChannelStore::~ChannelStore()
+{
+	close();
+}
+
+bool ChannelStore::isOpen() const
+{
+	return journal_fd >= 0;
+}
+
+bool ChannelStore::open(const std::string& path, std::vector<ChannelRecord>& records)
+{
+	snapshot_path = path + ".snap";
+	journal_path = path + ".journal";
+	if (!loadSnapshot() || !replayJournal())
+		return false;
+	journal_fd = ::open(journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (journal_fd < 0)
+	{
+		LOG_ERROR << "Cannot open channel journal " << journal_path << ": " << std::strerror(errno);
+		return false;
+	}
+	for (std::map<std::string, std::string>::const_iterator it = current.begin(); it != current.end(); ++it)
+	{
+		ChannelRecord record;
+		StateReader reader(it->second);
+		if (record.read(reader))
+			records.push_back(record);
+	}
+	if (pthread_create(&writer, NULL, writerThread, this) != 0)
+	{
+		LOG_WARN << "Failed to start channel journal thread, syncing on shutdown only";
+		return true;
+	}
+	running = true;
+	return true;
+}
+
+// Fichier mappe : aucune copie avant l'analyse
+bool ChannelStore::loadSnapshot()
+{
+	MappedFile file(snapshot_path);
+	if (file.data() == NULL)
+		return true;
+	size_t magic_size = sizeof(SNAPSHOT_MAGIC) - 1;
+	if (file.size() < magic_size + sizeof(uint32_t) || std::memcmp(file.data(), SNAPSHOT_MAGIC, magic_size) != 0)
+	{
+		LOG_ERROR << "Invalid channel snapshot " << snapshot_path;
+		return false;
+	}
+	size_t body = file.size() - sizeof(uint32_t);
+	uint32_t stored;
+	std::memcpy(&stored, file.data() + body, sizeof(stored));
+	if (stored != checksum(file.data(), body))
+	{
+		LOG_ERROR << "Corrupted channel snapshot " << snapshot_path;
+		return false;
+	}
+	StateReader reader(file.data() + magic_size, body - magic_size);
+	uint32_t count = reader.getU32();
+	for (uint32_t i = 0; i < count && reader.ok(); ++i)
+	{
+		std::string name = reader.getString();
+		current[name] = reader.getString();
+	}
+	return reader.ok();
+}
+
+// Une trame incomplete en fin de journal (arret brutal pendant l'ecriture)
+// est coupee : tout ce qui precede a ete synchronise.
+bool ChannelStore::replayJournal()
+{
+	size_t valid = 0;
+	size_t size = 0;
+	{
+		MappedFile file(journal_path);
+		if (file.data() == NULL)
+			return true;
+		size = file.size();
+		applyFrames(file.data(), size, valid);
+	}
+	if (valid < size)
+	{
+		LOG_WARN << "Channel journal truncated at byte " << valid << " of " << size;
+		if (truncate(journal_path.c_str(), valid) != 0)
+			return false;
+	}
+	journal_size = valid;
+	return true;
+}
+
+// Trame : longueur (32 bits), somme FNV-1a (32 bits), type, nom replie, corps
+bool ChannelStore::applyFrames(const char *data, size_t size, size_t& consumed)
+{
+	consumed = 0;
+	while (size - consumed >= 2 * sizeof(uint32_t))
+	{
+		uint32_t length;
+		uint32_t stored;
+		std::memcpy(&length, data + consumed, sizeof(length));
+		std::memcpy(&stored, data + consumed + sizeof(length), sizeof(stored));
+		const char *payload = data + consumed + 2 * sizeof(uint32_t);
+		if (size - consumed - 2 * sizeof(uint32_t) < length || checksum(payload, length) != stored)
+			return false;
+		StateReader reader(payload, length);
+		uint8_t type = reader.getU8();
+		std::string name = reader.getString();
+		if (!reader.ok())
+			return false;
+		if (type == RECORD_SAVE)
+			current[name].assign(payload + reader.offset(), length - reader.offset());
+		else if (type == RECORD_REMOVE)
+			current.erase(name);
+		consumed += 2 * sizeof(uint32_t) + length;
+	}
+	return consumed == size;
+}
+
+void ChannelStore::append(uint8_t type, const std::string& folded_name, const std::string& body)
+{
+	std::string payload;
+	StateWriter writer(payload);
+	writer.putU8(type);
+	writer.putString(folded_name);
+	payload += body;
+	std::string frame;
+	StateWriter header(frame);
+	header.putU32(payload.size());
+	header.putU32(checksum(payload.data(), payload.size()));
+	frame += payload;
+	ScopedLock lock(pending_lock);
+	pending += frame;
+}
+
+void ChannelStore::save(const std::string& folded_name, const ChannelRecord& record)
+{
+	if (journal_fd < 0)
+		return;
+	std::string body;
+	StateWriter writer(body);
+	record.write(writer);
+	append(RECORD_SAVE, folded_name, body);
+}
+
+uint32_t ChannelStore::fingerprint(const ChannelRecord& record)
+{
+	std::string body;
+	StateWriter writer(body);
+	record.write(writer);
+	uint32_t hash = checksum(body.data(), body.size());
+	return hash == 0 ? 1 : hash;
+}
+
+void ChannelStore::remove(const std::string& folded_name)
+{
+	if (journal_fd < 0)
+		return;
+	append(RECORD_REMOVE, folded_name, std::string());
+}
+
+//----------------------WRITER-----------------------------------------
+
+void *ChannelStore::writerThread(void *arg)
+{
+	ChannelStore *store = static_cast<ChannelStore*>(arg);
+	while (!store->stopping)
+	{
+		usleep(SYNC_INTERVAL_MS * 1000);
+		store->drain();
+	}
+	return NULL;
+}
+
+// Un lot : un write(), un fdatasync(), puis compaction si le journal a trop grossi
+void ChannelStore::drain()
+{
+	ScopedLock lock(write_lock);
+	std::string batch;
+	{
+		ScopedLock pending_guard(pending_lock);
+		batch.swap(pending);
+	}
+	if (batch.empty() || journal_fd < 0)
+		return;
+	// Apres un echec, le journal revient d'abord a sa derniere trame entiere :
+	// une trame coupee rendrait toutes les suivantes illisibles au rejeu
+	bool written = (!torn || ftruncate(journal_fd, journal_size) == 0)
+		&& writeAll(journal_fd, batch.data(), batch.size());
+	if (!written)
+	{
+		if (!torn)
+			LOG_ERROR << "Channel journal write error, retrying: " << std::strerror(errno);
+		torn = true;
+		ScopedLock pending_guard(pending_lock);
+		pending.insert(0, batch);
+		return;
+	}
+	if (torn)
+		LOG_INFO << "Channel journal writable again";
+	torn = false;
+	fdatasync(journal_fd);
+	// L'etat suivi (et donc le prochain instantane) ne contient que ce qui est ecrit
+	size_t consumed;
+	applyFrames(batch.data(), batch.size(), consumed);
+	journal_size += batch.size();
+	if (journal_size > COMPACT_BYTES)
+		compact();
+}
+
+// Nouvel instantane ecrit a cote puis renomme : un arret a tout moment laisse
+// soit l'ancien instantane et tout le journal, soit le nouveau. Rejouer le
+// journal sur le nouveau est sans effet (chaque trame porte l'etat complet).
+bool ChannelStore::compact()
+{
+	std::string image(SNAPSHOT_MAGIC);
+	StateWriter writer(image);
+	writer.putU32(current.size());
+	for (std::map<std::string, std::string>::const_iterator it = current.begin(); it != current.end(); ++it)
+	{
+		writer.putString(it->first);
+		writer.putString(it->second);
+	}
+	writer.putU32(checksum(image.data(), image.size()));
+
+	std::string temporary = snapshot_path + ".tmp";
+	int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		LOG_ERROR << "Cannot write channel snapshot " << temporary << ": " << std::strerror(errno);
+		return false;
+	}
+	bool written = writeAll(fd, image.data(), image.size()) && fsync(fd) == 0;
+	::close(fd);
+	if (!written || rename(temporary.c_str(), snapshot_path.c_str()) != 0)
+	{
+		LOG_ERROR << "Channel snapshot failed: " << std::strerror(errno);
+		unlink(temporary.c_str());
+		return false;
+	}
+	// Le rename doit etre durable avant de vider le journal
+	std::string::size_type slash = snapshot_path.rfind('/');
+	std::string directory = slash == std::string::npos ? "." : snapshot_path.substr(0, slash + 1);
+	int dir_fd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+	if (dir_fd >= 0)
+	{
+		fsync(dir_fd);
+		::close(dir_fd);
+	}
+	if (ftruncate(journal_fd, 0) == 0)
+		journal_size = 0;
+	LOG_INFO << "Channel snapshot written (" << current.size() << " channel(s), " << image.size() << " bytes)";
+	return true;
+}
+
+void ChannelStore::sync()
+{
+	drain();
+}
+
+void ChannelStore::close()
+{
+	if (running)
+	{
+		stopping = true;
+		pthread_join(writer, NULL);
+		running = false;
+		stopping = false;
+	}
+	drain();
+	{
+		ScopedLock pending_guard(pending_lock);
+		if (!pending.empty() && journal_fd >= 0)
+			LOG_ERROR << "Channel journal: " << pending.size() << " byte(s) could not be written";
+	}
+	if (journal_fd >= 0)
+	{
+		::close(journal_fd);
+		journal_fd = -1;
+	}
+}
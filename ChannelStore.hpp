@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelStore.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHANNELSTORE_HPP
+#define CHANNELSTORE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <pthread.h>
+#include <stdint.h>
+#include "Mutex.hpp"
+#include "StateCodec.hpp"
+
+// Etat durable d'un canal : tout sauf les membres, dont seuls les
+// operateurs sont retenus (pseudos replies).
+struct ChannelRecord
+{
+	std::string name;
+	unsigned int modes;
+	std::string key;
+	uint64_t limit;
+	bool has_topic;
+	std::string topic;
+	std::string topic_set_by;
+	uint64_t topic_time;
+	std::vector<std::string> invitations;
+	std::vector<std::string> operators;
+
+	ChannelRecord() : modes(0), limit(0), has_topic(false), topic_time(0) {}
+	void write(StateWriter& writer) const;
+	bool read(StateReader& reader);
+};
+
+// Persistance des canaux : un instantane <path>.snap plus un journal
+// <path>.journal ou chaque modification ajoute l'etat complet du canal
+// (ou sa suppression). Rejouer le journal sur l'instantane redonne l'etat.
+//
+// Les commandes ne font qu'ajouter l'enregistrement a un tampon sous verrou.
+// Un thread d'ecriture vide ce tampon toutes les SYNC_INTERVAL_MS, en un
+// write() et un fdatasync() par lot, et reecrit l'instantane (fichier
+// temporaire puis rename) quand le journal depasse COMPACT_BYTES.
+class ChannelStore
+{
+	public:
+		enum
+		{
+			SYNC_INTERVAL_MS = 50,
+			COMPACT_BYTES = 4 * 1024 * 1024
+		};
+
+		ChannelStore();
+		~ChannelStore();
+
+		// Charge instantane et journal, puis demarre le thread d'ecriture
+		bool open(const std::string& path, std::vector<ChannelRecord>& records);
+		bool isOpen() const;
+		void save(const std::string& folded_name, const ChannelRecord& record);
+		static uint32_t fingerprint(const ChannelRecord& record); // Jamais 0
+		void remove(const std::string& folded_name);
+		void sync(); // Ecrit et synchronise tout ce qui est en attente, dans l'appelant
+		void close();
+
+	private:
+		enum { RECORD_SAVE = 1, RECORD_REMOVE = 2 };
+
+		std::string snapshot_path;
+		std::string journal_path;
+		int journal_fd;
+		uint64_t journal_size;
+		std::map<std::string, std::string> current; // Nom replie -> enregistrement serialise
+
+		Mutex pending_lock;
+		std::string pending; // Trames a ecrire dans le journal
+		Mutex write_lock; // Un seul ecrivain : le thread ou sync()
+		bool torn; // Dernier write() en echec : journal a ramener a journal_size
+		pthread_t writer;
+		bool running;
+		volatile bool stopping;
+
+		ChannelStore(const ChannelStore&);
+		ChannelStore& operator=(const ChannelStore&);
+
+		void append(uint8_t type, const std::string& folded_name, const std::string& body);
+		bool loadSnapshot();
+		bool replayJournal();
+		bool applyFrames(const char *data, size_t size, size_t& consumed);
+		void drain();
+		bool compact();
+		static void *writerThread(void *arg);
+};
+
+#endif
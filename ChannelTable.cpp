@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelTable.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ChannelTable.hpp"
+#include "Casemap.hpp"
+
+ChannelTable::ChannelTable() : count(0) {}
+
+ChannelTable::~ChannelTable()
+{
+	for (size_t i = 0; i < channels.size(); ++i)
+		delete channels[i];
+}
+
+Channel *ChannelTable::find(const std::string& name) const
+{
+	const unsigned int *id = ids.find(ircFold(name));
+	return id ? channels[*id] : NULL;
+}
+
+Channel *ChannelTable::get(unsigned int id) const
+{
+	return id < channels.size() ? channels[id] : NULL;
+}
+
+Channel *ChannelTable::create(const std::string& name)
+{
+	unsigned int id;
+	if (!free_ids.empty())
+	{
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+	else
+	{
+		id = channels.size();
+		channels.push_back(NULL);
+	}
+	Channel *channel = new Channel(id, name);
+	channels[id] = channel;
+	ids.insert(ircFold(name), id);
+	++count;
+	return channel;
+}
+
+void ChannelTable::destroy(Channel *channel)
+{
+	unsigned int id = channel->getId();
+	ids.erase(ircFold(channel->getName()));
+	channels[id] = NULL;
+	free_ids.push_back(id);
+	--count;
+	delete channel;
+}
+
+size_t ChannelTable::size() const
+{
+	return count;
+}
+
+size_t ChannelTable::capacity() const
+{
+	return channels.size();
+}
@@ -0,0 +1,45 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ChannelTable.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHANNELTABLE_HPP
+#define CHANNELTABLE_HPP
+
+#include <vector>
+#include "Channel.hpp"
+#include "StringMap.hpp"
+
+// Registre des canaux : le nom replie (RFC 1459) est interne en un ID une
+// seule fois, l'ID indexe directement le Channel. Les ID liberes sont reutilises.
+class ChannelTable
+{
+	private:
+		StringMap<unsigned int> ids; // nom replie -> ID
+		std::vector<Channel*> channels; // ID -> canal (NULL si libre)
+		std::vector<unsigned int> free_ids;
+		size_t count;
+
+		ChannelTable(const ChannelTable&);
+		ChannelTable& operator=(const ChannelTable&);
+
+	public:
+		ChannelTable();
+		~ChannelTable();
+
+		Channel *find(const std::string& name) const;
+		Channel *get(unsigned int id) const;
+		Channel *create(const std::string& name);
+		void destroy(Channel *channel);
+		size_t size() const;
+		size_t capacity() const; // parcours : get(id) pour 0 <= id < capacity()
+};
+
+#endif
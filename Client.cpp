@@ -11,47 +11,86 @@
 /* ************************************************************************** */
 
 #include "Client.hpp"
+#include "EventLoop.hpp"
 #include <unistd.h> // close
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h> // writev
+#include <netinet/tcp.h> // TCP_CORK
+#include <algorithm>
+#include <arpa/inet.h> // inet_ntop
 
-Client::Client(int fd, const std::string& address) : fd(fd), address(address), hostname("localhost"), is_nick_set(false), is_user_set(false), registered(false), authenticated(false){}
+Client::Client(int fd, const struct in_addr& address) : fd(fd), owner(NULL), flags(0), io_flags(0), link(false), interest(EventLoop::EV_READ), caps(0), sends_inflight(0), delivery_mark(0), out_head(0), out_offset(0), out_bytes(0), address(address), last_activity_ms(0), ping_sent_ms(0), server(NULL), signon(0)
+{
+	handle.fd = fd;
+	handle.generation = 0;
+	hostname.assign("localhost", 9);
+	timer.data = this;
+}
 
 int Client::getFd() const
 {
 	return fd;
 }
 
+ClientHandle Client::getHandle() const
+{
+	return handle;
+}
+
+void Client::setHandle(ClientHandle handle)
+{
+	this->handle = handle;
+}
+
+Reactor *Client::getOwner() const
+{
+	return owner;
+}
+
+void Client::setOwner(Reactor *reactor)
+{
+	owner = reactor;
+}
+
 std::string Client::getAddress() const
+{
+	char str[INET_ADDRSTRLEN];
+	inet_ntop(AF_INET, &address, str, sizeof(str));
+	return str;
+}
+
+const struct in_addr& Client::getAddr() const
 {
 	return address;
 }
 
 bool	Client::operator==(const Client &A) const
 {
-	return (address == A.getAddress() && nickname == A.getNickname() && username == A.getUsername() && \
-		hostname == A.getHostname() && realname == A.getRealname() && is_nick_set == A.isNickSet() && \
-		is_user_set == A.isUserSet() && registered == A.isFullyRegistered());
+	return (address.s_addr == A.address.s_addr && nickname == A.nickname && username == A.username && \
+		hostname == A.hostname && realname == A.realname && flags == A.flags);
 }
 
 std::string Client::getNickname() const
 {
-	return nickname;
+	return nickname.str();
 }
 
 void Client::setNickname(const std::string& nickname)
 {
-	this->nickname = nickname;
-	is_nick_set = true;
+	this->nickname.assign(nickname);
+	flags |= NICK_SET;
 }
 
 std::string Client::getUsername() const
 {
-	return username;
+	return username.str();
 }
 
 void Client::setUsername(const std::string& username)
 {
-	this->username = username;
-	is_user_set = true;
+	this->username.assign(username);
+	flags |= USER_SET;
 }
 
 std::string Client::getRealname() const
@@ -64,57 +103,325 @@ void Client::setRealname(const std::string& realname)
 	this->realname = realname;
 }
 
-std::string	Client::getBuffer() const
-{
-	return buffer;
-}
-
-void	Client::addToBuffer(std::string const& line)
-{
-	buffer.append(line);
-}
-
-void	Client::clearBuffer()
+RecvBuffer&	Client::getRecvBuffer()
 {
-	buffer.clear();
+	return recv_buffer;
 }
 
 bool Client::isFullyRegistered() const
 {
-	return is_nick_set && is_user_set && registered;
+	return (flags & (NICK_SET | USER_SET | REGISTERED)) == (NICK_SET | USER_SET | REGISTERED);
 }
 
 bool Client::isNickSet() const
 {
-	return is_nick_set;
+	return flags & NICK_SET;
 }
 
 bool Client::isUserSet() const
 {
-	return is_user_set;
+	return flags & USER_SET;
 }
 
 void Client::setNickSet(bool value)
 {
-	is_nick_set = value;
+	setFlag(NICK_SET, value);
 }
 
 void Client::setUserSet(bool value)
 {
-	is_user_set = value;
+	setFlag(USER_SET, value);
 }
 
 void Client::setRegistered(bool set)
 {
-	registered = set;
+	setFlag(REGISTERED, set);
 }
 
 void Client::setAuthenticated(bool auth)
 {
-	authenticated = auth;
+	setFlag(AUTHENTICATED, auth);
 }
 
 bool Client::isAuthenticated() const
 {
-	return authenticated;
+	return flags & AUTHENTICATED;
+}
+
+void Client::setClosing()
+{
+	io_flags |= CLOSING;
+}
+
+bool Client::isClosing() const
+{
+	return io_flags & CLOSING;
+}
+
+void Client::queueMessage(const SharedBuffer& message)
+{
+	if (message.empty())
+		return;
+	// File videe : on repart du debut sans liberer la capacite
+	if (out_head == out_queue.size())
+	{
+		out_queue.clear();
+		out_head = 0;
+	}
+	// Client lent qui ne vide jamais sa file : on tasse les emplacements
+	// deja envoyes plutot que de laisser grandir le vecteur
+	else if (out_head >= MAX_IOV && out_head * 2 >= out_queue.size())
+	{
+		out_queue.erase(out_queue.begin(), out_queue.begin() + out_head);
+		out_head = 0;
+	}
+	out_queue.push_back(message);
+	out_bytes += message.size();
+}
+
+bool Client::hasPendingOutput() const
+{
+	return out_bytes != 0;
+}
+
+size_t Client::pendingBytes() const
+{
+	return out_bytes;
+}
+
+static void setCork(int fd, bool on)
+{
+#ifdef TCP_CORK
+	int value = on;
+	setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+#else
+	(void)fd;
+	(void)on;
+#endif
+}
+
+// Envoie autant que le socket l'accepte, toute la file en un seul writev()
+// tant qu'elle tient en MAX_IOV messages. Retourne -1 si la connexion est
+// morte, sinon le nombre d'appels systeme faits (la file peut rester non
+// vide si le socket est plein).
+int Client::flushOutput()
+{
+	int calls = 0;
+	bool corked = false;
+	while (out_head < out_queue.size())
+	{
+		struct iovec iov[MAX_IOV];
+		size_t count = 0;
+		size_t requested = 0;
+		for (size_t i = out_head; i < out_queue.size() && count < MAX_IOV; ++i, ++count)
+		{
+			size_t skip = count == 0 ? out_offset : 0;
+			iov[count].iov_base = const_cast<char*>(out_queue[i].data()) + skip;
+			iov[count].iov_len = out_queue[i].size() - skip;
+			requested += iov[count].iov_len;
+		}
+		// Plusieurs writev() d'affilee : le cork evite d'emettre un segment
+		// partiel entre deux appels
+		if (!corked && out_queue.size() - out_head > MAX_IOV)
+		{
+			setCork(fd, true);
+			corked = true;
+		}
+		ssize_t sent = writev(fd, iov, count);
+		++calls;
+		if (sent < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			return -1;
+		}
+		consumeOutput(sent);
+		// Ecriture partielle : le tampon du socket est plein, inutile d'insister
+		if (static_cast<size_t>(sent) < requested)
+			break;
+	}
+	if (corked)
+		setCork(fd, false);
+	return calls;
+}
+
+void Client::consumeOutput(size_t sent)
+{
+	out_bytes -= sent;
+	while (sent > 0)
+	{
+		size_t remaining = out_queue[out_head].size() - out_offset;
+		if (sent < remaining)
+		{
+			out_offset += sent;
+			break;
+		}
+		sent -= remaining;
+		out_queue[out_head++] = SharedBuffer(); // rend la reference tout de suite
+		out_offset = 0;
+	}
+	if (out_head == out_queue.size())
+	{
+		out_queue.clear();
+		out_head = 0;
+	}
+}
+
+// Backend a completion : la file part en une chaine d'envois lies, soumise
+// avec l'attente du tour suivant. Les messages restent dans la file (donc en
+// memoire) jusqu'a la completion ; rien n'est resoumis entre-temps.
+int Client::submitOutput(EventLoop *loop)
+{
+	if (sends_inflight > 0 || out_head == out_queue.size())
+		return 0;
+	struct iovec iov[MAX_CHAIN_IOV];
+	size_t count = 0;
+	for (size_t i = out_head; i < out_queue.size() && count < MAX_CHAIN_IOV; ++i, ++count)
+	{
+		size_t skip = count == 0 ? out_offset : 0;
+		iov[count].iov_base = const_cast<char*>(out_queue[i].data()) + skip;
+		iov[count].iov_len = out_queue[i].size() - skip;
+	}
+	int links = loop->queueSend(fd, iov, count);
+	if (links < 0)
+		return errno == EAGAIN ? 0 : -1;
+	sends_inflight = links;
+	return links;
+}
+
+// Completion d'un maillon : octets envoyes, ou -errno. Un maillon annule ou
+// refuse faute de place n'a rien envoye ; faux si la connexion est perdue.
+bool Client::completeOutput(int result)
+{
+	if (sends_inflight > 0)
+		--sends_inflight;
+	if (result > 0)
+		consumeOutput(result);
+	return result >= 0 || result == -EAGAIN || result == -ECANCELED || result == -EINTR;
+}
+
+bool Client::isSending() const
+{
+	return sends_inflight > 0;
+}
+
+// Octets encore a envoyer, a la suite (passage de relais)
+void Client::copyPendingOutput(std::string& out) const
+{
+	for (size_t i = out_head; i < out_queue.size(); ++i)
+	{
+		size_t skip = i == out_head ? out_offset : 0;
+		out.append(out_queue[i].data() + skip, out_queue[i].size() - skip);
+	}
+}
+
+int Client::getInterest() const
+{
+	return interest;
+}
+
+void Client::setInterest(int events)
+{
+	interest = events;
+}
+
+bool Client::isReadPaused() const
+{
+	return io_flags & READ_PAUSED;
+}
+
+void Client::setReadPaused(bool paused)
+{
+	setIoFlag(READ_PAUSED, paused);
+}
+
+bool Client::isBacklogged() const
+{
+	return io_flags & BACKLOGGED;
+}
+
+void Client::setBacklogged(bool value)
+{
+	setIoFlag(BACKLOGGED, value);
+}
+
+bool Client::hasCap(Capability cap) const
+{
+	return caps & cap;
+}
+
+unsigned int Client::getCaps() const
+{
+	return caps;
+}
+
+void Client::setCaps(unsigned int value)
+{
+	caps = static_cast<unsigned char>(value);
+}
+
+// Vrai au premier passage pour cet envoi, faux si le client l'a deja recu
+bool Client::markDelivered(unsigned int mark)
+{
+	if (delivery_mark == mark)
+		return false;
+	delivery_mark = mark;
+	return true;
+}
+
+TokenBucket& Client::getBucket()
+{
+	return bucket;
+}
+
+Timer& Client::getTimer()
+{
+	return timer;
+}
+
+// Toute ligne recue prouve que la connexion est vivante
+void Client::touch(uint64_t now_ms)
+{
+	last_activity_ms = now_ms;
+	ping_sent_ms = 0;
+}
+
+uint64_t Client::getLastActivity() const
+{
+	return last_activity_ms;
+}
+
+uint64_t Client::getPingSent() const
+{
+	return ping_sent_ms;
+}
+
+void Client::setPingSent(uint64_t now_ms)
+{
+	ping_sent_ms = now_ms;
+}
+
+const std::vector<unsigned int>& Client::getChannels() const
+{
+	return channel_ids;
+}
+
+bool Client::isInChannel(unsigned int channel_id) const
+{
+	return std::find(channel_ids.begin(), channel_ids.end(), channel_id) != channel_ids.end();
+}
+
+void Client::joinChannel(unsigned int channel_id)
+{
+	if (!isInChannel(channel_id))
+		channel_ids.push_back(channel_id);
+}
+
+void Client::leaveChannel(unsigned int channel_id)
+{
+	std::vector<unsigned int>::iterator it = std::find(channel_ids.begin(), channel_ids.end(), channel_id);
+	if (it != channel_ids.end())
+		channel_ids.erase(it);
 }
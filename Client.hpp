@@ -14,39 +14,128 @@
 #define CLIENT_HPP
 
 #include <string>
+#include <vector>
+#include <ctime>
 #include <netinet/in.h>
+#include "SharedBuffer.hpp"
+#include "FixedString.hpp"
+#include "RecvBuffer.hpp"
+#include "TokenBucket.hpp"
+#include "TimerWheel.hpp"
+
+class EventLoop;
+
+class Reactor;
+struct LinkedServer;
+
+// Reference stable vers un client : reste valide tant que la connexion existe,
+// et ne designe jamais une autre connexion qui reutiliserait le meme fd.
+struct ClientHandle
+{
+	int				fd;
+	unsigned int	generation;
+};
 
 class Client
 {
+	public:
+		// Limites du protocole, stockage en place dans l'objet
+		enum
+		{
+			NICKLEN = 30,
+			USERLEN = 18,
+			HOSTLEN = 63
+		};
+		// Capacites IRCv3 activees par CAP REQ
+		enum Capability
+		{
+			CAP_BATCH = 1 << 0,
+			CAP_CHATHISTORY = 1 << 1,
+			CAP_MESSAGE_TAGS = 1 << 2,
+			CAP_SERVER_TIME = 1 << 3
+		};
+
 	private:
+		enum { MAX_IOV = 64 }; // Messages envoyes par writev()
+		enum { MAX_CHAIN_IOV = 256 }; // Messages d'une chaine d'envois (io_uring)
+		enum // Bits de `flags`
+		{
+			NICK_SET = 1 << 0,
+			USER_SET = 1 << 1,
+			REGISTERED = 1 << 2,
+			AUTHENTICATED = 1 << 3
+		};
+		enum // Bits de `io_flags`
+		{
+			CLOSING = 1 << 0,
+			READ_PAUSED = 1 << 1, // Seau vide, les donnees attendent dans le noyau
+			BACKLOGGED = 1 << 2 // Dans la liste d'attente de son reacteur
+		};
+
+		// Champs lus a chaque diffusion regroupes en tete de l'objet
 		int fd;
-		std::string address;
-		std::string nickname;
-		std::string username;
-		std::string hostname;
-		std::string realname;
-		std::string buffer;
-		bool is_nick_set;
-		bool is_user_set;
-		bool registered;
-		bool authenticated;
+		ClientHandle handle;
+		Reactor *owner; // Seul ce reacteur touche au socket et aux tampons
+		unsigned char flags; // Etat d'enregistrement, modifie sous state_lock exclusif
+		unsigned char io_flags; // Etat du socket : reacteur proprietaire seul, sans verrou
+		bool link; // Liaison avec un autre serveur : pose une fois, sous le verrou, par le proprietaire
+		unsigned char interest; // Evenements enregistres dans la boucle (EV_READ/EV_WRITE)
+		unsigned char caps; // Capability activees
+		unsigned char sends_inflight; // Envois soumis sans completion (io_uring)
+		unsigned int delivery_mark; // Dernier envoi multi-cibles recu (dedoublonnage)
+		std::vector<SharedBuffer> out_queue; // Messages en attente d'envoi (partages)
+		size_t out_head; // Premier message non envoye de out_queue
+		size_t out_offset; // Octets deja envoyes de ce message
+		size_t out_bytes; // Total en attente
+		FixedString<NICKLEN> nickname;
+		FixedString<USERLEN> username;
+		struct in_addr address; // Adresse du pair, formatee a la demande
+		TokenBucket bucket; // Controle de flood
+		uint64_t last_activity_ms; // Derniere ligne recue
+		uint64_t ping_sent_ms; // PING serveur sans reponse depuis (0 : aucun)
+		Timer timer; // Delai d'enregistrement puis keepalive, dans la roue du reacteur
+		std::vector<unsigned int> channel_ids; // Canaux rejoints (ID internes)
+		FixedString<HOSTLEN> hostname;
+		std::string realname; // Libre et rarement lu : seul champ alloue
+		LinkedServer *server; // Serveur d'origine (utilisateur distant) ou voisin (liaison)
+		time_t signon; // Date d'enregistrement, arbitre les collisions de pseudos
+		RecvBuffer recv_buffer; // Lignes recues, incompletes comprises (en dernier : le plus gros)
+
+		void consumeOutput(size_t sent);
+		void setFlag(int flag, bool value)
+		{
+			if (value)
+				flags |= flag;
+			else
+				flags &= ~flag;
+		}
+		void setIoFlag(int flag, bool value)
+		{
+			if (value)
+				io_flags |= flag;
+			else
+				io_flags &= ~flag;
+		}
 
 	public:
-		Client(int fd, const std::string& address);
+		Client(int fd, const struct in_addr& address);
 		bool	operator==(const Client &A) const;
 		int getFd() const;
+		ClientHandle getHandle() const;
+		void setHandle(ClientHandle handle);
+		Reactor *getOwner() const;
+		void setOwner(Reactor *reactor);
 		std::string getAddress() const;
+		const struct in_addr& getAddr() const;
 		std::string getNickname() const;
 		void setNickname(const std::string& nickname);
 		std::string getUsername() const;
 		void setUsername(const std::string& username);
 		std::string getRealname() const;
 		void setRealname(const std::string& realname);
-		void setHostname(const std::string& host) { hostname = host; }
-		std::string getHostname() const { return hostname; }
-		std::string	getBuffer() const;
-		void	addToBuffer(std::string const& line);
-		void	clearBuffer();
+		void setHostname(const std::string& host) { hostname.assign(host); }
+		std::string getHostname() const { return hostname.str(); }
+		RecvBuffer&	getRecvBuffer();
 		bool isFullyRegistered() const;
 		bool isNickSet() const;
 		bool isUserSet() const;
@@ -55,6 +144,45 @@ class Client
 		void setRegistered(bool set);
 		void setAuthenticated(bool auth);
 		bool isAuthenticated() const;
+		void setClosing();
+		bool isClosing() const;
+		void queueMessage(const SharedBuffer& message);
+		bool hasPendingOutput() const;
+		size_t pendingBytes() const;
+		int flushOutput();
+		int submitOutput(EventLoop *loop);
+		bool completeOutput(int result);
+		bool isSending() const;
+		void copyPendingOutput(std::string& out) const;
+		int getInterest() const;
+		void setInterest(int events);
+		bool isReadPaused() const;
+		void setReadPaused(bool paused);
+		bool isBacklogged() const;
+		void setBacklogged(bool value);
+		bool markDelivered(unsigned int mark);
+		bool hasCap(Capability cap) const;
+		unsigned int getCaps() const;
+		void setCaps(unsigned int caps);
+		TokenBucket& getBucket();
+		Timer& getTimer();
+		void touch(uint64_t now_ms);
+		uint64_t getLastActivity() const;
+		uint64_t getPingSent() const;
+		void setPingSent(uint64_t now_ms);
+		const std::vector<unsigned int>& getChannels() const;
+		bool isInChannel(unsigned int channel_id) const;
+		void joinChannel(unsigned int channel_id);
+		void leaveChannel(unsigned int channel_id);
+		bool isLink() const { return link; }
+		void setLink() { link = true; }
+		// Utilisateur d'un autre serveur : ni socket ni reacteur, ses messages
+		// partent par la liaison qui mene a son serveur
+		bool isRemote() const { return server != NULL && !link; }
+		LinkedServer *getServer() const { return server; }
+		void setServer(LinkedServer *server) { this->server = server; }
+		time_t getSignon() const { return signon; }
+		void setSignon(time_t when) { signon = when; }
 };
 
 #endif
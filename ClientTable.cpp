@@ -0,0 +1,83 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ClientTable.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ClientTable.hpp"
+
+ClientHandle ClientTable::insert(Client *client)
+{
+	int fd = client->getFd();
+	if (static_cast<size_t>(fd) >= slots.size())
+	{
+		Slot empty;
+		empty.client = NULL;
+		empty.generation = 0;
+		empty.dense_index = 0;
+		slots.resize(fd + 1, empty);
+	}
+	Slot& slot = slots[fd];
+	slot.client = client;
+	slot.dense_index = dense.size();
+	dense.push_back(client);
+
+	ClientHandle handle;
+	handle.fd = fd;
+	handle.generation = slot.generation;
+	client->setHandle(handle);
+	return handle;
+}
+
+void ClientTable::remove(Client *client)
+{
+	int fd = client->getFd();
+	if (fd < 0 || static_cast<size_t>(fd) >= slots.size() || slots[fd].client != client)
+		return;
+	Slot& slot = slots[fd];
+	// On comble le trou avec le dernier client actif
+	Client *last = dense.back();
+	dense[slot.dense_index] = last;
+	slots[last->getFd()].dense_index = slot.dense_index;
+	dense.pop_back();
+	slot.client = NULL;
+	++slot.generation;
+}
+
+Client *ClientTable::get(ClientHandle handle) const
+{
+	if (handle.fd < 0 || static_cast<size_t>(handle.fd) >= slots.size())
+		return NULL;
+	const Slot& slot = slots[handle.fd];
+	if (slot.generation != handle.generation)
+		return NULL;
+	return slot.client;
+}
+
+Client *ClientTable::getByFd(int fd) const
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= slots.size())
+		return NULL;
+	return slots[fd].client;
+}
+
+size_t ClientTable::size() const
+{
+	return dense.size();
+}
+
+Client *ClientTable::at(size_t i) const
+{
+	return dense[i];
+}
+
+size_t ClientTable::indexOf(Client *client) const
+{
+	return slots[client->getFd()].dense_index;
+}
@@ -0,0 +1,46 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ClientTable.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CLIENTTABLE_HPP
+#define CLIENTTABLE_HPP
+
+#include <vector>
+#include "Client.hpp"
+
+// Table des clients indexee par fd. Chaque slot porte un compteur de
+// generation incremente a la liberation : un ClientHandle perime (fd reutilise
+// par une nouvelle connexion) ne resout plus vers aucun client.
+// Insertion, recherche et retrait sont en O(1) ; `dense` permet de parcourir
+// les clients actifs sans scanner les slots vides.
+class ClientTable
+{
+	private:
+		struct Slot
+		{
+			Client			*client;
+			unsigned int	generation;
+			size_t			dense_index;
+		};
+		std::vector<Slot> slots;
+		std::vector<Client*> dense;
+
+	public:
+		ClientHandle insert(Client *client);
+		void remove(Client *client);
+		Client *get(ClientHandle handle) const;
+		Client *getByFd(int fd) const;
+		size_t size() const;
+		Client *at(size_t i) const; // parcours : 0 <= i < size()
+		size_t indexOf(Client *client) const; // position de at() pour un client present
+};
+
+#endif
@@ -0,0 +1,285 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Config.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Config.hpp"
+#include <iostream>
+#include <cstdlib>
+
+static bool parseSize(const std::string& value, size_t& out)
+{
+	if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	out = std::strtoul(value.c_str(), NULL, 10);
+	return true;
+}
+
+Config::Config()
+#ifdef __linux__
+	: backend("epoll"),
+#else
+	: backend("poll"),
+#endif
+	sendq(512 * 1024),
+	threads(1),
+	log_level(Logger::LEVEL_INFO),
+	stats("auto"),
+	flood_rate(10),
+	flood_burst(20),
+	listen_backlog(4096),
+	accept_batch(64),
+	ip_max_connections(16),
+	ip_connect_rate(2),
+	ip_connect_burst(10),
+	ip_cidr(32),
+	read_budget(8192),
+	registration_timeout(30),
+	ping_interval(120),
+	ping_timeout(60),
+	history_lines(100),
+	history_memory(4 * 1024 * 1024),
+	targmax(20),
+	channel_store("off"),
+	link_retry(10)
+{
+	// Bouncers et outils de charge locaux : jamais limites par defaut
+	Cidr::parseList("127.0.0.0/8", ip_exempt);
+}
+
+bool Config::parse(const std::string& option)
+{
+	std::string::size_type eq = option.find('=');
+	if (eq == std::string::npos)
+	{
+		std::cerr << "Invalid option (expected key=value): " << option << std::endl;
+		return false;
+	}
+	std::string key = option.substr(0, eq);
+	std::string value = option.substr(eq + 1);
+
+	if (key == "backend")
+	{
+		if (value != "io_uring" && value != "epoll" && value != "poll")
+		{
+			std::cerr << "Unknown backend: " << value << std::endl;
+			return false;
+		}
+		backend = value;
+		return true;
+	}
+	if (key == "sendq")
+	{
+		if (!parseSize(value, sendq) || sendq == 0)
+		{
+			std::cerr << "Invalid sendq: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "threads")
+	{
+		if (!parseSize(value, threads) || threads == 0 || threads > 256)
+		{
+			std::cerr << "Invalid threads: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "loglevel")
+	{
+		if (!Logger::parseLevel(value, log_level))
+		{
+			std::cerr << "Invalid loglevel: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "stats")
+	{
+		if (value.empty())
+		{
+			std::cerr << "Invalid stats path" << std::endl;
+			return false;
+		}
+		stats = value;
+		return true;
+	}
+	if (key == "channel_store")
+	{
+		if (value.empty())
+		{
+			std::cerr << "Invalid channel_store path" << std::endl;
+			return false;
+		}
+		channel_store = value;
+		return true;
+	}
+	if (key == "flood_rate" || key == "flood_burst" || key == "read_budget")
+	{
+		size_t& target = key == "flood_rate" ? flood_rate : key == "flood_burst" ? flood_burst : read_budget;
+		if (!parseSize(value, target) || (target == 0 && key != "flood_rate") || target > 1000000)
+		{
+			std::cerr << "Invalid " << key << ": " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "listen_backlog" || key == "accept_batch")
+	{
+		size_t& target = key == "listen_backlog" ? listen_backlog : accept_batch;
+		if (!parseSize(value, target) || target == 0 || target > 65535)
+		{
+			std::cerr << "Invalid " << key << ": " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "ip_max_connections" || key == "ip_connect_rate" || key == "ip_connect_burst")
+	{
+		size_t& target = key == "ip_max_connections" ? ip_max_connections
+			: key == "ip_connect_rate" ? ip_connect_rate : ip_connect_burst;
+		if (!parseSize(value, target) || (target == 0 && key == "ip_connect_burst") || target > 1000000)
+		{
+			std::cerr << "Invalid " << key << ": " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "ip_cidr")
+	{
+		if (!parseSize(value, ip_cidr) || ip_cidr < 8 || ip_cidr > 32)
+		{
+			std::cerr << "Invalid ip_cidr: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "ip_exempt")
+	{
+		if (!Cidr::parseList(value, ip_exempt))
+		{
+			std::cerr << "Invalid ip_exempt: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "registration_timeout" || key == "ping_interval" || key == "ping_timeout")
+	{
+		size_t& target = key == "registration_timeout" ? registration_timeout
+			: key == "ping_interval" ? ping_interval : ping_timeout;
+		if (!parseSize(value, target) || target == 0 || target > 86400)
+		{
+			std::cerr << "Invalid " << key << ": " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "history_lines")
+	{
+		if (!parseSize(value, history_lines) || history_lines > 10000)
+		{
+			std::cerr << "Invalid history_lines: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "history_memory")
+	{
+		// Une ligne etiquetee doit toujours tenir dans l'arene
+		if (!parseSize(value, history_memory) || history_memory < 64 * 1024 || history_memory > 1024 * 1024 * 1024)
+		{
+			std::cerr << "Invalid history_memory: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "targmax")
+	{
+		if (!parseSize(value, targmax) || targmax == 0 || targmax > 512)
+		{
+			std::cerr << "Invalid targmax: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "server_name")
+	{
+		if (!Network::isValidName(value))
+		{
+			std::cerr << "Invalid server_name (expected a host-like name with a dot): " << value << std::endl;
+			return false;
+		}
+		server_name = value;
+		return true;
+	}
+	if (key == "link_password")
+	{
+		if (value.empty() || value.find_first_of(" \r\n") != std::string::npos)
+		{
+			std::cerr << "Invalid link_password" << std::endl;
+			return false;
+		}
+		link_password = value;
+		return true;
+	}
+	if (key == "link_connect")
+	{
+		if (!LinkPeer::parseList(value, link_connect))
+		{
+			std::cerr << "Invalid link_connect: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	if (key == "link_retry")
+	{
+		if (!parseSize(value, link_retry) || link_retry == 0 || link_retry > 86400)
+		{
+			std::cerr << "Invalid link_retry: " << value << std::endl;
+			return false;
+		}
+		return true;
+	}
+	std::cerr << "Unknown option: " << key << std::endl;
+	return false;
+}
+
+void Config::printUsage(const char *prog)
+{
+	std::cerr << "Usage: " << prog << " <port> <password> [key=value ...]" << std::endl;
+	std::cerr << "Options:" << std::endl;
+	std::cerr << "  backend=io_uring|epoll|poll  event loop backend (unavailable ones fall back)" << std::endl;
+	std::cerr << "  sendq=<bytes>           max queued output per client (default 524288)" << std::endl;
+	std::cerr << "  threads=<n>             reactor threads, SO_REUSEPORT listeners (default 1)" << std::endl;
+	std::cerr << "  loglevel=debug|info|warn|error  (default info; debug needs make debug)" << std::endl;
+	std::cerr << "  stats=auto|off|<path>   shared stats segment for ircstat (auto: /tmp/ircserv-<port>.stats)" << std::endl;
+	std::cerr << "  flood_rate=<n>          command tokens per second per client, 0 = off (default 10)" << std::endl;
+	std::cerr << "  flood_burst=<n>         token bucket size (default 20)" << std::endl;
+	std::cerr << "  read_budget=<bytes>     bytes read per client per loop iteration (default 8192)" << std::endl;
+	std::cerr << "  listen_backlog=<n>      kernel accept queue length, capped by somaxconn (default 4096)" << std::endl;
+	std::cerr << "  accept_batch=<n>        connections accepted per loop iteration (default 64)" << std::endl;
+	std::cerr << "  ip_max_connections=<n>  concurrent connections per source prefix, 0 = off (default 16)" << std::endl;
+	std::cerr << "  ip_connect_rate=<n>     connections per second per source prefix, 0 = off (default 2)" << std::endl;
+	std::cerr << "  ip_connect_burst=<n>    connection bucket size (default 10)" << std::endl;
+	std::cerr << "  ip_cidr=<8-32>          prefix length grouping source addresses (default 32)" << std::endl;
+	std::cerr << "  ip_exempt=none|<cidr,...> sources never limited (default 127.0.0.0/8)" << std::endl;
+	std::cerr << "  registration_timeout=<s> time allowed to register (default 30)" << std::endl;
+	std::cerr << "  ping_interval=<s>       idle time before the server sends PING (default 120)" << std::endl;
+	std::cerr << "  ping_timeout=<s>        time allowed to answer that PING (default 60)" << std::endl;
+	std::cerr << "  history_lines=<n>       lines kept per channel for CHATHISTORY, 0 = off (default 100)" << std::endl;
+	std::cerr << "  history_memory=<bytes>  shared history arena, oldest lines evicted first (default 4194304)" << std::endl;
+	std::cerr << "  targmax=<n>             targets per JOIN/PART/PRIVMSG/NOTICE/KICK (default 20)" << std::endl;
+	std::cerr << "  channel_store=off|<path> persist channels in <path>.snap and <path>.journal (default off)" << std::endl;
+	std::cerr << "  server_name=<name>      name on the network, must contain a dot (default irc-<port>.local)" << std::endl;
+	std::cerr << "  link_password=<secret>  shared secret of server links; unset = links refused" << std::endl;
+	std::cerr << "  link_connect=<ip:port,...> servers to link to, set on one side of each link only" << std::endl;
+	std::cerr << "  link_retry=<s>          delay between two attempts to reach a server (default 10)" << std::endl;
+}
@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Config.hpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "ConnectionLimiter.hpp"
+#include "Network.hpp"
+
+// Options de demarrage, passees en "cle=valeur" apres <port> <password>.
+class Config
+{
+	public:
+		Config();
+		bool parse(const std::string& option);
+		static void printUsage(const char *prog);
+
+		std::string backend; // "io_uring", "epoll" (defaut sous Linux) ou "poll"
+		size_t sendq; // Octets en attente max par client avant deconnexion
+		size_t threads; // Nombre de reacteurs (un thread et un socket d'ecoute chacun)
+		Logger::Level log_level;
+		std::string stats; // Segment de statistiques : "auto", "off" ou un chemin
+		size_t flood_rate; // Jetons rendus par seconde a chaque client (0 : pas de limite)
+		size_t flood_burst; // Capacite du seau
+		size_t listen_backlog; // File d'acceptation du noyau (plafonnee par net.core.somaxconn)
+		size_t accept_batch; // Connexions acceptees au plus par tour de boucle
+		size_t ip_max_connections; // Connexions simultanees par prefixe source (0 : pas de limite)
+		size_t ip_connect_rate; // Connexions par seconde et par prefixe (0 : pas de limite)
+		size_t ip_connect_burst;
+		size_t ip_cidr; // Longueur du prefixe qui regroupe les adresses
+		std::vector<Cidr> ip_exempt; // Sources jamais limitees
+		size_t read_budget; // Octets lus par client et par tour de boucle
+		size_t registration_timeout; // Secondes pour terminer PASS/NICK/USER
+		size_t ping_interval; // Secondes de silence avant un PING serveur
+		size_t ping_timeout; // Secondes pour repondre a ce PING
+		size_t history_lines; // Lignes gardees par canal pour CHATHISTORY (0 : desactive)
+		size_t history_memory; // Taille de l'arene commune a tous les historiques
+		size_t targmax; // Cibles max par JOIN/PART/PRIVMSG/NOTICE/KICK, annonce dans 005
+		std::string channel_store; // Prefixe des fichiers .snap/.journal des canaux, "off" sinon
+		std::string server_name; // Nom sur le reseau (vide : irc-<port>.local)
+		std::string link_password; // Secret partage des liaisons entre serveurs (vide : refusees)
+		std::vector<LinkPeer> link_connect; // Serveurs a joindre nous-memes
+		size_t link_retry; // Secondes entre deux tentatives vers un meme pair
+};
+
+#endif
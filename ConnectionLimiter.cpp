@@ -0,0 +1,184 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ConnectionLimiter.cpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "ConnectionLimiter.hpp"
+#include <cstdlib>
+#include <arpa/inet.h>
+
+//----------------------CIDR-----------------------------------------
+
+bool Cidr::parse(const std::string& text, Cidr& out)
+{
+	std::string::size_type slash = text.find('/');
+	std::string address = text.substr(0, slash);
+	unsigned long prefix = 32;
+	if (slash != std::string::npos)
+	{
+		std::string bits = text.substr(slash + 1);
+		if (bits.empty() || bits.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+		prefix = std::strtoul(bits.c_str(), NULL, 10);
+		if (prefix > 32)
+			return false;
+	}
+	struct in_addr parsed;
+	if (inet_pton(AF_INET, address.c_str(), &parsed) != 1)
+		return false;
+	out.mask = prefix == 0 ? 0 : ~static_cast<uint32_t>(0) << (32 - prefix);
+	out.network = ntohl(parsed.s_addr) & out.mask;
+	return true;
+}
+
+bool Cidr::parseList(const std::string& text, std::vector<Cidr>& out)
+{
+	out.clear();
+	if (text == "none")
+		return true;
+	std::string::size_type begin = 0;
+	while (begin <= text.size())
+	{
+		std::string::size_type comma = text.find(',', begin);
+		if (comma == std::string::npos)
+			comma = text.size();
+		Cidr cidr;
+		if (!parse(text.substr(begin, comma - begin), cidr))
+			return false;
+		out.push_back(cidr);
+		begin = comma + 1;
+	}
+	return true;
+}
+
+//----------------------LIMITER-----------------------------------------
+
+ConnectionLimiter::ConnectionLimiter() : count(0), max_connections(0), rate(0), burst(0), mask(~static_cast<uint32_t>(0)) {}
+
+void ConnectionLimiter::configure(size_t max_connections, long rate, long burst, unsigned int prefix, const std::vector<Cidr>& exempt)
+{
+	ScopedLock guard(lock);
+	this->max_connections = max_connections;
+	this->rate = rate;
+	this->burst = burst;
+	this->mask = prefix == 0 ? 0 : ~static_cast<uint32_t>(0) << (32 - prefix);
+	this->exempt = exempt;
+	slots.assign(INITIAL_CAPACITY, Entry());
+	count = 0;
+}
+
+bool ConnectionLimiter::isExempt(uint32_t address) const
+{
+	for (size_t i = 0; i < exempt.size(); ++i)
+		if (exempt[i].contains(address))
+			return true;
+	return false;
+}
+
+// Melange de Knuth : les prefixes voisins ne tombent pas dans des cases voisines
+static size_t slotOf(uint32_t key, size_t capacity)
+{
+	return (key * 2654435761u) & (capacity - 1);
+}
+
+ConnectionLimiter::Entry *ConnectionLimiter::find(uint32_t key)
+{
+	for (size_t i = slotOf(key, slots.size()); ; i = (i + 1) & (slots.size() - 1))
+	{
+		if (slots[i].key == key)
+			return &slots[i];
+		if (slots[i].key == 0)
+			return NULL;
+	}
+}
+
+ConnectionLimiter::Entry *ConnectionLimiter::insert(uint32_t key, uint64_t now_ms)
+{
+	if ((count + 1) * 2 > slots.size())
+	{
+		// Oublier d'abord les entrees inutiles ; ne grandir que si cela ne suffit pas
+		rebuild(slots.size(), now_ms);
+		if ((count + 1) * 2 > slots.size())
+			rebuild(slots.size() * 2, now_ms);
+	}
+	size_t i = slotOf(key, slots.size());
+	while (slots[i].key != 0)
+		i = (i + 1) & (slots.size() - 1);
+	slots[i].key = key;
+	slots[i].connections = 0;
+	slots[i].bucket.reset(now_ms, burst);
+	++count;
+	return &slots[i];
+}
+
+// Reinsere les entrees encore utiles ; pas de marque de suppression a gerer
+void ConnectionLimiter::rebuild(size_t capacity, uint64_t now_ms)
+{
+	std::vector<Entry> old(capacity, Entry());
+	old.swap(slots);
+	count = 0;
+	for (size_t i = 0; i < old.size(); ++i)
+	{
+		Entry& entry = old[i];
+		if (entry.key == 0 || (entry.connections == 0 && entry.bucket.isFull(now_ms, rate, burst)))
+			continue;
+		size_t j = slotOf(entry.key, slots.size());
+		while (slots[j].key != 0)
+			j = (j + 1) & (slots.size() - 1);
+		slots[j] = entry;
+		++count;
+	}
+}
+
+ConnectionLimiter::Verdict ConnectionLimiter::admit(const struct in_addr& address, uint64_t now_ms)
+{
+	uint32_t host = ntohl(address.s_addr);
+	if ((max_connections == 0 && rate == 0) || isExempt(host))
+		return ACCEPT;
+	uint32_t key = host & mask;
+	if (key == 0)
+		return ACCEPT;
+	ScopedLock guard(lock);
+	Entry *entry = find(key);
+	if (entry == NULL)
+		entry = insert(key, now_ms);
+	// Chaque tentative coute un jeton, refusee ou non : insister ne paie pas
+	bool in_budget = entry->bucket.ready(now_ms, rate, burst);
+	entry->bucket.consume(1);
+	if (!in_budget)
+		return TOO_FAST;
+	if (max_connections != 0 && entry->connections >= max_connections)
+		return TOO_MANY;
+	++entry->connections;
+	return ACCEPT;
+}
+
+void ConnectionLimiter::restore(const struct in_addr& address, uint64_t now_ms)
+{
+	uint32_t host = ntohl(address.s_addr);
+	if ((max_connections == 0 && rate == 0) || isExempt(host) || (host & mask) == 0)
+		return;
+	ScopedLock guard(lock);
+	Entry *entry = find(host & mask);
+	if (entry == NULL)
+		entry = insert(host & mask, now_ms);
+	++entry->connections;
+}
+
+void ConnectionLimiter::release(const struct in_addr& address)
+{
+	uint32_t host = ntohl(address.s_addr);
+	if ((max_connections == 0 && rate == 0) || isExempt(host) || (host & mask) == 0)
+		return;
+	ScopedLock guard(lock);
+	Entry *entry = find(host & mask);
+	if (entry != NULL && entry->connections > 0)
+		--entry->connections;
+}
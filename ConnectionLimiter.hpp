@@ -0,0 +1,85 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ConnectionLimiter.hpp                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CONNECTIONLIMITER_HPP
+#define CONNECTIONLIMITER_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <netinet/in.h>
+#include "Mutex.hpp"
+#include "TokenBucket.hpp"
+
+// Reseau au format a.b.c.d/n, en ordre d'hote
+struct Cidr
+{
+	uint32_t network;
+	uint32_t mask;
+
+	bool contains(uint32_t address) const { return (address & mask) == network; }
+	static bool parse(const std::string& text, Cidr& out);
+	static bool parseList(const std::string& text, std::vector<Cidr>& out); // "a/n,b/n" ou "none"
+};
+
+// Admission des connexions par adresse source, consultee juste apres
+// accept() : une connexion refusee ne coute ni Client ni place dans la
+// boucle. Les adresses sont regroupees par prefixe (ip_cidr) dans une table
+// a adressage ouvert d'entrees de 24 octets ; chaque entree compte ses
+// connexions ouvertes et porte un seau de connexions par seconde. Une entree
+// sans connexion dont le seau est plein n'apprend plus rien : elle est
+// oubliee au prochain nettoyage, fait avant tout agrandissement.
+//
+// Partagee par tous les reacteurs (SO_REUSEPORT repartit une meme adresse
+// entre eux), sous son propre verrou, jamais sous state_lock.
+class ConnectionLimiter
+{
+	public:
+		enum Verdict { ACCEPT, TOO_MANY, TOO_FAST };
+
+		ConnectionLimiter();
+
+		void configure(size_t max_connections, long rate, long burst, unsigned int prefix, const std::vector<Cidr>& exempt);
+		Verdict admit(const struct in_addr& address, uint64_t now_ms);
+		void restore(const struct in_addr& address, uint64_t now_ms); // Connexion reprise d'un relais : comptee sans controle
+		void release(const struct in_addr& address);
+
+	private:
+		enum { INITIAL_CAPACITY = 256 };
+
+		// key 0 marque une case vide : 0.0.0.0/8 n'est jamais une source
+		struct Entry
+		{
+			uint32_t key;
+			uint32_t connections;
+			TokenBucket bucket;
+		};
+
+		std::vector<Entry> slots; // Taille puissance de 2, remplie a moitie au plus
+		size_t count;
+		size_t max_connections; // 0 : pas de limite
+		long rate; // Connexions par seconde et par prefixe, 0 : pas de limite
+		long burst;
+		uint32_t mask;
+		std::vector<Cidr> exempt;
+		Mutex lock;
+
+		ConnectionLimiter(const ConnectionLimiter&);
+		ConnectionLimiter& operator=(const ConnectionLimiter&);
+
+		bool isExempt(uint32_t address) const;
+		Entry *find(uint32_t key);
+		Entry *insert(uint32_t key, uint64_t now_ms);
+		void rebuild(size_t capacity, uint64_t now_ms);
+};
+
+#endif
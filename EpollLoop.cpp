@@ -0,0 +1,95 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollLoop.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EpollLoop.hpp"
+
+#ifdef __linux__
+
+#include <unistd.h> // close
+
+static uint32_t toEpollEvents(int events)
+{
+	uint32_t ev = EPOLLET | EPOLLRDHUP;
+	if (events & EventLoop::EV_READ)
+		ev |= EPOLLIN;
+	if (events & EventLoop::EV_WRITE)
+		ev |= EPOLLOUT;
+	return ev;
+}
+
+EpollLoop::EpollLoop() : epoll_fd(epoll_create1(EPOLL_CLOEXEC)), ready(256) {}
+
+EpollLoop::~EpollLoop()
+{
+	if (epoll_fd != -1)
+		close(epoll_fd);
+}
+
+bool EpollLoop::isValid() const
+{
+	return epoll_fd != -1;
+}
+
+bool EpollLoop::add(int fd, void *data, int events)
+{
+	struct epoll_event ev;
+	ev.events = toEpollEvents(events);
+	ev.data.ptr = data;
+	return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+bool EpollLoop::modify(int fd, void *data, int events)
+{
+	struct epoll_event ev;
+	ev.events = toEpollEvents(events);
+	ev.data.ptr = data;
+	return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EpollLoop::remove(int fd)
+{
+	struct epoll_event ev; // ignore, mais requis avant Linux 2.6.9
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+}
+
+int EpollLoop::wait(std::vector<Event>& events, int timeout_ms)
+{
+	events.clear();
+	int n = epoll_wait(epoll_fd, &ready[0], ready.size(), timeout_ms);
+	if (n <= 0)
+		return n;
+	for (int i = 0; i < n; ++i)
+	{
+		Event ev;
+		ev.data = ready[i].data.ptr;
+		ev.events = 0;
+		ev.result = 0;
+		if (ready[i].events & (EPOLLIN | EPOLLRDHUP))
+			ev.events |= EV_READ;
+		if (ready[i].events & EPOLLOUT)
+			ev.events |= EV_WRITE;
+		if (ready[i].events & (EPOLLERR | EPOLLHUP))
+			ev.events |= EV_ERROR;
+		events.push_back(ev);
+	}
+	// Buffer plein : on l'agrandit pour le prochain reveil
+	if (static_cast<size_t>(n) == ready.size())
+		ready.resize(ready.size() * 2);
+	return n;
+}
+
+const char *EpollLoop::name() const
+{
+	return "epoll";
+}
+
+#endif
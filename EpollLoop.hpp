@@ -0,0 +1,47 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EpollLoop.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EPOLLLOOP_HPP
+#define EPOLLLOOP_HPP
+
+#include "EventLoop.hpp"
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+
+// Backend Linux en mode edge-triggered : le cout d'un reveil depend du nombre
+// de fd actifs, pas du nombre total de connexions. Les appelants doivent donc
+// lire/accepter jusqu'a EAGAIN.
+class EpollLoop : public EventLoop
+{
+	private:
+		int epoll_fd;
+		std::vector<struct epoll_event> ready;
+
+		EpollLoop(const EpollLoop&);
+		EpollLoop& operator=(const EpollLoop&);
+
+	public:
+		EpollLoop();
+		virtual ~EpollLoop();
+		bool isValid() const;
+		virtual bool add(int fd, void *data, int events);
+		virtual bool modify(int fd, void *data, int events);
+		virtual void remove(int fd);
+		virtual int wait(std::vector<Event>& events, int timeout_ms);
+		virtual const char *name() const;
+};
+
+#endif
+
+#endif
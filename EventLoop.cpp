@@ -0,0 +1,86 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventLoop.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "EventLoop.hpp"
+#include "PollLoop.hpp"
+#include "EpollLoop.hpp"
+#include "UringLoop.hpp"
+#include "Logger.hpp"
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+EventLoop *EventLoop::create(const std::string& backend)
+{
+#ifdef HAVE_IO_URING
+	if (backend == "io_uring")
+	{
+		UringLoop *loop = new UringLoop();
+		if (loop->isValid())
+			return loop;
+		LOG_WARN << "io_uring unavailable, falling back to epoll";
+		delete loop;
+	}
+#endif
+#ifdef __linux__
+# ifndef HAVE_IO_URING
+	if (backend == "io_uring")
+		LOG_WARN << "io_uring not supported by this build, falling back to epoll";
+# endif
+	if (backend == "io_uring" || backend == "epoll")
+	{
+		EpollLoop *loop = new EpollLoop();
+		if (loop->isValid())
+			return loop;
+		LOG_WARN << "epoll unavailable, falling back to poll";
+		delete loop;
+	}
+#else
+	if (backend == "io_uring" || backend == "epoll")
+		LOG_WARN << backend << " unavailable on this platform, falling back to poll";
+#endif
+	return new PollLoop();
+}
+
+//----------------------E/S DIRECTES-----
+
+int EventLoop::accept(int listen_fd, struct sockaddr_in& address)
+{
+	socklen_t length = sizeof(address);
+#ifdef SOCK_NONBLOCK
+	// Non bloquant et close-on-exec des l'acceptation, sans fcntl supplementaire
+	return accept4(listen_fd, (struct sockaddr*)&address, &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	return ::accept(listen_fd, (struct sockaddr*)&address, &length);
+#endif
+}
+
+ssize_t EventLoop::receive(int fd, char *buffer, size_t size)
+{
+	return recv(fd, buffer, size, 0);
+}
+
+bool EventLoop::completesIo() const
+{
+	return false;
+}
+
+int EventLoop::queueSend(int, const struct iovec *, size_t)
+{
+	errno = ENOTSUP;
+	return -1;
+}
+
+void EventLoop::quiesce(std::vector<Event>& events)
+{
+	events.clear();
+}
@@ -0,0 +1,74 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   EventLoop.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <string>
+#include <vector>
+#include <sys/types.h> // ssize_t
+
+struct iovec;
+struct sockaddr_in;
+
+// Interface commune des backends de multiplexage (epoll, poll, io_uring).
+// Chaque fd est enregistre avec un pointeur opaque (le Client*, ou NULL
+// pour le socket d'ecoute) qui est rendu tel quel dans les evenements.
+//
+// Les backends a completion (io_uring) font eux-memes les entrees/sorties :
+// accept() et receive() puisent alors dans ce que le noyau a deja livre, et
+// les envois partent par queueSend() et reviennent en EV_SENT. Pour les
+// backends a disponibilite, ce sont de simples appels systeme.
+class EventLoop
+{
+	public:
+		enum
+		{
+			EV_READ = 1,
+			EV_WRITE = 2,
+			EV_ERROR = 4,
+			EV_SENT = 8 // Completion d'un envoi (backends a completion)
+		};
+
+		struct Event
+		{
+			void	*data;
+			int		events;
+			int		result; // EV_SENT : octets envoyes ou -errno
+		};
+
+		virtual ~EventLoop() {}
+		virtual bool add(int fd, void *data, int events) = 0;
+		virtual bool modify(int fd, void *data, int events) = 0;
+		virtual void remove(int fd) = 0;
+		// Remplit `events` avec les fd prets, retourne leur nombre (ou -1).
+		virtual int wait(std::vector<Event>& events, int timeout_ms) = 0;
+		virtual const char *name() const = 0;
+
+		// Connexion suivante du socket d'ecoute, non bloquante et close-on-exec
+		virtual int accept(int listen_fd, struct sockaddr_in& address);
+		// Meme contrat que recv() : octets, 0 en fin de flux, -1/errno
+		virtual ssize_t receive(int fd, char *buffer, size_t size);
+		// Vrai si les envois passent par queueSend() au lieu de writev()
+		virtual bool completesIo() const;
+		// Prepare l'envoi de `count` tampons, dans l'ordre ; retourne le nombre
+		// de completions EV_SENT a attendre (-1 si non supporte)
+		virtual int queueSend(int fd, const struct iovec *iov, size_t count);
+		// Plus rien en vol dans le noyau ; les envois termines sont rendus
+		virtual void quiesce(std::vector<Event>& events);
+
+		// "io_uring", "epoll" ou "poll" ; chaque backend indisponible retombe
+		// sur le suivant.
+		static EventLoop *create(const std::string& backend);
+};
+
+#endif
@@ -0,0 +1,55 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   FixedString.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef FIXEDSTRING_HPP
+#define FIXEDSTRING_HPP
+
+#include <string>
+#include <cstring>
+
+// Chaine de capacite fixe stockee dans l'objet : pas d'allocation, et les
+// champs courts du client (pseudo, ident, hote) restent dans ses lignes de
+// cache. Ce qui depasse N est tronque ; les commandes bornent deja leurs
+// parametres aux limites du protocole.
+template <size_t N>
+class FixedString
+{
+	private:
+		unsigned char	len;
+		char			data[N + 1];
+
+	public:
+		FixedString() : len(0) { data[0] = '\0'; }
+
+		void assign(const char *s, size_t n)
+		{
+			if (n > N)
+				n = N;
+			std::memcpy(data, s, n);
+			data[n] = '\0';
+			len = static_cast<unsigned char>(n);
+		}
+		void assign(const std::string& s) { assign(s.data(), s.size()); }
+
+		std::string str() const { return std::string(data, len); }
+		const char *c_str() const { return data; }
+		size_t size() const { return len; }
+		bool empty() const { return len == 0; }
+		static size_t capacity() { return N; }
+
+		bool operator==(const FixedString& other) const
+		{
+			return len == other.len && std::memcmp(data, other.data, len) == 0;
+		}
+};
+
+#endif
@@ -0,0 +1,167 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Handoff.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Handoff.hpp"
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+const char *const Handoff::ENV_NAME = "IRCSERV_HANDOFF_FD";
+
+//----------------------IO-----------------------------------------
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = write(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool readAll(int fd, char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t n = read(fd, data, size);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		data += n;
+		size -= n;
+	}
+	return true;
+}
+
+//----------------------SEND-----------------------------------------
+
+static bool sendBatch(int channel, const int *fds, size_t count)
+{
+	char byte = 'F';
+	struct iovec iov;
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+	char control[CMSG_SPACE(sizeof(int) * Handoff::FD_BATCH)];
+	std::memset(control, 0, sizeof(control));
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+	std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+	ssize_t n;
+	do
+		n = sendmsg(channel, &msg, 0);
+	while (n < 0 && errno == EINTR);
+	return n == 1;
+}
+
+bool Handoff::send(int channel, const std::vector<int>& fds, const std::string& state)
+{
+	uint32_t fd_count = fds.size();
+	uint64_t state_size = state.size();
+	if (!writeAll(channel, reinterpret_cast<const char*>(&fd_count), sizeof(fd_count))
+		|| !writeAll(channel, reinterpret_cast<const char*>(&state_size), sizeof(state_size)))
+		return false;
+	for (size_t i = 0; i < fds.size(); i += FD_BATCH)
+	{
+		size_t count = std::min(fds.size() - i, static_cast<size_t>(FD_BATCH));
+		if (!sendBatch(channel, &fds[i], count))
+			return false;
+	}
+	return writeAll(channel, state.data(), state.size());
+}
+
+//----------------------RECEIVE-----------------------------------------
+
+// Un octet par lot : la lecture s'arrete sur la frontiere du message, avec
+// exactement ses descripteurs
+static bool receiveBatch(int channel, std::vector<int>& fds)
+{
+	char byte;
+	struct iovec iov;
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+	char control[CMSG_SPACE(sizeof(int) * Handoff::FD_BATCH)];
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	ssize_t n;
+	do
+		n = recvmsg(channel, &msg, MSG_CMSG_CLOEXEC);
+	while (n < 0 && errno == EINTR);
+	if (n != 1 || (msg.msg_flags & MSG_CTRUNC))
+		return false;
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+		size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		const int *received = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+		fds.insert(fds.end(), received, received + count);
+	}
+	return true;
+}
+
+bool Handoff::receive(int channel, std::vector<int>& fds, std::string& state)
+{
+	uint32_t fd_count;
+	uint64_t state_size;
+	if (!readAll(channel, reinterpret_cast<char*>(&fd_count), sizeof(fd_count))
+		|| !readAll(channel, reinterpret_cast<char*>(&state_size), sizeof(state_size)))
+		return false;
+	fds.reserve(fd_count);
+	while (fds.size() < fd_count)
+	{
+		if (!receiveBatch(channel, fds))
+			return false;
+	}
+	state.resize(state_size);
+	return state_size == 0 || readAll(channel, &state[0], state_size);
+}
+
+bool Handoff::sendReady(int channel)
+{
+	char byte = READY;
+	return writeAll(channel, &byte, 1);
+}
+
+bool Handoff::waitReady(int channel, int timeout_ms)
+{
+	struct pollfd pfd;
+	pfd.fd = channel;
+	pfd.events = POLLIN;
+	int ready;
+	do
+		ready = poll(&pfd, 1, timeout_ms);
+	while (ready < 0 && errno == EINTR);
+	char byte;
+	return ready == 1 && read(channel, &byte, 1) == 1 && byte == READY;
+}
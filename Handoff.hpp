@@ -0,0 +1,41 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Handoff.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef HANDOFF_HPP
+#define HANDOFF_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "StateCodec.hpp"
+
+// Passage de relais vers un nouveau binaire (SIGUSR2). L'ancien processus
+// envoie sur une socket Unix les descripteurs (SCM_RIGHTS, par lots) puis
+// l'etat serialise ; le nouveau repond par un octet une fois pret.
+//
+//   en-tete : nombre de fd (32 bits), taille de l'etat (64 bits)
+//   lots    : un octet + jusqu'a FD_BATCH descripteurs chacun
+//   etat    : taille octets, ecrits par StateWriter
+class Handoff
+{
+	public:
+		enum { FD_BATCH = 250 }; // SCM_MAX_FD vaut 253 sous Linux
+		static const char *const ENV_NAME; // Porte le fd de la socket cote nouveau processus
+		static const char READY = 'R';
+
+		static bool send(int channel, const std::vector<int>& fds, const std::string& state);
+		static bool receive(int channel, std::vector<int>& fds, std::string& state);
+		static bool sendReady(int channel);
+		static bool waitReady(int channel, int timeout_ms);
+};
+
+#endif
@@ -0,0 +1,75 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   IrcMessage.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "IrcMessage.hpp"
+
+static StringView makeView(const char *begin, const char *end)
+{
+	StringView view;
+	view.data = begin;
+	view.size = end - begin;
+	return view;
+}
+
+static const char *skipSpaces(const char *p, const char *end)
+{
+	while (p < end && *p == ' ')
+		++p;
+	return p;
+}
+
+static const char *nextSpace(const char *p, const char *end)
+{
+	while (p < end && *p != ' ')
+		++p;
+	return p;
+}
+
+bool parseIrcMessage(const char *line, size_t len, IrcMessage& msg)
+{
+	const char *p = line;
+	const char *end = line + len;
+
+	msg.prefix = makeView(p, p);
+	msg.param_count = 0;
+	p = skipSpaces(p, end);
+	if (p < end && *p == ':')
+	{
+		const char *prefix_end = nextSpace(p, end);
+		msg.prefix = makeView(p + 1, prefix_end);
+		p = skipSpaces(prefix_end, end);
+	}
+	const char *command_end = nextSpace(p, end);
+	if (command_end == p)
+		return false;
+	msg.command = makeView(p, command_end);
+	p = command_end;
+
+	while (true)
+	{
+		p = skipSpaces(p, end);
+		if (p == end)
+			break;
+		// ":trailing", ou 15e parametre : le reste de la ligne, espaces compris
+		if (*p == ':' || msg.param_count == IrcMessage::MAX_PARAMS - 1)
+		{
+			if (*p == ':')
+				++p;
+			msg.params[msg.param_count++] = makeView(p, end);
+			break;
+		}
+		const char *param_end = nextSpace(p, end);
+		msg.params[msg.param_count++] = makeView(p, param_end);
+		p = param_end;
+	}
+	return true;
+}
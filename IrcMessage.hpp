@@ -0,0 +1,43 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   IrcMessage.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef IRCMESSAGE_HPP
+#define IRCMESSAGE_HPP
+
+#include <string>
+#include <cstddef>
+
+// Vue sur une portion du tampon de reception (pas de copie)
+struct StringView
+{
+	const char	*data;
+	size_t		size;
+
+	std::string str() const { return std::string(data, size); }
+};
+
+// Message RFC 1459 decoupe en place :
+//   [':' prefix SPACE] command *(SPACE middle) [SPACE ':' trailing]
+struct IrcMessage
+{
+	enum { MAX_PARAMS = 15 };
+
+	StringView	prefix;
+	StringView	command;
+	StringView	params[MAX_PARAMS];
+	size_t		param_count;
+};
+
+// Retourne false pour une ligne vide ou sans commande
+bool parseIrcMessage(const char *line, size_t len, IrcMessage& msg);
+
+#endif
@@ -0,0 +1,296 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Logger.cpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Logger.hpp"
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h> // write, usleep
+
+volatile Logger::Level Logger::threshold = Logger::LEVEL_INFO;
+Logger::Slot *Logger::ring = NULL;
+size_t Logger::enqueue_pos = 0;
+size_t Logger::dequeue_pos = 0;
+size_t Logger::dropped = 0;
+volatile bool Logger::running = false;
+pthread_t Logger::writer;
+
+static const char *levelName(Logger::Level level)
+{
+	static const char *names[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+	return names[level];
+}
+
+static void writeAll(const char *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(STDERR_FILENO, data, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return;
+		data += written;
+		size -= written;
+	}
+}
+
+// "2026-10-17 10:00:00 INFO  texte\n", sans terminateur
+static size_t formatLine(char *out, Logger::Level level, time_t when, const char *text, size_t length)
+{
+	struct tm tm;
+	localtime_r(&when, &tm);
+	size_t used = strftime(out, 32, "%Y-%m-%d %H:%M:%S ", &tm);
+	std::memcpy(out + used, levelName(level), 5);
+	used += 5;
+	out[used++] = ' ';
+	std::memcpy(out + used, text, length);
+	used += length;
+	out[used++] = '\n';
+	return used;
+}
+
+static const size_t FORMATTED_MAX = Logger::LINE_SIZE + 64;
+
+//----------------------CONFIGURATION-----------------------------------------
+
+bool Logger::parseLevel(const std::string& name, Level& level)
+{
+	static const char *names[] = { "debug", "info", "warn", "error" };
+	for (int i = LEVEL_DEBUG; i <= LEVEL_ERROR; ++i)
+	{
+		if (name == names[i])
+		{
+			level = static_cast<Level>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+void Logger::setLevel(Level level)
+{
+	threshold = level;
+}
+
+//----------------------START-AND-STOP-----------------------------------------
+
+bool Logger::start()
+{
+	ring = new Slot[RING_SIZE];
+	for (size_t i = 0; i < RING_SIZE; ++i)
+		ring[i].sequence = i;
+	running = true;
+	if (pthread_create(&writer, NULL, writerThread, NULL) != 0)
+	{
+		running = false;
+		delete[] ring;
+		ring = NULL;
+		return false;
+	}
+	return true;
+}
+
+// Vide l'anneau puis repasse en ecriture directe
+void Logger::stop()
+{
+	if (!running)
+		return;
+	running = false;
+	pthread_join(writer, NULL);
+	delete[] ring;
+	ring = NULL;
+}
+
+//----------------------PRODUCERS-----------------------------------------
+
+void Logger::submit(Level level, const char *text, size_t length)
+{
+	if (!running)
+		writeDirect(level, time(NULL), text, length);
+	else if (!push(level, text, length))
+		__sync_fetch_and_add(&dropped, 1);
+}
+
+// File bornee multi-producteurs (Vyukov) : chaque slot porte un numero de
+// sequence qui indique s'il est libre pour la position courante ou publie.
+// Anneau plein : la ligne est perdue et comptee, jamais de blocage.
+bool Logger::push(Level level, const char *text, size_t length)
+{
+	size_t pos = enqueue_pos;
+	Slot *slot;
+	for (;;)
+	{
+		slot = &ring[pos & (RING_SIZE - 1)];
+		size_t sequence = slot->sequence;
+		__sync_synchronize();
+		long diff = static_cast<long>(sequence) - static_cast<long>(pos);
+		if (diff == 0)
+		{
+			size_t seen = __sync_val_compare_and_swap(&enqueue_pos, pos, pos + 1);
+			if (seen == pos)
+				break;
+			pos = seen;
+		}
+		else if (diff < 0)
+			return false;
+		else
+			pos = enqueue_pos;
+	}
+	slot->level = level;
+	slot->when = time(NULL);
+	slot->length = length;
+	std::memcpy(slot->text, text, length);
+	__sync_synchronize();
+	slot->sequence = pos + 1;
+	return true;
+}
+
+void Logger::writeDirect(Level level, time_t when, const char *text, size_t length)
+{
+	char line[FORMATTED_MAX];
+	writeAll(line, formatLine(line, level, when, text, length));
+}
+
+//----------------------WRITER-THREAD-----------------------------------------
+
+// Seul consommateur. Les lignes identiques consecutives sont comptees au lieu
+// d'etre ecrites, et resumees quand l'anneau est vide ou qu'une autre arrive.
+void *Logger::writerThread(void *arg)
+{
+	(void)arg;
+	static char out[64 * 1024];
+	size_t used = 0;
+	char last_text[LINE_SIZE];
+	size_t last_length = 0;
+	Level last_level = LEVEL_INFO;
+	bool has_last = false;
+	size_t repeats = 0;
+	size_t reported_drops = 0;
+
+	for (;;)
+	{
+		bool stopping = !running;
+		bool idle = true;
+		for (;;)
+		{
+			Slot& slot = ring[dequeue_pos & (RING_SIZE - 1)];
+			if (slot.sequence != dequeue_pos + 1)
+				break;
+			__sync_synchronize();
+			idle = false;
+			if (used + 2 * FORMATTED_MAX > sizeof(out))
+			{
+				writeAll(out, used);
+				used = 0;
+			}
+			if (has_last && slot.level == last_level && slot.length == last_length
+				&& std::memcmp(slot.text, last_text, last_length) == 0)
+				++repeats;
+			else
+			{
+				if (repeats > 0)
+				{
+					used += std::sprintf(out + used, "last message repeated %lu times\n", static_cast<unsigned long>(repeats));
+					repeats = 0;
+				}
+				used += formatLine(out + used, slot.level, slot.when, slot.text, slot.length);
+				std::memcpy(last_text, slot.text, slot.length);
+				last_length = slot.length;
+				last_level = slot.level;
+				has_last = true;
+			}
+			__sync_synchronize();
+			slot.sequence = dequeue_pos + RING_SIZE;
+			++dequeue_pos;
+		}
+
+		if (repeats > 0 && (idle || stopping))
+		{
+			used += std::sprintf(out + used, "last message repeated %lu times\n", static_cast<unsigned long>(repeats));
+			repeats = 0;
+		}
+		size_t drops = __sync_fetch_and_add(&dropped, 0);
+		if (drops != reported_drops)
+		{
+			used += std::sprintf(out + used, "%lu log lines dropped (ring full)\n", static_cast<unsigned long>(drops - reported_drops));
+			reported_drops = drops;
+		}
+		if (used > 0)
+		{
+			writeAll(out, used);
+			used = 0;
+		}
+		if (stopping)
+			break;
+		if (idle)
+			usleep(2000);
+	}
+	return NULL;
+}
+
+//----------------------LOG-LINE-----------------------------------------
+
+void LogLine::append(const char *data, size_t size)
+{
+	if (size > Logger::LINE_SIZE - length)
+		size = Logger::LINE_SIZE - length;
+	std::memcpy(buffer + length, data, size);
+	length += size;
+}
+
+LogLine& LogLine::operator<<(const char *text)
+{
+	append(text, std::strlen(text));
+	return *this;
+}
+
+LogLine& LogLine::operator<<(const std::string& text)
+{
+	append(text.data(), text.size());
+	return *this;
+}
+
+LogLine& LogLine::operator<<(const LogBytes& bytes)
+{
+	append(bytes.data, bytes.size);
+	return *this;
+}
+
+LogLine& LogLine::operator<<(char c)
+{
+	append(&c, 1);
+	return *this;
+}
+
+LogLine& LogLine::operator<<(long value)
+{
+	if (value < 0)
+	{
+		append("-", 1);
+		return *this << static_cast<unsigned long>(-(value + 1)) + 1;
+	}
+	return *this << static_cast<unsigned long>(value);
+}
+
+LogLine& LogLine::operator<<(unsigned long value)
+{
+	char digits[24];
+	size_t pos = sizeof(digits);
+	do
+	{
+		digits[--pos] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	append(digits + pos, sizeof(digits) - pos);
+	return *this;
+}
@@ -0,0 +1,120 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Logger.hpp                                         :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <string>
+#include <ctime>
+#include <pthread.h>
+
+// Journalisation asynchrone. Les threads du serveur formatent la ligne sur la
+// pile et la deposent dans un anneau sans verrou ; un thread d'ecriture vide
+// l'anneau par gros blocs sur stderr et resume les lignes repetees.
+// Un niveau desactive ne coute qu'une comparaison ; LOG_DEBUG n'est compile
+// qu'avec -DIRC_DEBUG_LOG (make debug).
+class Logger
+{
+	public:
+		enum Level
+		{
+			LEVEL_DEBUG,
+			LEVEL_INFO,
+			LEVEL_WARN,
+			LEVEL_ERROR
+		};
+		static const size_t LINE_SIZE = 480; // Texte max par ligne, tronque au-dela
+
+		static bool parseLevel(const std::string& name, Level& level);
+		static void setLevel(Level level);
+		static bool enabled(Level level) { return level >= threshold; }
+		static bool start();
+		static void stop();
+		static void submit(Level level, const char *text, size_t length);
+
+	private:
+		static const size_t RING_SIZE = 4096; // puissance de 2
+		struct Slot
+		{
+			volatile size_t	sequence;
+			Level			level;
+			time_t			when;
+			size_t			length;
+			char			text[LINE_SIZE];
+		};
+
+		static volatile Level threshold;
+		static Slot *ring;
+		static size_t enqueue_pos;
+		static size_t dequeue_pos;
+		static size_t dropped;
+		static volatile bool running;
+		static pthread_t writer;
+
+		static bool push(Level level, const char *text, size_t length);
+		static void *writerThread(void *arg);
+		static void writeDirect(Level level, time_t when, const char *text, size_t length);
+
+		Logger();
+};
+
+// Octets bruts du protocole ; le CRLF final est retire
+struct LogBytes
+{
+	const char	*data;
+	size_t		size;
+	LogBytes(const char *data, size_t size) : data(data), size(size)
+	{
+		while (this->size > 0 && (data[this->size - 1] == '\n' || data[this->size - 1] == '\r'))
+			--this->size;
+	}
+};
+
+// Une ligne en cours de formatage ; deposee dans l'anneau a la destruction,
+// c'est-a-dire a la fin de l'instruction LOG_xxx << ... ;
+class LogLine
+{
+	private:
+		Logger::Level level;
+		size_t length;
+		char buffer[Logger::LINE_SIZE];
+
+		void append(const char *data, size_t size);
+		LogLine(const LogLine&);
+		LogLine& operator=(const LogLine&);
+
+	public:
+		explicit LogLine(Logger::Level level) : level(level), length(0) {}
+		~LogLine() { Logger::submit(level, buffer, length); }
+		LogLine& operator<<(const char *text);
+		LogLine& operator<<(const std::string& text);
+		LogLine& operator<<(const LogBytes& bytes);
+		LogLine& operator<<(char c);
+		LogLine& operator<<(long value);
+		LogLine& operator<<(unsigned long value);
+		LogLine& operator<<(int value) { return *this << static_cast<long>(value); }
+		LogLine& operator<<(unsigned int value) { return *this << static_cast<unsigned long>(value); }
+};
+
+// Boucle a un tour plutot qu'un if/else : pas d'ambiguite de else pendant
+// quand la macro est le corps d'un if sans accolades
+#define IRC_LOG(level) for (bool log_once_ = Logger::enabled(level); log_once_; log_once_ = false) LogLine(level)
+#ifdef IRC_DEBUG_LOG
+# define LOG_DEBUG IRC_LOG(Logger::LEVEL_DEBUG)
+#else
+# define LOG_DEBUG while (false) LogLine(Logger::LEVEL_DEBUG)
+#endif
+#define LOG_INFO IRC_LOG(Logger::LEVEL_INFO)
+#define LOG_WARN IRC_LOG(Logger::LEVEL_WARN)
+#define LOG_ERROR IRC_LOG(Logger::LEVEL_ERROR)
+
+#endif
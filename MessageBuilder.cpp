@@ -0,0 +1,53 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MessageBuilder.cpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "MessageBuilder.hpp"
+#include <cstring>
+
+MessageBuilder& MessageBuilder::append(const char *data, size_t size)
+{
+	if (spill.empty() && length + size <= INLINE)
+	{
+		std::memcpy(buffer + length, data, size);
+		length += size;
+		return *this;
+	}
+	if (spill.empty())
+		spill.assign(buffer, length);
+	spill.append(data, size);
+	return *this;
+}
+
+MessageBuilder& MessageBuilder::operator<<(const char *text)
+{
+	return append(text, std::strlen(text));
+}
+
+// Entier en decimal, sans passer par un ostringstream
+MessageBuilder& MessageBuilder::operator<<(unsigned long value)
+{
+	char digits[24];
+	size_t pos = sizeof(digits);
+	do
+	{
+		digits[--pos] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	return append(digits + pos, sizeof(digits) - pos);
+}
+
+SharedBuffer MessageBuilder::share() const
+{
+	if (!spill.empty())
+		return SharedBuffer(spill.data(), spill.size());
+	return SharedBuffer(buffer, length);
+}
@@ -0,0 +1,52 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MessageBuilder.hpp                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MESSAGEBUILDER_HPP
+#define MESSAGEBUILDER_HPP
+
+#include <string>
+#include <cstddef>
+#include "SharedBuffer.hpp"
+
+// Construction d'un message sortant sur la pile, sans les temporaires des
+// concatenations de std::string ; share() le copie une seule fois dans un
+// bloc de la BufferPool. Une ligne IRC tient toujours dans INLINE ; au-dela
+// (ne devrait pas arriver) on bascule sur une std::string.
+//
+//   MessageBuilder msg;
+//   msg << ':' << nick << " PRIVMSG " << target << " :" << text << "\r\n";
+//   broadcast(members, msg.share(), client);
+class MessageBuilder
+{
+	private:
+		enum { INLINE = 1024 };
+
+		char buffer[INLINE];
+		size_t length;
+		std::string spill;
+
+		MessageBuilder(const MessageBuilder&);
+		MessageBuilder& operator=(const MessageBuilder&);
+
+	public:
+		MessageBuilder() : length(0) {}
+
+		MessageBuilder& append(const char *data, size_t size);
+		MessageBuilder& operator<<(const std::string& text) { return append(text.data(), text.size()); }
+		MessageBuilder& operator<<(const char *text);
+		MessageBuilder& operator<<(char c) { return append(&c, 1); }
+		MessageBuilder& operator<<(unsigned long value);
+
+		SharedBuffer share() const;
+};
+
+#endif
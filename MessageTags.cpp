@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MessageTags.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "MessageTags.hpp"
+#include "Client.hpp"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <sys/time.h>
+
+//----------------------MESSAGE-TAGS-----------------------------------------
+
+static uint64_t nowMillis()
+{
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+}
+
+MessageTags::MessageTags(uint64_t id)
+{
+	*this = MessageTags(id, nowMillis());
+}
+
+MessageTags::MessageTags(uint64_t id, uint64_t time_ms) : id(id), time_ms(time_ms)
+{
+	struct tm parts;
+	time_t seconds = static_cast<time_t>(time_ms / 1000);
+	gmtime_r(&seconds, &parts);
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &parts);
+	int prefix = std::snprintf(text, sizeof(text), "@msgid=%llu;", static_cast<unsigned long long>(id));
+	time_offset = prefix;
+	size = prefix + std::snprintf(text + prefix, sizeof(text) - prefix, "time=%s.%03dZ ",
+		stamp, static_cast<int>(time_ms % 1000));
+}
+
+//----------------------TAGGED-LINE-----------------------------------------
+
+TaggedLine::TaggedLine(const MessageTags& tags, const SharedBuffer& line) : tags(tags), line(line) {}
+
+const MessageTags& TaggedLine::getTags() const
+{
+	return tags;
+}
+
+const SharedBuffer& TaggedLine::getLine() const
+{
+	return line;
+}
+
+// Un utilisateur distant ou une liaison n'a aucune capacite : ligne nue
+const SharedBuffer& TaggedLine::forClient(const Client *client)
+{
+	if (client->hasCap(Client::CAP_MESSAGE_TAGS))
+	{
+		if (with_tags.empty())
+		{
+			with_tags = SharedBuffer(tags.size + line.size());
+			std::memcpy(with_tags.writable(), tags.text, tags.size);
+			std::memcpy(with_tags.writable() + tags.size, line.data(), line.size());
+		}
+		return with_tags;
+	}
+	if (client->hasCap(Client::CAP_SERVER_TIME))
+	{
+		if (with_time.empty())
+		{
+			size_t time_size = tags.size - tags.time_offset;
+			with_time = SharedBuffer(1 + time_size + line.size());
+			char *out = with_time.writable();
+			out[0] = '@';
+			std::memcpy(out + 1, tags.text + tags.time_offset, time_size);
+			std::memcpy(out + 1 + time_size, line.data(), line.size());
+		}
+		return with_time;
+	}
+	return line;
+}
@@ -0,0 +1,59 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   MessageTags.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MESSAGETAGS_HPP
+#define MESSAGETAGS_HPP
+
+#include "SharedBuffer.hpp"
+#include <cstddef>
+#include <stdint.h>
+
+class Client;
+
+// Etiquettes IRCv3 d'un PRIVMSG/NOTICE, serialisees une fois :
+// "@msgid=<id>;time=<AAAA-MM-JJTHH:MM:SS.mmmZ> ". Un client qui n'a que
+// server-time en recoit la fin, a partir de time_offset, derriere un '@'.
+struct MessageTags
+{
+	uint64_t	id;
+	uint64_t	time_ms;
+	char		text[64];
+	size_t		size; // Espace final compris
+	size_t		time_offset; // Debut de "time="
+
+	explicit MessageTags(uint64_t id); // Horodate maintenant
+	MessageTags(uint64_t id, uint64_t time_ms);
+};
+
+// Une ligne PRIVMSG/NOTICE et ses formes etiquetees. Chaque forme est
+// construite pour le premier destinataire qui la demande puis partagee :
+// au plus trois serialisations par cible, jamais une par destinataire.
+class TaggedLine
+{
+	private:
+		const MessageTags&	tags;
+		SharedBuffer		line;
+		SharedBuffer		with_time; // server-time seul
+		SharedBuffer		with_tags; // message-tags
+
+		TaggedLine(const TaggedLine&);
+		TaggedLine& operator=(const TaggedLine&);
+
+	public:
+		TaggedLine(const MessageTags& tags, const SharedBuffer& line);
+
+		const MessageTags& getTags() const;
+		const SharedBuffer& getLine() const; // Sans etiquette : liaisons, historique
+		const SharedBuffer& forClient(const Client *client);
+};
+
+#endif
@@ -0,0 +1,104 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Mutex.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef MUTEX_HPP
+#define MUTEX_HPP
+
+#include <pthread.h>
+
+class Mutex
+{
+	private:
+		pthread_mutex_t mutex;
+
+		Mutex(const Mutex&);
+		Mutex& operator=(const Mutex&);
+
+	public:
+		Mutex() { pthread_mutex_init(&mutex, NULL); }
+		~Mutex() { pthread_mutex_destroy(&mutex); }
+		void lock() { pthread_mutex_lock(&mutex); }
+		void unlock() { pthread_mutex_unlock(&mutex); }
+};
+
+// Verrouille pour la duree du bloc
+class ScopedLock
+{
+	private:
+		Mutex& mutex;
+
+		ScopedLock(const ScopedLock&);
+		ScopedLock& operator=(const ScopedLock&);
+
+	public:
+		explicit ScopedLock(Mutex& mutex) : mutex(mutex) { mutex.lock(); }
+		~ScopedLock() { mutex.unlock(); }
+};
+
+// Lecteurs concurrents ou un seul ecrivain. Sous glibc, les ecrivains passent
+// avant les nouveaux lecteurs : un flot de lectures ne les affame pas.
+class RwLock
+{
+	private:
+		pthread_rwlock_t rwlock;
+
+		RwLock(const RwLock&);
+		RwLock& operator=(const RwLock&);
+
+	public:
+		RwLock()
+		{
+			pthread_rwlockattr_t attr;
+			pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+			pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+			// Ailleurs (macOS, musl) : politique par defaut, qui favorise les
+			// lecteurs ; un flot de PRIVMSG peut alors retarder un JOIN
+			pthread_rwlock_init(&rwlock, &attr);
+			pthread_rwlockattr_destroy(&attr);
+		}
+		~RwLock() { pthread_rwlock_destroy(&rwlock); }
+		void lock() { pthread_rwlock_wrlock(&rwlock); }
+		void lockShared() { pthread_rwlock_rdlock(&rwlock); }
+		void unlock() { pthread_rwlock_unlock(&rwlock); }
+};
+
+// Acces exclusif pour la duree du bloc
+class ExclusiveLock
+{
+	private:
+		RwLock& rwlock;
+
+		ExclusiveLock(const ExclusiveLock&);
+		ExclusiveLock& operator=(const ExclusiveLock&);
+
+	public:
+		explicit ExclusiveLock(RwLock& rwlock) : rwlock(rwlock) { rwlock.lock(); }
+		~ExclusiveLock() { rwlock.unlock(); }
+};
+
+// Acces en lecture, partage avec les autres lecteurs, pour la duree du bloc
+class SharedLock
+{
+	private:
+		RwLock& rwlock;
+
+		SharedLock(const SharedLock&);
+		SharedLock& operator=(const SharedLock&);
+
+	public:
+		explicit SharedLock(RwLock& rwlock) : rwlock(rwlock) { rwlock.lockShared(); }
+		~SharedLock() { rwlock.unlock(); }
+};
+
+#endif
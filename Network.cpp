@@ -0,0 +1,115 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Network.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Network.hpp"
+#include "Casemap.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <arpa/inet.h> // inet_pton
+
+bool LinkPeer::parseList(const std::string& text, std::vector<LinkPeer>& out)
+{
+	out.clear();
+	std::string::size_type begin = 0;
+	while (begin < text.size())
+	{
+		std::string::size_type comma = text.find(',', begin);
+		if (comma == std::string::npos)
+			comma = text.size();
+		std::string item = text.substr(begin, comma - begin);
+		std::string::size_type colon = item.rfind(':');
+		if (colon == std::string::npos)
+			return false;
+		std::string port = item.substr(colon + 1);
+		LinkPeer peer;
+		peer.port = std::atoi(port.c_str());
+		if (port.empty() || port.find_first_not_of("0123456789") != std::string::npos
+			|| peer.port <= 0 || peer.port > 65535
+			|| inet_pton(AF_INET, item.substr(0, colon).c_str(), &peer.address) != 1)
+			return false;
+		out.push_back(peer);
+		begin = comma + 1;
+	}
+	return !out.empty();
+}
+
+Network::Network() {}
+
+Network::~Network()
+{
+	for (size_t i = 0; i < servers.size(); ++i)
+		delete servers[i];
+}
+
+LinkedServer *Network::find(const std::string& name) const
+{
+	for (size_t i = 0; i < servers.size(); ++i)
+		if (ircEquals(servers[i]->name, name))
+			return servers[i];
+	return NULL;
+}
+
+LinkedServer *Network::add(const std::string& name, const std::string& description, size_t hops,
+	Client *route, LinkedServer *uplink)
+{
+	LinkedServer *server = new LinkedServer();
+	server->name = name;
+	server->description = description;
+	server->hops = hops;
+	server->route = route;
+	server->uplink = uplink;
+	servers.push_back(server);
+	return server;
+}
+
+// Un descendant est toujours annonce apres son serveur amont : un seul
+// parcours suffit
+void Network::collect(LinkedServer *server, std::vector<LinkedServer*>& out) const
+{
+	out.clear();
+	out.push_back(server);
+	for (size_t i = 0; i < servers.size(); ++i)
+		if (servers[i]->uplink != NULL
+			&& std::find(out.begin(), out.end(), servers[i]->uplink) != out.end())
+			out.push_back(servers[i]);
+	std::reverse(out.begin(), out.end());
+}
+
+void Network::remove(LinkedServer *server)
+{
+	std::vector<LinkedServer*>::iterator it = std::find(servers.begin(), servers.end(), server);
+	if (it == servers.end())
+		return;
+	servers.erase(it);
+	delete server;
+}
+
+const std::vector<LinkedServer*>& Network::getServers() const
+{
+	return servers;
+}
+
+// Un nom de serveur contient toujours un point, ce qui le distingue d'un pseudo
+bool Network::isValidName(const std::string& name)
+{
+	if (name.empty() || name.size() > 63 || name.find('.') == std::string::npos
+		|| name[0] == '.' || name[0] == '-')
+		return false;
+	for (size_t i = 0; i < name.size(); ++i)
+	{
+		unsigned char c = name[i];
+		if (!std::isalnum(c) && c != '.' && c != '-' && c != '_')
+			return false;
+	}
+	return true;
+}
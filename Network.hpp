@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Network.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef NETWORK_HPP
+#define NETWORK_HPP
+
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+class Client;
+
+// Un serveur distant. Le reseau est un arbre : chacun n'est joignable que
+// par une seule liaison directe, et ses utilisateurs avec lui.
+struct LinkedServer
+{
+	std::string				name;
+	std::string				description;
+	size_t					hops; // 1 : voisin direct
+	Client					*route; // Liaison directe vers ce serveur
+	LinkedServer			*uplink; // Serveur qui l'a annonce (NULL : voisin direct)
+	std::vector<Client*>	users; // Utilisateurs distants presentes par ce serveur
+};
+
+// Pair a joindre au demarrage et apres chaque coupure (link_connect=)
+struct LinkPeer
+{
+	struct in_addr	address;
+	int				port;
+
+	static bool parseList(const std::string& text, std::vector<LinkPeer>& out); // "a.b.c.d:port,..."
+};
+
+// Serveurs connus au-dela de nos liaisons, dans l'ordre ou ils ont ete
+// annonces : un serveur y precede toujours ceux qu'il a presentes, ce qui
+// suffit a rejouer l'arbre dans l'ordre lors d'une nouvelle liaison.
+class Network
+{
+	private:
+		std::vector<LinkedServer*> servers;
+
+		Network(const Network&);
+		Network& operator=(const Network&);
+
+	public:
+		Network();
+		~Network();
+
+		LinkedServer *find(const std::string& name) const;
+		LinkedServer *add(const std::string& name, const std::string& description, size_t hops,
+			Client *route, LinkedServer *uplink);
+		// Le serveur et tous ceux annonces a travers lui, en ordre inverse
+		// d'annonce (les feuilles d'abord)
+		void collect(LinkedServer *server, std::vector<LinkedServer*>& out) const;
+		void remove(LinkedServer *server);
+		const std::vector<LinkedServer*>& getServers() const;
+
+		static bool isValidName(const std::string& name);
+};
+
+#endif
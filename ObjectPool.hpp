@@ -0,0 +1,91 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ObjectPool.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <vector>
+#include <new>
+#include <cstddef>
+
+// Reserve d'emplacements pour des objets de type T, alloues par blocs de
+// CHUNK. Les emplacements liberes sont chaines entre eux et reutilises en
+// priorite : pas de fragmentation du tas et des objets voisins en memoire.
+// Pas de verrou : une reserve n'est utilisee que par un seul thread.
+//
+//   T *obj = new (pool.allocate()) T(...);
+//   obj->~T();
+//   pool.release(obj);
+template <typename T, size_t CHUNK = 256>
+class ObjectPool
+{
+	private:
+		union Slot
+		{
+			Slot	*next;
+			double	align_double;
+			void	*align_ptr;
+			long	align_long;
+			char	storage[sizeof(T)];
+		};
+
+		std::vector<Slot*> chunks;
+		Slot *free_list;
+		size_t used;
+
+		ObjectPool(const ObjectPool&);
+		ObjectPool& operator=(const ObjectPool&);
+
+		void grow()
+		{
+			Slot *chunk = static_cast<Slot*>(::operator new(sizeof(Slot) * CHUNK));
+			chunks.push_back(chunk);
+			for (size_t i = CHUNK; i > 0; --i)
+			{
+				chunk[i - 1].next = free_list;
+				free_list = &chunk[i - 1];
+			}
+		}
+
+	public:
+		ObjectPool() : free_list(NULL), used(0) {}
+
+		// Les objets encore vivants doivent avoir ete detruits
+		~ObjectPool()
+		{
+			for (size_t i = 0; i < chunks.size(); ++i)
+				::operator delete(chunks[i]);
+		}
+
+		void *allocate()
+		{
+			if (free_list == NULL)
+				grow();
+			Slot *slot = free_list;
+			free_list = slot->next;
+			++used;
+			return slot;
+		}
+
+		void release(T *object)
+		{
+			Slot *slot = reinterpret_cast<Slot*>(object);
+			slot->next = free_list;
+			free_list = slot;
+			--used;
+		}
+
+		size_t size() const { return used; }
+		size_t capacity() const { return chunks.size() * CHUNK; }
+};
+
+#endif
@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollLoop.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "PollLoop.hpp"
+#include <cerrno>
+
+static short toPollEvents(int events)
+{
+	short ev = 0;
+	if (events & EventLoop::EV_READ)
+		ev |= POLLIN;
+	if (events & EventLoop::EV_WRITE)
+		ev |= POLLOUT;
+	return ev;
+}
+
+PollLoop::PollLoop() {}
+
+bool PollLoop::add(int fd, void *data, int events)
+{
+	if (fd < 0)
+		return false;
+	if (static_cast<size_t>(fd) >= positions.size())
+		positions.resize(fd + 1, -1);
+	if (positions[fd] != -1)
+		return modify(fd, data, events);
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = toPollEvents(events);
+	pfd.revents = 0;
+	positions[fd] = poll_fds.size();
+	poll_fds.push_back(pfd);
+	datas.push_back(data);
+	return true;
+}
+
+bool PollLoop::modify(int fd, void *data, int events)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= positions.size() || positions[fd] == -1)
+		return false;
+	poll_fds[positions[fd]].events = toPollEvents(events);
+	datas[positions[fd]] = data;
+	return true;
+}
+
+void PollLoop::remove(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= positions.size() || positions[fd] == -1)
+		return;
+	// Retrait en O(1) : on deplace le dernier element dans le trou
+	size_t pos = positions[fd];
+	size_t last = poll_fds.size() - 1;
+	if (pos != last)
+	{
+		poll_fds[pos] = poll_fds[last];
+		datas[pos] = datas[last];
+		positions[poll_fds[pos].fd] = pos;
+	}
+	poll_fds.pop_back();
+	datas.pop_back();
+	positions[fd] = -1;
+}
+
+int PollLoop::wait(std::vector<Event>& events, int timeout_ms)
+{
+	events.clear();
+	int ready = poll(poll_fds.empty() ? NULL : &poll_fds[0], poll_fds.size(), timeout_ms);
+	if (ready <= 0)
+		return ready;
+	for (size_t i = 0; i < poll_fds.size() && static_cast<int>(events.size()) < ready; ++i)
+	{
+		short revents = poll_fds[i].revents;
+		if (revents == 0)
+			continue;
+		Event ev;
+		ev.data = datas[i];
+		ev.events = 0;
+		ev.result = 0;
+		if (revents & POLLIN)
+			ev.events |= EV_READ;
+		if (revents & POLLOUT)
+			ev.events |= EV_WRITE;
+		if (revents & (POLLERR | POLLHUP | POLLNVAL))
+			ev.events |= EV_ERROR;
+		events.push_back(ev);
+	}
+	return events.size();
+}
+
+const char *PollLoop::name() const
+{
+	return "poll";
+}
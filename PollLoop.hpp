@@ -0,0 +1,36 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   PollLoop.hpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef POLLLOOP_HPP
+#define POLLLOOP_HPP
+
+#include "EventLoop.hpp"
+#include <poll.h>
+
+// Backend de secours, portable : un seul tableau pollfd scanne a chaque reveil.
+class PollLoop : public EventLoop
+{
+	private:
+		std::vector<struct pollfd> poll_fds;
+		std::vector<void*> datas; // meme position que poll_fds
+		std::vector<int> positions; // fd -> position dans poll_fds, -1 si absent
+
+	public:
+		PollLoop();
+		virtual bool add(int fd, void *data, int events);
+		virtual bool modify(int fd, void *data, int events);
+		virtual void remove(int fd);
+		virtual int wait(std::vector<Event>& events, int timeout_ms);
+		virtual const char *name() const;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Reactor.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Reactor.hpp"
+#include <unistd.h> // close, pipe
+#include <fcntl.h> // fcntl
+#include <cerrno>
+#include <ctime>
+
+char Reactor::listener_tag;
+char Reactor::wakeup_tag;
+
+Reactor::Reactor(int id, int reactor_count) : id(id), listen_fd(-1), loop(NULL), thread(pthread_self()), stats(NULL), accept_pending(false), now_ms(0), timers(NULL), outbox(reactor_count)
+{
+	wake_pipe[0] = -1;
+	wake_pipe[1] = -1;
+	updateClock();
+	timers = new TimerWheel(now_ms);
+}
+
+Reactor::~Reactor()
+{
+	if (listen_fd != -1)
+		close(listen_fd);
+	if (wake_pipe[0] != -1)
+		close(wake_pipe[0]);
+	if (wake_pipe[1] != -1)
+		close(wake_pipe[1]);
+	delete loop;
+	delete timers;
+}
+
+bool Reactor::setup(int listen_fd, const std::string& backend)
+{
+	this->listen_fd = listen_fd;
+	if (pipe(wake_pipe) < 0)
+		return false;
+	fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+	loop = EventLoop::create(backend);
+	return loop->add(listen_fd, &listener_tag, EventLoop::EV_READ)
+		&& loop->add(wake_pipe[0], &wakeup_tag, EventLoop::EV_READ);
+}
+
+int Reactor::getId() const
+{
+	return id;
+}
+
+int Reactor::getListener() const
+{
+	return listen_fd;
+}
+
+EventLoop *Reactor::getLoop() const
+{
+	return loop;
+}
+
+std::vector<EventLoop::Event>& Reactor::getEvents()
+{
+	return events;
+}
+
+std::vector<Client*>& Reactor::getRemovals()
+{
+	return removals;
+}
+
+std::vector<Client*>& Reactor::getDirty()
+{
+	return dirty;
+}
+
+std::vector<std::string>& Reactor::getCommandParams()
+{
+	return command_params;
+}
+
+std::vector<Delivery>& Reactor::getInbox()
+{
+	return inbox;
+}
+
+std::vector<Client*>& Reactor::getBacklog()
+{
+	return backlog;
+}
+
+void Reactor::updateClock()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now_ms = static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t Reactor::getNow() const
+{
+	return now_ms;
+}
+
+TimerWheel& Reactor::getTimers()
+{
+	return *timers;
+}
+
+std::vector<Timer*>& Reactor::getExpired()
+{
+	return expired;
+}
+
+BufferPool& Reactor::getBuffers()
+{
+	return buffers;
+}
+
+// Les clients vivent dans la reserve du reacteur qui les a acceptes, et
+// c'est toujours lui qui les detruit
+Client *Reactor::createClient(int fd, const struct in_addr& address)
+{
+	Client *client = new (client_pool.allocate()) Client(fd, address);
+	client->setOwner(this);
+	return client;
+}
+
+void Reactor::destroyClient(Client *client)
+{
+	client->~Client();
+	client_pool.release(client);
+}
+
+void Reactor::setThread(pthread_t thread)
+{
+	this->thread = thread;
+}
+
+pthread_t Reactor::getThread() const
+{
+	return thread;
+}
+
+bool Reactor::isCurrentThread() const
+{
+	return pthread_equal(thread, pthread_self());
+}
+
+void Reactor::postLater(int target, ClientHandle handle, const SharedBuffer& message, bool close)
+{
+	Delivery delivery;
+	delivery.handle = handle;
+	delivery.message = message;
+	delivery.close = close;
+	outbox[target].push_back(delivery);
+}
+
+void Reactor::publishOutbox(const std::vector<Reactor*>& reactors)
+{
+	for (size_t i = 0; i < outbox.size(); ++i)
+	{
+		if (!outbox[i].empty())
+		{
+			reactors[i]->deliver(outbox[i]);
+			outbox[i].clear();
+		}
+	}
+}
+
+void Reactor::deliver(std::vector<Delivery>& batch)
+{
+	bool was_empty;
+	{
+		ScopedLock lock(mailbox_lock);
+		was_empty = mailbox.empty();
+		mailbox.insert(mailbox.end(), batch.begin(), batch.end());
+	}
+	// Un seul reveil tant que le destinataire n'a pas vide sa boite
+	if (was_empty)
+		wake();
+}
+
+void Reactor::takeMailbox(std::vector<Delivery>& out)
+{
+	out.clear();
+	ScopedLock lock(mailbox_lock);
+	out.swap(mailbox);
+}
+
+void Reactor::wake()
+{
+	char byte = 0;
+	while (write(wake_pipe[1], &byte, 1) < 0 && errno == EINTR)
+		;
+}
+
+void Reactor::drainWakeup()
+{
+	char buffer[64];
+	while (read(wake_pipe[0], buffer, sizeof(buffer)) > 0)
+		;
+}
@@ -0,0 +1,116 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Reactor.hpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+#include "EventLoop.hpp"
+#include "Client.hpp"
+#include "Mutex.hpp"
+#include "SharedBuffer.hpp"
+#include "Stats.hpp"
+#include "TimerWheel.hpp"
+#include "ObjectPool.hpp"
+#include "BufferPool.hpp"
+
+// Un message a remettre a un client d'un autre reacteur
+struct Delivery
+{
+	ClientHandle	handle;
+	SharedBuffer	message;
+	bool			close; // Fermer la connexion une fois le message en file
+};
+
+// Une boucle d'evenements et les connexions qu'elle possede. En mode
+// multi-thread chaque reacteur a son propre socket d'ecoute (SO_REUSEPORT) et
+// son thread ; seul ce thread touche aux sockets, tampons et files de ses
+// clients. Les autres reacteurs lui passent des messages via sa boite aux
+// lettres, qui le reveille par un pipe.
+class Reactor
+{
+	private:
+		friend class ServerSocketTest; // tests/test_server.cpp
+
+		int id;
+		int listen_fd;
+		EventLoop *loop;
+		int wake_pipe[2];
+		pthread_t thread;
+		StatsShard *stats; // Compteurs de ce reacteur dans le segment partage
+
+		std::vector<EventLoop::Event> events;
+		std::vector<Client*> removals; // Clients a fermer en fin d'iteration
+		std::vector<Client*> dirty; // Clients avec une sortie a envoyer
+		std::vector<Client*> backlog; // Entree non terminee : budget de lecture ou seau epuise
+		bool accept_pending; // Lot d'acceptation plafonne : la file du noyau n'est pas vide
+		uint64_t now_ms; // Horloge monotone, relue apres chaque attente
+		TimerWheel *timers; // Minuteries des clients de ce reacteur
+		std::vector<Timer*> expired; // Reutilise a chaque tour
+		std::vector<std::string> command_params; // Reutilise par handleCommand
+		ObjectPool<Client> client_pool; // Clients acceptes par ce reacteur
+		BufferPool buffers; // Blocs des messages construits ou liberes par ce thread
+
+		std::vector<std::vector<Delivery> > outbox; // par reacteur destinataire
+		Mutex mailbox_lock;
+		std::vector<Delivery> mailbox;
+		std::vector<Delivery> inbox; // Lot en cours de remise, reutilise
+
+		Reactor(const Reactor&);
+		Reactor& operator=(const Reactor&);
+
+	public:
+		static char listener_tag; // adresses sentinelles pour EventLoop::Event::data
+		static char wakeup_tag;
+
+		Reactor(int id, int reactor_count);
+		~Reactor();
+		bool setup(int listen_fd, const std::string& backend);
+
+		int getId() const;
+		int getListener() const;
+		EventLoop *getLoop() const;
+		std::vector<EventLoop::Event>& getEvents();
+		std::vector<Client*>& getRemovals();
+		std::vector<Client*>& getDirty();
+		std::vector<std::string>& getCommandParams();
+		std::vector<Delivery>& getInbox();
+		std::vector<Client*>& getBacklog();
+		bool isAcceptPending() const { return accept_pending; }
+		void setAcceptPending(bool pending) { accept_pending = pending; }
+		void updateClock();
+		uint64_t getNow() const;
+		TimerWheel& getTimers();
+		std::vector<Timer*>& getExpired();
+		BufferPool& getBuffers();
+		Client *createClient(int fd, const struct in_addr& address);
+		void destroyClient(Client *client);
+		StatsShard& getStats() { return *stats; }
+		void setStats(StatsShard *shard) { stats = shard; }
+
+		void setThread(pthread_t thread);
+		pthread_t getThread() const;
+		bool isCurrentThread() const;
+
+		// Cote emetteur : accumule, puis publie en un seul verrouillage par destinataire
+		void postLater(int target, ClientHandle handle, const SharedBuffer& message, bool close = false);
+		void publishOutbox(const std::vector<Reactor*>& reactors);
+		// Cote destinataire
+		void deliver(std::vector<Delivery>& batch);
+		void takeMailbox(std::vector<Delivery>& out);
+		void wake();
+		void drainWakeup();
+};
+
+#endif
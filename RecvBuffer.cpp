@@ -0,0 +1,104 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   RecvBuffer.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "RecvBuffer.hpp"
+#include <cstring>
+
+RecvBuffer::RecvBuffer() : start(0), end(0), scanned(0), discarding(false) {}
+
+char *RecvBuffer::writePtr()
+{
+	return data + end;
+}
+
+size_t RecvBuffer::writable() const
+{
+	return CAPACITY - end;
+}
+
+void RecvBuffer::commit(size_t n)
+{
+	end += n;
+}
+
+size_t RecvBuffer::pending() const
+{
+	return end - start;
+}
+
+const char *RecvBuffer::pendingData() const
+{
+	return data + start;
+}
+
+bool RecvBuffer::isDiscarding() const
+{
+	return discarding;
+}
+
+void RecvBuffer::setDiscarding(bool value)
+{
+	discarding = value;
+}
+
+void RecvBuffer::compact()
+{
+	if (start == 0)
+		return;
+	std::memmove(data, data + start, end - start);
+	end -= start;
+	scanned -= start;
+	start = 0;
+}
+
+RecvBuffer::LineStatus RecvBuffer::nextLine(const char *&line, size_t &len)
+{
+	while (true)
+	{
+		// memchr est vectorise par la libc ; on ne rescanne jamais les memes octets
+		const char *nl = static_cast<const char*>(std::memchr(data + scanned, '\n', end - scanned));
+		if (nl == NULL)
+		{
+			scanned = end;
+			if (end - start >= MAX_LINE)
+			{
+				// Pas de fin de ligne dans la limite : on jette et on ignore la suite
+				bool report = !discarding;
+				discarding = true;
+				start = 0;
+				end = 0;
+				scanned = 0;
+				if (report)
+					return LINE_TOO_LONG;
+				continue;
+			}
+			compact();
+			return LINE_NONE;
+		}
+		size_t line_start = start;
+		size_t line_end = nl - data;
+		start = line_end + 1;
+		scanned = start;
+		if (discarding)
+		{
+			discarding = false;
+			continue;
+		}
+		if (line_end > line_start && data[line_end - 1] == '\r')
+			--line_end;
+		if (line_end - line_start > MAX_LINE - 2)
+			return LINE_TOO_LONG;
+		line = data + line_start;
+		len = line_end - line_start;
+		return LINE_OK;
+	}
+}
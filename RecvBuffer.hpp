@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   RecvBuffer.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef RECVBUFFER_HPP
+#define RECVBUFFER_HPP
+
+#include <cstddef>
+
+// Tampon de reception d'un client. recv() ecrit directement dedans, et les
+// lignes sont rendues en place (pointeur + longueur), sans copie. Seule la
+// ligne incomplete restante est ramenee en tete du tampon.
+class RecvBuffer
+{
+	public:
+		enum
+		{
+			CAPACITY = 2048,
+			MAX_LINE = 512 // RFC 1459, CR LF compris
+		};
+		enum LineStatus
+		{
+			LINE_NONE, // pas de ligne complete pour l'instant
+			LINE_OK,
+			LINE_TOO_LONG // ligne ignoree (> MAX_LINE)
+		};
+
+		RecvBuffer();
+		char *writePtr();
+		size_t writable() const;
+		void commit(size_t n);
+		// Ligne suivante, sans "\r\n" (ou "\n" seul) ; valide jusqu'au prochain appel
+		LineStatus nextLine(const char *&line, size_t &len);
+		size_t pending() const;
+		// Donnees non consommees, pour le passage de relais (SIGUSR2)
+		const char *pendingData() const;
+		bool isDiscarding() const;
+		void setDiscarding(bool value);
+
+	private:
+		char data[CAPACITY];
+		size_t start; // debut de la ligne en cours
+		size_t end; // fin des donnees recues
+		size_t scanned; // deja parcouru sans trouver de '\n'
+		bool discarding; // on saute la fin d'une ligne trop longue
+
+		void compact();
+};
+
+#endif
@@ -12,119 +12,434 @@
 
 #include "ServerSocket.hpp"
 #include "Client.hpp"
+#include "Casemap.hpp"
+#include "Reactor.hpp"
+#include "Logger.hpp"
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <cctype> // toupper
+#include <cerrno>
 #include <unistd.h> // close
-#include <arpa/inet.h> // inet_ntop
-#include <poll.h>
+#include <fcntl.h> // fcntl
+#include <netinet/tcp.h> // TCP_NODELAY
 #include <algorithm> // std::find_if
 #include <csignal>
+#include <cstdlib> // getenv
+#include <sys/socket.h> // socketpair
+#include <sys/wait.h> // waitpid
+#include <sys/resource.h> // getrlimit
+#include <sys/syscall.h> // close_range
+
+extern char **environ;
 
 //----------------------CONSTRUCTOR-AND-DESTRUCTOR-----------------------------------------
 
 ServerSocket* ServerSocket::_ptrServer = NULL;
+volatile sig_atomic_t ServerSocket::_stopRequested = 0;
+volatile sig_atomic_t ServerSocket::_upgradeRequested = 0;
 
-ServerSocket::ServerSocket(const std::string& password) : server_password(password), server_socket(-1)
+ServerSocket::ServerSocket(const std::string& password, const Config& config) : server_password(password), server_socket(-1), program_argv(NULL), config(config), delivery_mark(0)
 {
 	std::memset(&server_addr, 0, sizeof(server_addr));
+	pthread_key_create(&reactor_key, NULL);
+	if (config.history_lines > 0)
+		history_arena.init(config.history_memory);
+	limiter.configure(config.ip_max_connections, config.ip_connect_rate, config.ip_connect_burst,
+		config.ip_cidr, config.ip_exempt);
 	_ptrServer = this;
 }
 
 ServerSocket::~ServerSocket()
 {
-	if (server_socket != -1)
-		close(server_socket);
-	for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
-		delete *it;
-	for (std::vector<struct pollfd>::iterator it = poll_fds.begin(); it != poll_fds.begin(); it++)
-		close(it->fd);
+	for (size_t i = 0; i < reactors.size(); ++i)
+		reapClients(*reactors[i]);
+	while (clients.size() > 0)
+	{
+		Client *client = clients.at(clients.size() - 1);
+		clients.remove(client);
+		close(client->getFd());
+		client->getOwner()->destroyClient(client);
+	}
+	// Utilisateurs distants : hors de la table, et a nous seuls
+	const std::vector<LinkedServer*>& servers = network.getServers();
+	for (size_t i = 0; i < servers.size(); ++i)
+		for (size_t j = 0; j < servers[i]->users.size(); ++j)
+			delete servers[i]->users[j];
+	// Les messages encore en boite aux lettres seront liberes hors reserve
+	BufferPool::bind(NULL);
+	// Les reacteurs ferment leur socket d'ecoute, dont server_socket
+	for (size_t i = 0; i < reactors.size(); ++i)
+		delete reactors[i];
+	pthread_key_delete(reactor_key);
 }
 
 //----------------------SETUP-----------------------------------------
 
-bool ServerSocket::setup(int port)
+static bool setNonBlocking(int fd)
 {
-	std::cerr << "Setting up server on port " << port << std::endl;
-	server_socket = socket(AF_INET, SOCK_STREAM, 0);
-	if (server_socket < 0)
+	return fcntl(fd, F_SETFL, O_NONBLOCK) == 0;
+}
+
+int ServerSocket::createListener(int port, bool reuse_port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
 	{
-		std::cerr << "Socket creation error" << std::endl;
-		return false;
+		LOG_ERROR << "Socket creation error";
+		return -1;
 	}
 	int opt = 1;
-	if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0)
 	{
-		std::cerr << "Set socket options error" << std::endl;
-		return false;
+		LOG_ERROR << "Set socket options error";
+		close(fd);
+		return -1;
+	}
+	if (reuse_port)
+	{
+#ifdef SO_REUSEPORT
+		// Un socket d'ecoute par reacteur : le noyau repartit les connexions
+		if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+#endif
+		{
+			LOG_ERROR << "SO_REUSEPORT unavailable";
+			close(fd);
+			return -1;
+		}
 	}
 	server_addr.sin_family = AF_INET;
 	server_addr.sin_addr.s_addr = INADDR_ANY;
 	server_addr.sin_port = htons(port);
-	if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0)
+	if (bind(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0)
 	{
-		std::cerr << "Bind error" << std::endl;
-		return false;
+		LOG_ERROR << "Bind error";
+		close(fd);
+		return -1;
 	}
-	if (listen(server_socket, 10) < 0)
+	if (listen(fd, config.listen_backlog) < 0)
 	{
-		std::cerr << "Listen error" << std::endl;
-		return false;
+		LOG_ERROR << "Listen error";
+		close(fd);
+		return -1;
 	}
-	struct pollfd server_pollfd;
-	server_pollfd.fd = server_socket;
-	server_pollfd.events = POLLIN;
 
-	#ifdef __APPLE__
-    // Définir le socket du serveur en mode non bloquant pour MacOS
-    fcntl(server_socket, F_SETFL, O_NONBLOCK);
-    #endif
+	// Le backend epoll est edge-triggered : le socket d'ecoute doit etre non bloquant
+	setNonBlocking(fd);
+	return fd;
+}
+
+// Lance par un relais (SIGUSR2), le processus reprend les sockets d'ecoute
+// et les clients de son predecesseur au lieu d'en ouvrir de nouveaux.
+bool ServerSocket::setup(int port)
+{
+	LOG_INFO << "Setting up server on port " << port;
+	int channel = -1;
+	std::vector<int> inherited;
+	std::string state;
+	if (const char *handoff = std::getenv(Handoff::ENV_NAME))
+	{
+		channel = std::atoi(handoff);
+		unsetenv(Handoff::ENV_NAME);
+		if (!Handoff::receive(channel, inherited, state))
+		{
+			LOG_ERROR << "Failed to receive state from the previous process";
+			close(channel);
+			return false;
+		}
+	}
+	StateReader reader(state);
+	int state_version = 0;
+	size_t listener_count = 0;
+	if (channel >= 0)
+	{
+		std::string format = reader.getString();
+		if (format.compare(0, 14, "IRCSERV-STATE-") == 0 && format.size() == 15)
+			state_version = format[14] - '0';
+		if (state_version < 2 || state_version > STATE_VERSION)
+		{
+			LOG_ERROR << "Unknown state format from the previous process";
+			close(channel);
+			return false;
+		}
+		listener_count = std::min(static_cast<size_t>(reader.getU32()), inherited.size());
+	}
+	// Moins de reacteurs qu'avant : les sockets d'ecoute en trop sont fermees
+	for (size_t i = config.threads; i < listener_count; ++i)
+		close(inherited[i]);
+	for (size_t i = 0; i < config.threads; ++i)
+	{
+		int listen_fd = i < listener_count ? inherited[i] : createListener(port, config.threads > 1);
+		if (listen_fd < 0)
+			return false;
+		// Un socket herite garde sa file ; listen() a nouveau applique listen_backlog
+		if (i < listener_count && listen(listen_fd, config.listen_backlog) < 0)
+		{
+			LOG_ERROR << "Listen error on inherited socket: " << std::strerror(errno);
+			close(listen_fd);
+			return false;
+		}
+		Reactor *reactor = new Reactor(i, config.threads);
+		reactors.push_back(reactor);
+		if (!reactor->setup(listen_fd, config.backend))
+		{
+			LOG_ERROR << "Event loop registration error";
+			return false;
+		}
+	}
+	server_socket = reactors[0]->getListener();
+	if (!openStats(port))
+		return false;
+	if (config.server_name.empty())
+	{
+		std::ostringstream name;
+		name << "irc-" << port << ".local";
+		config.server_name = name.str();
+	}
+	for (size_t i = 0; i < config.link_connect.size(); ++i)
+	{
+		OutgoingLink link;
+		link.peer = config.link_connect[i];
+		link.handle.fd = -1;
+		link.handle.generation = 0;
+		link.retry_ms = 0;
+		outgoing.push_back(link);
+	}
 
 	std::signal(SIGINT, closeServer);
 	std::signal(SIGQUIT, closeServer);
-	poll_fds.push_back(server_pollfd);
-	std::cerr << "Server setup complete" << std::endl;
+	// Apres un relais, l'etat transmis fait foi : le disque n'est que relu
+	if (!openChannelStore(channel < 0))
+		return false;
+
+	std::signal(SIGUSR2, upgradeServer);
+	std::signal(SIGPIPE, SIG_IGN); // Les erreurs d'ecriture sont gerees via send()
+	if (channel >= 0)
+	{
+		bool restored = restoreState(reader, inherited, state_version);
+		if (restored)
+			Handoff::sendReady(channel);
+		close(channel);
+		if (!restored)
+		{
+			LOG_ERROR << "Corrupted state from the previous process";
+			return false;
+		}
+		LOG_INFO << "Resumed " << clients.size() << " connection(s) and " << channels.size() << " channel(s)";
+	}
+	LOG_INFO << "Server setup complete (" << reactors[0]->getLoop()->name() << " backend, "
+		<< reactors.size() << " reactor(s), " << config.server_name << ")";
+	return true;
+}
+
+bool ServerSocket::openStats(int port)
+{
+	std::string path;
+	if (config.stats == "auto")
+	{
+		std::ostringstream default_path;
+		default_path << "/tmp/ircserv-" << port << ".stats";
+		path = default_path.str();
+	}
+	else if (config.stats != "off")
+		path = config.stats;
+
+	std::vector<std::string> names;
+	for (size_t i = 0; i < command_count; ++i)
+		names.push_back(command_table[i].name);
+	if (!stats.open(path, reactors.size(), names))
+	{
+		LOG_ERROR << "Stats segment allocation error";
+		return false;
+	}
+	for (size_t i = 0; i < reactors.size(); ++i)
+		reactors[i]->setStats(&stats.shard(i));
+	if (!stats.getPath().empty())
+		LOG_INFO << "Stats segment at " << stats.getPath();
+	return true;
+}
+
+// Canaux relus du disque : sans membres, leurs operateurs retrouvent leur
+// statut en revenant
+bool ServerSocket::openChannelStore(bool create_channels)
+{
+	if (config.channel_store == "off")
+		return true;
+	std::vector<ChannelRecord> records;
+	if (!channel_store.open(config.channel_store, records))
+	{
+		LOG_ERROR << "Failed to load channel store " << config.channel_store;
+		return false;
+	}
+	if (!create_channels)
+		return true;
+	const Channel::Mode all_modes[] = { Channel::MODE_INVITE, Channel::MODE_TOPIC, Channel::MODE_KEY, Channel::MODE_LIMIT };
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const ChannelRecord& record = records[i];
+		if (channels.find(record.name) != NULL)
+			continue;
+		Channel *channel = channels.create(record.name);
+		for (size_t m = 0; m < sizeof(all_modes) / sizeof(all_modes[0]); ++m)
+			channel->setMode(all_modes[m], (record.modes & all_modes[m]) != 0);
+		channel->setKey(record.key);
+		channel->setLimit(record.limit);
+		if (record.has_topic)
+			channel->setTopic(record.topic, record.topic_set_by, record.topic_time);
+		for (size_t j = 0; j < record.invitations.size(); ++j)
+			channel->addInvitation(record.invitations[j]);
+		for (size_t j = 0; j < record.operators.size(); ++j)
+			channel->addPendingOperator(record.operators[j]);
+		channel->setPersistedHash(ChannelStore::fingerprint(record));
+	}
+	stats.header().channels = channels.size();
+	LOG_INFO << "Loaded " << records.size() << " channel(s) from " << config.channel_store;
 	return true;
 }
 
 void	ServerSocket::closeServer(int signal)
 {
 	(void)signal;
-	close(_ptrServer->server_socket);
+	_stopRequested = 1;
+}
+
+void	ServerSocket::upgradeServer(int signal)
+{
+	(void)signal;
+	_upgradeRequested = 1;
+	_stopRequested = 1;
+}
+
+// execve() ne cherche pas dans le PATH : un binaire lance par son seul nom
+// est resolu ici, une fois pour toutes. Le chemin n'est pas canonicalise,
+// pour qu'un lien symbolique remplace entre-temps designe bien le nouveau binaire.
+void ServerSocket::setProgram(char **argv)
+{
+	program_argv = argv;
+	program_path = argv[0];
+	if (program_path.find('/') != std::string::npos)
+		return;
+	const char *path = std::getenv("PATH");
+	std::string dirs = path != NULL ? path : "/usr/bin:/bin";
+	size_t start = 0;
+	while (start <= dirs.size())
+	{
+		size_t end = dirs.find(':', start);
+		if (end == std::string::npos)
+			end = dirs.size();
+		std::string dir = end > start ? dirs.substr(start, end - start) : ".";
+		std::string candidate = dir + "/" + argv[0];
+		if (access(candidate.c_str(), X_OK) == 0)
+		{
+			program_path = candidate;
+			return;
+		}
+		start = end + 1;
+	}
 }
 
 //----------------------ACCEPT-CONNECTION-----------------------------------------
 
-int ServerSocket::acceptConnection()
+// Vide la file d'acceptation du noyau jusqu'a EAGAIN, mais au plus
+// accept_batch connexions par tour pour ne pas affamer les clients deja
+// connectes. Au-dela, la suite est prise au tour suivant sans attendre : en
+// edge-triggered, le socket d'ecoute ne serait pas signale une nouvelle fois.
+void ServerSocket::acceptBatch(Reactor& reactor)
+{
+	StatsShard& counters = reactor.getStats();
+	++counters.accept_batches;
+#ifdef __linux__
+	// Sur un socket d'ecoute, tcpi_unacked est la longueur de la file d'acceptation
+	struct tcp_info info;
+	socklen_t info_len = sizeof(info);
+	if (getsockopt(reactor.getListener(), IPPROTO_TCP, TCP_INFO, &info, &info_len) == 0
+		&& info.tcpi_unacked > counters.accept_queue_peak)
+		counters.accept_queue_peak = info.tcpi_unacked;
+#endif
+	size_t accepted = 0;
+	while (accepted < config.accept_batch && acceptConnection(reactor))
+		++accepted;
+	reactor.setAcceptPending(accepted == config.accept_batch);
+	if (reactor.isAcceptPending())
+		++counters.accept_capped;
+}
+
+// Faux quand le lot doit s'arreter : file vide ou manque de ressources
+bool ServerSocket::acceptConnection(Reactor& reactor)
 {
-	std::cerr << "Accepting new connection" << std::endl;
 	struct sockaddr_in client_addr;
-	socklen_t addr_len = sizeof(client_addr);
-	int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &addr_len);
+	int client_socket = reactor.getLoop()->accept(reactor.getListener(), client_addr);
 	if (client_socket < 0) {
-		std::cerr << "Accept error" << std::endl;
-		return -1;
+		// Connexion abandonnee par le pair avant accept() : on passe a la suivante
+		if (errno == ECONNABORTED || errno == EINTR)
+			return true;
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			++reactor.getStats().accept_errors;
+			LOG_WARN << "Accept error: " << std::strerror(errno);
+		}
+		return false;
 	}
 
-	#ifdef __APPLE__
-    // Définir le socket client en mode non bloquant pour MacOS
-    fcntl(client_socket, F_SETFL, O_NONBLOCK);
-    #endif
+	// Refus avant toute allocation : un mot d'explication, tente une seule
+	// fois sans bloquer, puis fermeture. Compte mais pas journalise, pour
+	// qu'un hote abusif ne remplisse pas non plus le journal.
+	ConnectionLimiter::Verdict verdict = limiter.admit(client_addr.sin_addr, reactor.getNow());
+	if (verdict != ConnectionLimiter::ACCEPT)
+	{
+		static const char too_many[] = "ERROR :Too many connections from your host\r\n";
+		static const char too_fast[] = "ERROR :Reconnecting too fast, try again later\r\n";
+		if (verdict == ConnectionLimiter::TOO_MANY)
+		{
+			++reactor.getStats().rejected_ip_limit;
+			send(client_socket, too_many, sizeof(too_many) - 1, MSG_DONTWAIT);
+		}
+		else
+		{
+			++reactor.getStats().rejected_ip_rate;
+			send(client_socket, too_fast, sizeof(too_fast) - 1, MSG_DONTWAIT);
+		}
+		close(client_socket);
+		return true;
+	}
 
-	char str[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &(client_addr.sin_addr), str, INET_ADDRSTRLEN);
-	std::string client_address(str);
+#ifndef SOCK_NONBLOCK
+	// Non bloquant sur toutes les plateformes : lecture jusqu'a EAGAIN pour le
+	// backend edge-triggered, et envoi via la file de sortie du client
+	if (!setNonBlocking(client_socket))
+	{
+		LOG_WARN << "Failed to set client socket non-blocking";
+		close(client_socket);
+		return true;
+	}
+#endif
 
-	Client* new_client = new Client(client_socket, client_address);
-	clients.push_back(new_client);
+	// La sortie est deja regroupee par tour de boucle (un writev par client) :
+	// Nagle n'ajouterait que de la latence
+	int nodelay = 1;
+	setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
 
-	struct pollfd client_pollfd;
-	client_pollfd.fd = client_socket;
-	client_pollfd.events = POLLIN;
-	poll_fds.push_back(client_pollfd);
+	Client* new_client = reactor.createClient(client_socket, client_addr.sin_addr);
+	new_client->getBucket().reset(reactor.getNow(), config.flood_burst);
+	new_client->touch(reactor.getNow());
+	if (!reactor.getLoop()->add(client_socket, new_client, EventLoop::EV_READ))
+	{
+		LOG_ERROR << "Event loop registration error";
+		close(client_socket);
+		limiter.release(new_client->getAddr());
+		reactor.destroyClient(new_client);
+		return true;
+	}
+	// Seulement une fois le client garde : sa minuterie vit dans son bloc
+	reactor.getTimers().schedule(&new_client->getTimer(), reactor.getNow() + config.registration_timeout * 1000);
+	{
+		ExclusiveLock lock(state_lock);
+		clients.insert(new_client);
+	}
+	++reactor.getStats().accepted;
 
-	std::cerr << "New connection accepted: " << client_address << std::endl;
-	return client_socket;
+	LOG_INFO << "New connection accepted: " << new_client->getAddress() << " (fd " << client_socket << ", reactor " << reactor.getId() << ")";
+	return true;
 }
 
 //----------------------GET-SOCKET-----------------------------------------
@@ -136,884 +451,2918 @@ int ServerSocket::getSocket() const
 
 //----------------------HANDLE-CLIENT-----------------------------------------
 
-void ServerSocket::handleClient(int index)
+// Lecture bornee par read_budget : au-dela, le client passe en liste
+// d'attente et sera repris au tour suivant, apres les autres sockets.
+void ServerSocket::handleClient(Client *client)
 {
-	std::cerr << "Handling client at index " << index << std::endl;
-	if (index < 0 || static_cast<std::vector<Client*>::size_type>(index) >= clients.size())
-	{
-		std::cerr << "Invalid client index: " << index << std::endl;
-		return;
-	}
-	char buffer[1024];
-	int nbytes = recv(clients[index]->getFd(), buffer, sizeof(buffer), 0);
-	if (nbytes <= 0)
+	LOG_DEBUG << "Handling client fd " << client->getFd();
+	RecvBuffer& input = client->getRecvBuffer();
+	size_t budget = config.read_budget;
+	// Lignes laissees en attente par le controle de flood
+	if (input.pending() > 0)
+		processInput(client);
+	// Edge-triggered : on vide le socket jusqu'a EAGAIN
+	while (!client->isClosing() && !client->isReadPaused())
 	{
-		std::cerr << "Client disconnected or recv error" << std::endl;
-		removeClient(index);
+		if (budget == 0)
+		{
+			deferInput(client);
+			return;
+		}
+		// recv() ecrit directement dans le tampon du client, sans copie intermediaire
+		// (io_uring : copie depuis le tampon fourni ou le noyau a deja recu)
+		ssize_t nbytes = client->getOwner()->getLoop()->receive(client->getFd(), input.writePtr(),
+			std::min(input.writable(), budget));
+		if (nbytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (nbytes < 0 && errno == EINTR)
+			continue;
+		if (nbytes <= 0)
+		{
+			LOG_INFO << "Client fd " << client->getFd() << " disconnected or recv error";
+			disconnect(client);
+			break;
+		}
+		budget -= nbytes;
+		input.commit(nbytes);
+		client->getOwner()->getStats().bytes_in += nbytes;
+		processInput(client);
 	}
-	else
+	// Seau vide : les donnees restent dans le noyau jusqu'au remplissage
+	if (client->isReadPaused() && !client->isClosing())
 	{
-		std::string command(buffer, nbytes);
-		std::cerr << "Received command: " << command << std::endl;
-		handleCommand(index, command);
+		++client->getOwner()->getStats().throttled;
+		updateInterest(client);
+		deferInput(client);
 	}
 }
 
-//----------------------REMOVE-CLIENT-----------------------------------------
+void ServerSocket::deferInput(Client *client)
+{
+	if (client->isBacklogged())
+		return;
+	client->setBacklogged(true);
+	client->getOwner()->getBacklog().push_back(client);
+}
 
-void ServerSocket::removeClient(int index)
+// Reprend les clients en attente : budget de lecture epuise au tour
+// precedent, ou seau de nouveau disponible.
+void ServerSocket::processBacklog(Reactor& reactor)
 {
-	std::cerr << "Removing client at index " << index << std::endl;
-	if (index < 0 || static_cast<std::vector<Client*>::size_type>(index) >= clients.size())
-	{
-		std::cerr << "Invalid client index: " << index << std::endl;
+	if (reactor.getBacklog().empty())
 		return;
-	}
-	if (clients[index] != NULL)
+	std::vector<Client*> pending;
+	pending.swap(reactor.getBacklog());
+	for (size_t i = 0; i < pending.size(); ++i)
 	{
-		close(clients[index]->getFd());
-		delete clients[index];
-		clients.erase(clients.begin() + index);
-		poll_fds.erase(poll_fds.begin() + index + 1); // Ajuster pour le socket du serveur
-	}
-	else
-	{
-		std::cerr << "Client already removed" << std::endl;
+		Client *client = pending[i];
+		client->setBacklogged(false);
+		if (client->isClosing())
+			continue;
+		if (client->isReadPaused())
+		{
+			if (!client->getBucket().ready(reactor.getNow(), config.flood_rate, config.flood_burst))
+			{
+				deferInput(client);
+				continue;
+			}
+			client->setReadPaused(false);
+			updateInterest(client);
+		}
+		handleClient(client);
 	}
 }
 
-//----------------------SEND-TO-CLIENT-----------------------------------------
-
-void ServerSocket::sendToClient(int index, const std::string& message)
+// Attente maximale de la boucle : immediate s'il reste de l'entree a
+// traiter, sinon jusqu'au prochain remplissage d'un seau.
+int ServerSocket::backlogTimeout(Reactor& reactor)
 {
-	std::cerr << "Sending message to client at index " << index << ": " << message << std::endl;
-	if (index < 0 || static_cast<std::vector<Client*>::size_type>(index) >= clients.size())
+	std::vector<Client*>& backlog = reactor.getBacklog();
+	if (backlog.empty())
+		return -1;
+	uint64_t timeout = 1000;
+	for (size_t i = 0; i < backlog.size(); ++i)
 	{
-		std::cerr << "Invalid client index: " << index << std::endl;
-		return;
+		if (!backlog[i]->isReadPaused())
+			return 0;
+		timeout = std::min(timeout, backlog[i]->getBucket().msUntilReady(config.flood_rate));
 	}
-	send(clients[index]->getFd(), message.c_str(), message.size(), 0);
+	return timeout;
 }
 
-//----------------------RUN-LOOP-----------------------------------------
-
-void ServerSocket::run()
+// Decoupe les lignes completes du tampon et les traite une par une. Le
+// decoupage, l'analyse et le controle de flood ne concernent que le client
+// et se font hors verrou : state_lock n'est pris que pour executer chaque
+// commande. Aucun appel systeme n'est fait sous le verrou.
+void ServerSocket::processInput(Client *client)
 {
-	while (true)
+	RecvBuffer& input = client->getRecvBuffer();
+	const char *line;
+	size_t len;
+	RecvBuffer::LineStatus status;
+	uint64_t now = client->getOwner()->getNow();
+	while (!client->isClosing())
 	{
-		int poll_count = poll(poll_fds.data(), poll_fds.size(), -1);
-		if (poll_count < 0)
+		// Seau vide : le reste attendra, rien n'est perdu. Une liaison porte
+		// le trafic de tout un serveur : jamais bridee.
+		if (!client->isLink() && !client->getBucket().ready(now, config.flood_rate, config.flood_burst))
 		{
-			std::cerr << "Poll error" << std::endl;
+			client->setReadPaused(true);
 			break;
 		}
-
-		for (size_t i = 0; i < poll_fds.size(); ++i)
+		if ((status = input.nextLine(line, len)) == RecvBuffer::LINE_NONE)
+			break;
+		if (status == RecvBuffer::LINE_TOO_LONG)
 		{
-			if (poll_fds[i].revents & POLLIN)
-			{
-				if (poll_fds[i].fd == server_socket)
-				{
-					acceptConnection();
-				}
-				else
-				{
-					int client_index = i - 1;
-					handleClient(client_index);
-				}
-			}
+			client->getBucket().consume(1);
+			SharedLock lock(state_lock);
+			sendToClient(client, MessageBuilder() << "417 " << (client->isNickSet() ? client->getNickname() : std::string("*")) << " :Input line was too long\r\n");
+			continue;
+		}
+		++client->getOwner()->getStats().lines_in;
+		client->touch(now);
+		IrcMessage message;
+		if (!parseIrcMessage(line, len, message))
+			continue;
+		LOG_DEBUG << "Received command from fd " << client->getFd() << ": " << LogBytes(line, len);
+		if (client->isLink())
+		{
+			ExclusiveLock lock(state_lock);
+			handleLinkMessage(client, line, len, message);
 		}
+		else
+			handleCommand(client, message);
 	}
 }
 
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-//-----------------------------------------------------------------------------
-
-
-//-----------------HANDLE-COMMAND-----------------------------------------
+//----------------------REMOVE-CLIENT-----------------------------------------
 
-void ServerSocket::handleCommand(int client_index, const std::string& command)
+// Le client est seulement marque ici : la fermeture effective a lieu dans
+// reapClients(), une fois tous les evenements de l'iteration traites, pour que
+// les pointeurs de l'iteration courante restent valides.
+void ServerSocket::removeClient(ClientHandle handle)
 {
-	std::istringstream stream(command);
-	std::string line;
-	std::string previous_line;
-
-	// Diviser la chaîne en plusieurs commandes si elle contient des nouvelles lignes
-	while (std::getline(stream, line))
+	LOG_DEBUG << "Removing client fd " << handle.fd;
+	Client *client = clients.get(handle);
+	if (client == NULL)
 	{
-		std::string	buffer = clients[client_index]->getBuffer();
-		std::string new_line = line;
-		if (line.empty())
-			continue;
-		if (!buffer.empty())
-			line.insert(0, buffer);
-		if (line[line.length() - 1] != '\r')
-		{
-			clients[client_index]->addToBuffer(new_line);
-			continue;
-		}
-		else
-			clients[client_index]->clearBuffer();
-		if (line == previous_line)
-		{
-			continue; // Éviter les doublons
-		}
-		previous_line = line;
-		std::cerr << "Received command: " << line << std::endl;
-		std::istringstream iss(line);
-		std::string cmd;
-		std::vector<std::string> params;
-		iss >> cmd;
-		std::string param;
-		while (iss >> param)
-		{
-			params.push_back(param);
-		}
-
-		if (cmd == "PASS")
-		{
-			commandPass(client_index, params);
-			// Après avoir traité le PASS, vérifiez si le client peut être enregistré
-			if (clients[client_index]->isNickSet() && clients[client_index]->isUserSet() && !clients[client_index]->isFullyRegistered() && clients[client_index]->isAuthenticated())
-			{
-				clients[client_index]->setRegistered(true);
-				sendToClient(client_index, "001 " + clients[client_index]->getNickname() + " :Welcome to the IRC server\r\n");
-				std::cerr << "Client fully registered after PASS command" << std::endl;
-			}
-			continue;
-		}
+		LOG_DEBUG << "Invalid client handle: " << handle.fd;
+		return;
+	}
+	disconnect(client);
+}
 
-		// Traiter les commandes NICK et USER en premier
-		if (cmd == "NICK")
-		{
-			commandNick(client_index, params);
-			// Après avoir traité le NICK, vérifiez si le client peut être enregistré
-			if (clients[client_index]->isNickSet() && clients[client_index]->isUserSet() && !clients[client_index]->isFullyRegistered() && clients[client_index]->isAuthenticated())
-			{
-				clients[client_index]->setRegistered(true);
-				sendToClient(client_index, "001 " + clients[client_index]->getNickname() + " :Welcome to the IRC server\r\n");
-				std::cerr << "Client fully registered after NICK command" << std::endl;
-			}
-			continue;
-		}
-		else if (cmd == "USER")
-		{
-			commandUser(client_index, params);
-			// Après avoir traité le USER, vérifiez si le client peut être enregistré
-			if (clients[client_index]->isNickSet() && clients[client_index]->isUserSet() && !clients[client_index]->isFullyRegistered() && clients[client_index]->isAuthenticated())
-			{
-				clients[client_index]->setRegistered(true);
-				sendToClient(client_index, "001 " + clients[client_index]->getNickname() + " :Welcome to the IRC server\r\n");
-				std::cerr << "Client fully registered after USER command" << std::endl;
-			}
-			continue;
-		}
+// Toujours appele par le reacteur proprietaire du client
+void ServerSocket::disconnect(Client *client)
+{
+	if (client->isClosing())
+	{
+		LOG_DEBUG << "Client already removed";
+		return;
+	}
+	client->setClosing();
+	client->getOwner()->getRemovals().push_back(client);
+}
 
-		// Traiter la commande CAP
-		if (cmd == "CAP")
+void ServerSocket::reapClients(Reactor& reactor)
+{
+	std::vector<Client*>& removals = reactor.getRemovals();
+	if (removals.empty())
+		return;
+	{
+		// Une fois retire de la table et des canaux, plus aucun autre
+		// reacteur ne peut atteindre le client
+		ExclusiveLock lock(state_lock);
+		for (size_t i = 0; i < removals.size(); ++i)
 		{
-			if (params.size() > 0 && params[0] == "LS")
+			Client *client = removals[i];
+			if (client->isLink())
 			{
-				sendToClient(client_index, "CAP * LS :\r\n");
-				continue;
+				// Tout ce qui etait joint par cette liaison disparait avec elle
+				links.erase(std::find(links.begin(), links.end(), client));
+				LinkedServer *server = client->getServer();
+				LOG_INFO << "Link with " << server->name << " closed";
+				splitServer(server, config.server_name + " " + server->name);
 			}
-			else if (params.size() > 0 && params[0] == "END")
+			else if (client->isNickSet())
 			{
-				std::cerr << "Handling CAP END, checking registration status..." << std::endl;
-				if (clients[client_index]->isNickSet() && clients[client_index]->isUserSet() && !clients[client_index]->isFullyRegistered() && clients[client_index]->isAuthenticated())
-				{
-					clients[client_index]->setRegistered(true);
-					sendToClient(client_index, "001 " + clients[client_index]->getNickname() + " :Welcome to the IRC server\r\n");
-					std::cerr << "Client fully registered after CAP END" << std::endl;
-				}
-				continue;
+				// Parti sans QUIT : le reseau l'apprend ici
+				if (!links.empty() && client->isFullyRegistered() && findClientByNickname(client->getNickname()) == client)
+					propagate((MessageBuilder() << ':' << client->getNickname() << " QUIT :Connection closed\r\n").share(), NULL);
+				forgetUser(client);
 			}
+			detachFromChannels(client);
+			clients.remove(client);
 		}
-
-		// Vérifier si le client est enregistré
-		if (!clients[client_index]->isAuthenticated())
-		{
-			sendToClient(client_index, "464 :Password required\r\n");
-			continue;
-		}
-
-		if (!clients[client_index]->isFullyRegistered())
+	}
+	for (size_t i = 0; i < removals.size(); ++i)
+	{
+		Client *client = removals[i];
+		// Derniere tentative pour les messages d'adieu (ERROR, 464...)
+		reactor.getTimers().cancel(&client->getTimer());
+		if (client->isBacklogged())
 		{
-			sendToClient(client_index, "451 :You have not registered\r\n");
-			continue;
+			std::vector<Client*>& backlog = reactor.getBacklog();
+			backlog.erase(std::find(backlog.begin(), backlog.end(), client));
 		}
+		if (client->hasPendingOutput())
+			writeOutput(client);
+		reactor.getStats().sendq_bytes -= client->pendingBytes();
+		++reactor.getStats().closed;
+		reactor.getLoop()->remove(client->getFd());
+		close(client->getFd());
+		limiter.release(client->getAddr());
+		reactor.destroyClient(client);
+	}
+	removals.clear();
+}
 
-		// Traiter les autres commandes
-		if (cmd == "JOIN")
-			commandJoin(client_index, params);
-		else if (cmd == "PRIVMSG")
-			commandPrivmsg(client_index, params);
-		else if (cmd == "KICK")
-			commandKick(client_index, params);
-		else if (cmd == "INVITE")
-			commandInvite(client_index, params);
-		else if (cmd == "TOPIC")
-			commandTopic(client_index, params);
-		else if (cmd == "QUIT")
-			commandQuit(client_index, params);
-		else if (cmd == "MODE")
-		{
-			if (params.size() > 0 && clients[client_index]->getNickname() == params[0])
-			{
-				sendToClient(client_index, "MODE " + params[0] + " :" + params[1] + "\r\n");
-			}
-			else
-			{
-				// Traiter le mode canal
-				commandMode(client_index, params);
-			}
-		}
-		else if (cmd == "PING")
-			sendToClient(client_index, "PONG " + params[0] + "\r\n");
+// Retire le client de tous ses canaux pour ne laisser aucun pointeur pendant
+void ServerSocket::detachFromChannels(Client *client)
+{
+	while (!client->getChannels().empty())
+	{
+		Channel *channel = channels.get(client->getChannels().back());
+		if (channel != NULL)
+			partChannel(client, channel);
 		else
-			std::cerr << "Unknown command: " << cmd << std::endl;
+			client->leaveChannel(client->getChannels().back());
 	}
 }
 
-//----------------------PASS----------------------------------------
+// Retrait d'un membre ; un canal vide sans sujet ni mode est libere
+void ServerSocket::partChannel(Client *client, Channel *channel)
+{
+	bool was_operator = channel->isOperator(client);
+	channel->removeMember(client);
+	client->leaveChannel(channel->getId());
+	--stats.header().members;
+	if (channel->isDisposable())
+		destroyChannel(channel);
+	else if (was_operator)
+		persistChannel(channel);
+}
+
+void ServerSocket::destroyChannel(Channel *channel)
+{
+	if (channel->getPersistedHash() != 0)
+		channel_store.remove(ircFold(channel->getName()));
+	channels.destroy(channel);
+	stats.header().channels = channels.size();
+}
 
-void ServerSocket::commandPass(int client_index, const std::vector<std::string>& params)
+// Journalise l'etat du canal s'il a change depuis la derniere fois ; l'appel
+// ne fait que copier l'enregistrement dans le tampon du journal.
+void ServerSocket::persistChannel(Channel *channel)
 {
-	if (params.size() < 1) {
-		sendToClient(client_index, "461 PASS :Not enough parameters\r\n");
+	if (!channel_store.isOpen())
 		return;
-	}
+	ChannelRecord record;
+	record.name = channel->getName();
+	record.modes = channel->getModes();
+	record.key = channel->getKey();
+	record.limit = channel->getLimit();
+	record.has_topic = channel->hasTopic();
+	record.topic = channel->getTopic();
+	record.topic_set_by = channel->getTopicSetBy();
+	record.topic_time = channel->getTopicTime();
+	record.invitations = channel->getInvitations();
+	record.operators = channel->getPendingOperators();
+	const std::vector<Client*>& members = channel->getMembers();
+	for (size_t i = 0; i < members.size(); ++i)
+		if (channel->isOperator(members[i]))
+			record.operators.push_back(ircFold(members[i]->getNickname()));
+	uint32_t hash = ChannelStore::fingerprint(record);
+	if (hash == channel->getPersistedHash())
+		return;
+	channel_store.save(ircFold(channel->getName()), record);
+	channel->setPersistedHash(hash);
+}
 
-	std::string given_password = params[0];
-	if (given_password == server_password)
-	{
-		clients[client_index]->setAuthenticated(true);
-	}
-	else
+//----------------------SEND-TO-CLIENT-----------------------------------------
+
+void ServerSocket::sendToClient(ClientHandle handle, const std::string& message)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
 	{
-		sendToClient(client_index, "464 :Password incorrect\r\n");
-		removeClient(client_index);
+		LOG_DEBUG << "Invalid client handle: " << handle.fd;
+		return;
 	}
+	sendToClient(client, message);
 }
 
-//----------------------NICK-----------------------------------------
+void ServerSocket::sendToClient(Client *client, const std::string& message)
+{
+	sendToClient(client, SharedBuffer(message));
+}
 
-std::string ServerSocket::generateUniqueNickname(const std::string& base_nickname)
+// Litteraux et messages construits : copies directement dans un bloc de la
+// BufferPool, sans std::string intermediaire
+void ServerSocket::sendToClient(Client *client, const char *message)
 {
-	std::string unique_nickname = base_nickname;
-	int suffix = 1;
-	while (true) {
-		bool nickname_exists = false;
-		for (size_t i = 0; i < clients.size(); ++i) {
-			if (clients[i]->getNickname() == unique_nickname) {
-				nickname_exists = true;
-				break;
-			}
-		}
-		if (!nickname_exists) {
-			break;
-		}
-		std::stringstream out;
-		out << suffix;
-		unique_nickname = base_nickname + out.str();
-		++suffix;
-	}
-	return unique_nickname;
+	sendToClient(client, SharedBuffer(message, std::strlen(message)));
 }
 
-void ServerSocket::commandNick(int client_index, const std::vector<std::string>& params)
+void ServerSocket::sendToClient(Client *client, const MessageBuilder& message)
 {
-	std::cerr << "Processing NICK command" << std::endl;
-	if (params.size() < 1)
+	sendToClient(client, message.share());
+}
+
+// Appele sous state_lock. Un client d'un autre reacteur n'est jamais touche
+// directement : le message part dans sa boite aux lettres en fin d'iteration.
+void ServerSocket::sendToClient(Client *client, const SharedBuffer& message)
+{
+	// Utilisateur distant : la ligne part vers son serveur, par notre liaison
+	if (client->isRemote())
+		client = client->getServer()->route;
+	LOG_DEBUG << "Sending message to client fd " << client->getFd() << ": " << LogBytes(message.data(), message.size());
+	Reactor *current = currentReactor();
+	if (client->getOwner() != current)
 	{
-		sendToClient(client_index, "431 :No nickname given\r\n");
+		current->postLater(client->getOwner()->getId(), client->getHandle(), message);
+		++current->getStats().cross_posts;
 		return;
 	}
-	std::string new_nick = params[0];
-	bool nickname_exists = false;
+	queueOutput(client, message);
+}
 
-	for (size_t i = 0; i < clients.size(); ++i)
+void ServerSocket::queueOutput(Client *client, const SharedBuffer& message)
+{
+	if (client->isClosing())
+		return;
+	bool was_idle = !client->hasPendingOutput();
+	client->queueMessage(message);
+	StatsShard& counters = client->getOwner()->getStats();
+	++counters.messages_out;
+	counters.sendq_bytes += message.size();
+	// Une liaison porte la sortie de tout un serveur, rafale initiale comprise
+	if (client->pendingBytes() > (client->isLink() ? config.sendq * LINK_SENDQ_FACTOR : config.sendq))
 	{
-		if (clients[i]->getNickname() == new_nick)
-		{
-			nickname_exists = true;
-			break;
-		}
+		++counters.sendq_exceeded;
+		// Lecteur trop lent : on le coupe plutot que de bufferiser sans fin
+		LOG_WARN << "Max SendQ exceeded for client fd " << client->getFd();
+		disconnect(client);
+		return;
 	}
+	// Si des donnees attendaient deja, le socket est plein : POLLOUT s'en chargera.
+	// Sinon l'envoi est fait en fin d'iteration, hors du verrou.
+	if (was_idle)
+		client->getOwner()->getDirty().push_back(client);
+}
 
-	if (nickname_exists)
+// Diffusion : le message est deja serialise, chaque destinataire ne coute
+// qu'un ajout de reference dans sa file de sortie. Seuls les clients locaux
+// la recoivent : les autres serveurs apprennent l'evenement par propagate().
+void ServerSocket::broadcast(const std::vector<Client*>& recipients, const SharedBuffer& message, Client *except)
+{
+	for (std::vector<Client*>::const_iterator it = recipients.begin(); it != recipients.end(); ++it)
 	{
-		new_nick = generateUniqueNickname(new_nick);
+		if (*it != except && !(*it)->isRemote())
+			sendToClient(*it, message);
 	}
-
-	std::string old_nick = clients[client_index]->getNickname();
-	clients[client_index]->setNickname(new_nick);
-	std::string nick_message = ":" + old_nick + " NICK " + new_nick + "\r\n";
-
-	sendToClient(client_index, nick_message);
-
-	std::cerr << "NICK command processed: " << new_nick << std::endl;
 }
 
-//----------------------USER-----------------------------------------
-
-void ServerSocket::commandUser(int client_index, const std::vector<std::string>& params)
+// Envoi avec comptabilite des octets sortis. Backend a completion : la file
+// est seulement soumise, les octets sont comptes dans sendCompleted().
+int ServerSocket::writeOutput(Client *client)
 {
-	std::string RealName;
-
-	std::cerr << "Processing USER command" << std::endl;
-	if (params.size() < 4)
+	EventLoop *loop = client->getOwner()->getLoop();
+	if (loop->completesIo())
 	{
-		sendToClient(client_index, "461 USER :Not enough parameters\r\n");
-		return;
+		int links = client->submitOutput(loop);
+		if (links > 0)
+			client->getOwner()->getStats().write_calls += links;
+		return links;
 	}
+	size_t before = client->pendingBytes();
+	int result = client->flushOutput();
+	size_t written = before - client->pendingBytes();
+	StatsShard& counters = client->getOwner()->getStats();
+	if (result > 0)
+		counters.write_calls += result;
+	counters.bytes_out += written;
+	counters.sendq_bytes -= written;
+	return result;
+}
 
-	clients[client_index]->setUsername(params[0]);
-	std::string hostname = params[1];
-	if (hostname.empty() || hostname == "NULL") {
-		hostname = "default";
-	}
-	clients[client_index]->setHostname(hostname);
-	for(int i = 3; !params[i].empty(); i++)
+void ServerSocket::flushClient(Client *client)
+{
+	if (writeOutput(client) < 0)
 	{
-		RealName += params[i] + ' ';
+		LOG_INFO << "Send error, dropping client fd " << client->getFd();
+		disconnect(client);
+		return;
 	}
-	clients[client_index]->setRealname(RealName);
-
-	sendToClient(client_index, ":localhost 001 " + clients[client_index]->getNickname() + " :Welcome to bdtServer " + clients[client_index]->getNickname() + "!~" + clients[client_index]->getUsername() + "@127.0.0.1\r\n");
-
-	std::cerr << "USER command processed: " << params[0] << " " << params[1] << " " << RealName << std::endl;
+	updateInterest(client);
 }
 
-//----------------------JOIN-----------------------------------------
-
-void ServerSocket::commandJoin(int client_index, const std::vector<std::string>& params)
+// Un maillon d'une chaine d'envois io_uring est termine. La file restante
+// repart quand le socket redevient inscriptible (EV_WRITE), une fois toute
+// la chaine revenue.
+void ServerSocket::sendCompleted(Client *client, int result)
 {
-	std::cerr << "Processing JOIN command" << std::endl;
-	if (params.size() < 1)
+	size_t before = client->pendingBytes();
+	bool alive = client->completeOutput(result);
+	size_t written = before - client->pendingBytes();
+	StatsShard& counters = client->getOwner()->getStats();
+	counters.bytes_out += written;
+	counters.sendq_bytes -= written;
+	if (client->isClosing())
+		return;
+	if (!alive)
 	{
-		sendToClient(client_index, "461 JOIN :Not enough parameters\r\n");
+		LOG_INFO << "Send error, dropping client fd " << client->getFd();
+		disconnect(client);
 		return;
 	}
+	updateInterest(client);
+}
 
-	std::string channel = params[0];
-	std::string password = params.size() > 1 ? params[1] : "";
+// L'interet en ecriture n'est enregistre que tant que la file n'est pas vide
+// (et qu'aucun envoi n'est en vol), l'interet en lecture que tant que le
+// client n'est pas bride
+void ServerSocket::updateInterest(Client *client)
+{
+	int events = 0;
+	if (!client->isReadPaused())
+		events |= EventLoop::EV_READ;
+	if (client->hasPendingOutput() && !client->isSending())
+		events |= EventLoop::EV_WRITE;
+	if (events == client->getInterest())
+		return;
+	client->getOwner()->getLoop()->modify(client->getFd(), client, events);
+	client->setInterest(events);
+}
 
-	// Vérifiez si le canal existe et initialisez-le si nécessaire
-	if (channels.find(channel) == channels.end())
+// Messages postes par les autres reacteurs pour nos clients. Les handles sont
+// resolus dans la table : un client parti entre-temps est simplement ignore.
+void ServerSocket::deliverMailbox(Reactor& reactor)
+{
+	std::vector<Delivery>& inbox = reactor.getInbox();
+	reactor.takeMailbox(inbox);
+	if (inbox.empty())
+		return;
 	{
-		channels[channel] = std::vector<Client*>();
-		channel_operators[channel].push_back(clients[client_index]);
+		SharedLock lock(state_lock);
+		for (size_t i = 0; i < inbox.size(); ++i)
+		{
+			Client *client = clients.get(inbox[i].handle);
+			if (client == NULL || client->getOwner() != &reactor)
+				continue;
+			queueOutput(client, inbox[i].message);
+			if (inbox[i].close)
+				disconnect(client);
+		}
 	}
+	inbox.clear();
+}
 
-	// Vérifiez si l'utilisateur est déjà dans le canal
-	if (std::find(channels[channel].begin(), channels[channel].end(), clients[client_index]) != channels[channel].end())
+void ServerSocket::flushDirty(Reactor& reactor)
+{
+	std::vector<Client*>& dirty = reactor.getDirty();
+	for (size_t i = 0; i < dirty.size(); ++i)
 	{
-		std::cout << "ERROR, on devrait pas etre la" << std::endl;
-		return; // L'utilisateur est déjà dans le canal
+		if (!dirty[i]->isClosing())
+			flushClient(dirty[i]);
 	}
+	dirty.clear();
+}
 
-	// Vérifiez la limite du canal si le mode +l est activé
-	if (std::find(channel_modes[channel].begin(), channel_modes[channel].end(), 'l') != channel_modes[channel].end())
+//----------------------TIMERS-----------------------------------------
+
+void ServerSocket::runTimers(Reactor& reactor)
+{
+	std::vector<Timer*>& expired = reactor.getExpired();
+	reactor.getTimers().advance(reactor.getNow(), expired);
+	for (size_t i = 0; i < expired.size(); ++i)
+		clientTimeout(static_cast<Client*>(expired[i]->data));
+	expired.clear();
+}
+
+// Une seule minuterie par client. Avant l'enregistrement c'est le delai
+// pour le terminer ; ensuite, apres ping_interval de silence on envoie un
+// PING, et sans reponse apres ping_timeout la connexion est fermee.
+// L'activite ne rearme rien : elle est relue ici, a l'echeance.
+void ServerSocket::clientTimeout(Client *client)
+{
+	if (client->isClosing())
+		return;
+	Reactor *owner = client->getOwner();
+	uint64_t now = owner->getNow();
+	if (!client->isFullyRegistered() && !client->isLink())
 	{
-		if (channels[channel].size() >= static_cast<std::vector<Client*>::size_type>(channel_limits[channel]))
-		{
-			//pending_invites[channel].push_back(clients[client_index]); a activer avec celui dans INVITE pour se connecter direct apres invitation si on a deja tente
-			sendToClient(client_index, "471 " + clients[client_index]->getNickname() + " " + channel + " :Cannot join channel (+l)\r\n");
-			return;
-		}
+		LOG_INFO << "Registration timeout for client fd " << client->getFd();
+		sendToClient(client, "ERROR :Closing link (Registration timed out)\r\n");
+		disconnect(client);
+		return;
 	}
-
-	// Vérifiez si le canal est en mode +i
-	if (std::find(channel_modes[channel].begin(), channel_modes[channel].end(), 'i') != channel_modes[channel].end())
+	if (client->getPingSent() != 0)
 	{
-		if (std::find(channel_invitations[channel].begin(), channel_invitations[channel].end(), clients[client_index]->getNickname()) == channel_invitations[channel].end())
-		{
-			sendToClient(client_index, "473 " + clients[client_index]->getNickname() + " " + channel + " :Cannot join channel (+i)\r\n");
-			return;
-		}
-		else
-		{
-			// Supprimez l'invitation une fois utilisée
-			channel_invitations[channel].erase(std::remove(channel_invitations[channel].begin(), channel_invitations[channel].end(), clients[client_index]->getNickname()), channel_invitations[channel].end());
-		}
+		LOG_INFO << "Ping timeout for client fd " << client->getFd();
+		sendToClient(client, "ERROR :Closing link (Ping timeout)\r\n");
+		disconnect(client);
+		return;
 	}
-
-	// Vérifiez le mot de passe du canal si le mode +k est activé
-	if (std::find(channel_modes[channel].begin(), channel_modes[channel].end(), 'k') != channel_modes[channel].end())
+	uint64_t idle_deadline = client->getLastActivity() + config.ping_interval * 1000;
+	if (idle_deadline > now)
 	{
-		if (channel_passwords[channel] != password)
-		{
-			sendToClient(client_index, "475 " + clients[client_index]->getNickname() + " " + channel + " :Cannot join channel (+k)\r\n");
-			return;
-		}
+		owner->getTimers().schedule(&client->getTimer(), idle_deadline);
+		return;
 	}
+	sendToClient(client, "PING :ircserv\r\n");
+	client->setPingSent(now);
+	owner->getTimers().schedule(&client->getTimer(), now + config.ping_timeout * 1000);
+}
 
-	// Ajouter l'utilisateur au canal
-	channels[channel].push_back(clients[client_index]);
-	std::string joinMessage = ":" + clients[client_index]->getNickname() + "!~ " + clients[client_index]->getUsername() + " JOIN :" + channel + "\r\n";
-	sendToClient(client_index, joinMessage);
+//----------------------RUN-LOOP-----------------------------------------
 
+Reactor *ServerSocket::currentReactor() const
+{
+	return static_cast<Reactor*>(pthread_getspecific(reactor_key));
+}
 
-	// Envoyer le sujet actuel du canal au nouveau client
-	std::map<std::string, std::string>::iterator topic_it = topics.find(channel);
-	if (topic_it != topics.end())
-		sendToClient(client_index, "332 " + clients[client_index]->getNickname() + " " + channel + " :" + topic_it->second + "\r\n");
-	else
-		sendToClient(client_index, "331 " + clients[client_index]->getNickname() + " " + channel + " :No topic is set\r\n");
+void *ServerSocket::reactorThread(void *arg)
+{
+	Reactor *reactor = static_cast<Reactor*>(arg);
+	_ptrServer->runReactor(*reactor);
+	return NULL;
+}
 
-	// Notifier tous les autres clients du canal que ce client a rejoint
-	for (size_t i = 0; i < channels[channel].size(); ++i)
+// Un relais qui echoue laisse l'etat intact : les reacteurs repartent.
+void ServerSocket::run()
+{
+	while (true)
 	{
-		if (channels[channel][i] != clients[client_index])
-		{
-			sendToClient(std::distance(clients.begin(), std::find(clients.begin(), clients.end(), channels[channel][i])), joinMessage);
-		}
+		runReactors();
+		if (!_upgradeRequested)
+			break;
+		_upgradeRequested = 0;
+		if (upgrade())
+			return;
+		_stopRequested = 0;
 	}
+	LOG_INFO << "Server shutting down";
 }
 
-//----------------------PRIVMSG-----------------------------------------
-
-void ServerSocket::commandPrivmsg(int client_index, const std::vector<std::string>& params)
+// Le reacteur 0 tourne sur le thread principal, qui seul recoit les signaux ;
+// il reveille les autres a l'arret.
+void ServerSocket::runReactors()
 {
-	std::cerr << "Processing PRIVMSG command" << std::endl;
-	if (params.size() < 2)
+	sigset_t blocked, previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGQUIT);
+	sigaddset(&blocked, SIGUSR2);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	size_t started = 1;
+	for (; started < reactors.size(); ++started)
 	{
-		sendToClient(client_index, "461 PRIVMSG :Not enough parameters\r\n");
-		return;
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, reactorThread, reactors[started]) != 0)
+		{
+			LOG_ERROR << "Failed to start reactor thread";
+			_stopRequested = 1;
+			break;
+		}
+		reactors[started]->setThread(thread);
 	}
-	std::string target = params[0];
-	std::string message = params[1];
-	for (size_t i = 2; i < params.size(); ++i)
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+	runReactor(*reactors[0]);
+
+	for (size_t i = 1; i < started; ++i)
 	{
-		message += " " + params[i];
+		reactors[i]->wake();
+		pthread_join(reactors[i]->getThread(), NULL);
 	}
+}
 
-	// Check if the target is a channel
-	if (target[0] == '#')
+void ServerSocket::runReactor(Reactor& reactor)
+{
+	pthread_setspecific(reactor_key, &reactor);
+	BufferPool::bind(&reactor.getBuffers());
+	EventLoop *loop = reactor.getLoop();
+	std::vector<EventLoop::Event>& events = reactor.getEvents();
+	while (!_stopRequested)
 	{
-		std::map<std::string, std::vector<Client*> >::iterator it = channels.find(target);
-		if (it != channels.end())
+		int timeout = reactor.isAcceptPending() ? 0 : backlogTimeout(reactor);
+		int timer_timeout = reactor.getTimers().nextTimeout(reactor.getNow());
+		if (timeout < 0 || (timer_timeout >= 0 && timer_timeout < timeout))
+			timeout = timer_timeout;
+		int link_timeout = linkTimeout(reactor);
+		if (timeout < 0 || (link_timeout >= 0 && link_timeout < timeout))
+			timeout = link_timeout;
+		int ready = loop->wait(events, timeout);
+		reactor.updateClock();
+		if (ready < 0)
 		{
-			std::vector<Client*>& clients_in_channel = it->second;
-			// Check if the client has joined the channel
-			if (std::find(clients_in_channel.begin(), clients_in_channel.end(), clients[client_index]) != clients_in_channel.end())
+			if (errno == EINTR)
+				continue;
+			LOG_ERROR << "Event loop error";
+			_stopRequested = 1;
+			for (size_t i = 0; i < reactors.size(); ++i)
+				reactors[i]->wake();
+			break;
+		}
+
+		// Seuls les fd prets sont parcourus, quel que soit le nombre de connexions
+		for (size_t i = 0; i < events.size(); ++i)
+		{
+			if (events[i].data == &Reactor::listener_tag)
+				reactor.setAcceptPending(true);
+			else if (events[i].data == &Reactor::wakeup_tag)
 			{
-				for (std::vector<Client*>::iterator it = clients_in_channel.begin(); it != clients_in_channel.end(); ++it)
-				{
-					if (*it != clients[client_index])
-					{
-						sendToClient(std::distance(clients.begin(), std::find(clients.begin(), clients.end(), *it)), ":" + clients[client_index]->getNickname() + " PRIVMSG " + target + " :" + message + "\r\n");
-					}
-				}
+				reactor.drainWakeup();
+				deliverMailbox(reactor);
 			}
 			else
 			{
-				sendToClient(client_index, "442 " + target + " :You're not on that channel\r\n");
+				Client *client = static_cast<Client*>(events[i].data);
+				if (events[i].events & EventLoop::EV_SENT)
+				{
+					sendCompleted(client, events[i].result);
+					continue;
+				}
+				if (!client->isClosing() && (events[i].events & EventLoop::EV_WRITE))
+					flushClient(client);
+				if (!client->isClosing() && (events[i].events & (EventLoop::EV_READ | EventLoop::EV_ERROR)))
+					handleClient(client);
 			}
 		}
-		else
+		if (reactor.isAcceptPending())
+			acceptBatch(reactor);
+		processBacklog(reactor);
+		runTimers(reactor);
+		connectLinks(reactor);
+		reactor.publishOutbox(reactors);
+		flushDirty(reactor);
+		reapClients(reactor);
+		// Une liaison perdue annonce ses departs depuis reapClients() : ils
+		// partent ce tour-ci, pas au prochain reveil
+		reactor.publishOutbox(reactors);
+		if (!reactor.getDirty().empty())
 		{
-			sendToClient(client_index, "403 " + target + " :No such channel\r\n");
+			flushDirty(reactor);
+			reapClients(reactor);
 		}
+		// Les blocs liberes pendant ce tour serviront au suivant ; le surplus
+		// d'une rafale est rendu au systeme
+		reactor.getBuffers().trim();
+		reactor.getStats().buffer_hits = reactor.getBuffers().getHits();
+		reactor.getStats().buffer_misses = reactor.getBuffers().getMisses();
 	}
-	else
+	settleReactor(reactor);
+}
+
+// Backend a completion : plus rien ne doit rester en vol dans le noyau quand
+// le reacteur rend la main (arret ou relais). Les envois termines sont
+// comptes, les connexions deja acceptees enregistrees, et les octets deja
+// recus ranges dans le tampon de leur client comme s'ils attendaient encore
+// dans le socket. Une reprise apres un relais rate rearme tout au wait().
+void ServerSocket::settleReactor(Reactor& reactor)
+{
+	EventLoop *loop = reactor.getLoop();
+	if (!loop->completesIo())
+		return;
+	std::vector<EventLoop::Event>& events = reactor.getEvents();
+	loop->quiesce(events);
+	for (size_t i = 0; i < events.size(); ++i)
+		sendCompleted(static_cast<Client*>(events[i].data), events[i].result);
+	while (acceptConnection(reactor))
+		;
+	ExclusiveLock lock(state_lock);
+	for (size_t i = 0; i < clients.size(); ++i)
 	{
-		// Direct message to a user
-		bool found = false;
-		for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
-		{
-			if ((*it)->getNickname() == target) {
-				sendToClient(std::distance(clients.begin(), it), ":" + clients[client_index]->getNickname() + " PRIVMSG " + target + " :" + message + "\r\n");
-				found = true;
-				break;
-			}
-		}
-		if (!found)
-		{
-			sendToClient(client_index, "401 " + target + " :No such nick\r\n");
-		}
+		Client *client = clients.at(i);
+		if (client->getOwner() != &reactor || client->isClosing())
+			continue;
+		RecvBuffer& input = client->getRecvBuffer();
+		ssize_t nbytes;
+		while (input.writable() > 0
+			&& (nbytes = loop->receive(client->getFd(), input.writePtr(), input.writable())) > 0)
+			input.commit(nbytes);
 	}
 }
 
-//-------------------FIND-NICKNAMES-----------------------------------------
+//----------------------UPGRADE-----------------------------------------
 
-bool ServerSocket::nicknameMatches(Client* client, const std::string& nickname)
+// Appele depuis le fils entre fork() et exec() : appels async-signal-safe seulement
+static void closeDescriptorsFrom(int first, int max_fd)
 {
-	return client->getNickname() == nickname;
+#ifdef SYS_close_range
+	if (syscall(SYS_close_range, first, ~0U, 0) == 0)
+		return;
+#endif
+	for (int fd = first; fd < max_fd; ++fd)
+		close(fd);
 }
 
-Client* ServerSocket::findClientByNickname(const std::string& nickname)
+// Relais vers le binaire qui porte maintenant notre nom : les reacteurs sont
+// arretes, le fils recoit les sockets et l'etat, et ne lache le precedent
+// qu'une fois pret. Les clients ne voient rien, hors une pause de quelques
+// millisecondes pendant laquelle le noyau garde leurs donnees. Les liaisons
+// avec les autres serveurs ne sont pas transmises : elles sont coupees ici
+// et retablies ensuite (link_connect, d'un cote ou de l'autre).
+bool ServerSocket::upgrade()
 {
-	for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
+	if (program_argv == NULL)
+		return false;
+	// Verifie avant de toucher a l'etat : un echec ici laisse tout en place
+	if (access(program_path.c_str(), X_OK) != 0)
 	{
-		if ((*it)->getNickname() == nickname)
-		{
-			return *it;
-		}
+		LOG_ERROR << "Upgrade failed: " << program_path << ": " << std::strerror(errno);
+		return false;
 	}
-	return NULL;
-}
-
-//----------------------KICK-----------------------------------------
+	LOG_INFO << "Upgrade requested, starting " << program_path;
 
-void ServerSocket::commandKick(int client_index, const std::vector<std::string>& params)
-{
-	std::cerr << "Processing KICK command" << std::endl;
-	if (params.size() < 2)
+	// Messages encore en transit entre reacteurs, clients deja condamnes
+	for (size_t i = 0; i < reactors.size(); ++i)
 	{
-		sendToClient(client_index, "461 KICK :Not enough parameters\r\n");
-		return;
+		reactors[i]->drainWakeup();
+		deliverMailbox(*reactors[i]);
 	}
-	std::string channel = params[0];
-	std::string target_nick = params[1];
-	if (!isClientAutorize(channel_operators[channel], clients[client_index]))
+	closeLinks();
+	for (size_t i = 0; i < reactors.size(); ++i)
+		reapClients(*reactors[i]);
+	// Departs des utilisateurs distants annonces aux clients des autres reacteurs
+	reactors[0]->publishOutbox(reactors);
+	for (size_t i = 0; i < reactors.size(); ++i)
+		deliverMailbox(*reactors[i]);
+	// Le successeur relit le journal : il doit etre complet sur disque
+	channel_store.sync();
+
+	int pair[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0)
 	{
-		sendToClient(client_index, "482 " + channel + " :You're not channel operator\r\n");
-		sendToClient(client_index, "481 :Permission Denied- You're not an IRC operator\r\n");
-		return;
+		LOG_ERROR << "Upgrade failed: socketpair: " << std::strerror(errno);
+		return false;
 	}
-	std::string message = (params.size() > 2) ? params[2] : "";
-	std::map<std::string, std::vector<Client*> >::iterator it = channels.find(channel);
-	if (it == channels.end())
+	// Tout ce dont le fils a besoin est prepare avant fork() : il ne doit plus allouer
+	std::string handoff_env = std::string(Handoff::ENV_NAME) + "=3";
+	std::vector<char*> envp;
+	for (char **env = environ; *env != NULL; ++env)
+		if (std::strncmp(*env, handoff_env.c_str(), std::strlen(Handoff::ENV_NAME) + 1) != 0)
+			envp.push_back(*env);
+	envp.push_back(const_cast<char*>(handoff_env.c_str()));
+	envp.push_back(NULL);
+	struct rlimit limit;
+	int max_fd = 1024;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+		max_fd = limit.rlim_cur;
+
+	pid_t pid = fork();
+	if (pid == 0)
 	{
-		sendToClient(client_index, "403 " + channel + " :No such channel\r\n");
-		return;
+		// Le nouveau processus n'herite que de la socket de relais, en fd 3 ;
+		// les autres descripteurs lui arrivent par SCM_RIGHTS
+		if (pair[1] != 3)
+			dup2(pair[1], 3);
+		closeDescriptorsFrom(4, max_fd);
+		execve(program_path.c_str(), program_argv, &envp[0]);
+		_exit(127);
 	}
-	bool found = false;
-	for (size_t i = 0; i < it->second.size(); ++i)
+	close(pair[1]);
+	if (pid < 0)
 	{
-		if (it->second[i]->getNickname() == target_nick)
-		{
-			std::string kick_message = ":" + clients[client_index]->getNickname() + " KICK " + channel + " " + target_nick + " :" + message + "\r\n";
-			for (size_t j = 0; j < it->second.size(); ++j)
-				sendToClient(std::distance(clients.begin(), std::find(clients.begin(), clients.end(), it->second[j])), kick_message);
-			it->second.erase(it->second.begin() + i);
-			found = true;
-			break;
-		}
+		LOG_ERROR << "Upgrade failed: fork: " << std::strerror(errno);
+		close(pair[0]);
+		return false;
 	}
-	if (!found)
-		sendToClient(client_index, "441 " + target_nick + " " + channel + " :They aren't on that channel\r\n");
-}
-
-//----------------------INVITE-----------------------------------------
 
-void ServerSocket::commandInvite(int client_index, const std::vector<std::string>& params)
-{
-	std::cerr << "Processing INVITE command" << std::endl;
-	if (params.size() < 2)
-	{
-		sendToClient(client_index, "461 INVITE :Not enough parameters\r\n");
-		return;
-	}
-	std::string target_nick = params[0];
-	std::string channel = params[1];
-	if (!isClientAutorize(channel_operators[channel], clients[client_index]))
-	{
-		sendToClient(client_index, "482 " + channel + " :You're not channel operator\r\n");
-		sendToClient(client_index, "481 :Permission Denied- You're not an IRC operator\r\n");
-		return;
-	}
-	bool found = false;
-	for (std::vector<Client*>::iterator it = clients.begin(); it != clients.end(); ++it)
-	{
-		if ((*it)->getNickname() == target_nick)
-		{
-			sendToClient(std::distance(clients.begin(), it), ":" + clients[client_index]->getNickname() + " INVITE " + target_nick + " :" + channel + "\r\n");
-			sendToClient(client_index, "341 " + clients[client_index]->getNickname() + " " + target_nick + " " + channel + "\r\n");
-			channel_invitations[channel].push_back(target_nick); // Ajout de l'invitation
-			found = true;
-			break;
-		}
-	}
-	if (!found)
+	std::vector<int> fds;
+	std::string state = serializeState(fds);
+	bool ready = Handoff::send(pair[0], fds, state) && Handoff::waitReady(pair[0], 10000);
+	close(pair[0]);
+	if (!ready)
 	{
-		sendToClient(client_index, "401 " + target_nick + " :No such nick\r\n");
+		LOG_ERROR << "Upgrade failed: new process did not take over, resuming";
+		kill(pid, SIGKILL);
+		waitpid(pid, NULL, 0);
+		return false;
 	}
+	LOG_INFO << "Upgrade complete: pid " << pid << " took over " << clients.size() << " connection(s)";
+	stats.detach();
+	return true;
 }
 
-
-//----------------------TOPIC-----------------------------------------
-
-void ServerSocket::commandTopic(int client_index, const std::vector<std::string>& params)
+// Format : voir restoreState(). Les fd sont designes par leur rang dans `fds`,
+// sockets d'ecoute en tete.
+std::string ServerSocket::serializeState(std::vector<int>& fds)
 {
-	std::cerr << "Processing TOPIC command" << std::endl;
-	if (params.size() < 1)
+	std::string state;
+	StateWriter writer(state);
+	std::string format("IRCSERV-STATE-");
+	format += static_cast<char>('0' + STATE_VERSION);
+	writer.putString(format);
+	writer.putU32(reactors.size());
+	for (size_t i = 0; i < reactors.size(); ++i)
+		fds.push_back(reactors[i]->getListener());
+
+	std::string pending;
+	writer.putU32(clients.size());
+	for (size_t i = 0; i < clients.size(); ++i)
 	{
-		sendToClient(client_index, "461 TOPIC :Not enough parameters\r\n");
-		return;
+		Client *client = clients.at(i);
+		writer.putU32(fds.size());
+		fds.push_back(client->getFd());
+		writer.putU32(client->getAddr().s_addr);
+		writer.putU8(client->isNickSet());
+		writer.putU8(client->isUserSet());
+		writer.putU8(client->isFullyRegistered());
+		writer.putU8(client->isAuthenticated());
+		writer.putU8(client->getCaps());
+		writer.putU64(client->getSignon());
+		writer.putString(client->getNickname());
+		writer.putString(client->getUsername());
+		writer.putString(client->getHostname());
+		writer.putString(client->getRealname());
+		RecvBuffer& input = client->getRecvBuffer();
+		writer.putBytes(input.pendingData(), input.pending());
+		writer.putU8(input.isDiscarding());
+		pending.clear();
+		client->copyPendingOutput(pending);
+		writer.putString(pending);
 	}
 
-	std::string channel = params[0];
-	std::map<std::string, std::vector<Client*> >::iterator channel_it = channels.find(channel);
-	if (channel_it == channels.end())
+	writer.putU32(channels.size());
+	for (size_t id = 0; id < channels.capacity(); ++id)
 	{
-		sendToClient(client_index, "403 " + channel + " :No such channel\r\n");
-		return;
-	}
-
-	// Vérifiez si le mode +t est activé et si l'utilisateur est opérateur
-	if (std::find(channel_modes[channel].begin(), channel_modes[channel].end(), 't') != channel_modes[channel].end() &&
-		std::find(channel_operators[channel].begin(), channel_operators[channel].end(), clients[client_index]) == channel_operators[channel].end())
+		Channel *channel = channels.get(id);
+		if (channel == NULL)
+			continue;
+		writer.putString(channel->getName());
+		writer.putU8(channel->hasMode(Channel::MODE_INVITE));
+		writer.putU8(channel->hasMode(Channel::MODE_TOPIC));
+		writer.putU8(channel->hasMode(Channel::MODE_KEY));
+		writer.putU8(channel->hasMode(Channel::MODE_LIMIT));
+		writer.putString(channel->getKey());
+		writer.putU64(channel->getLimit());
+		writer.putU8(channel->hasTopic());
+		writer.putString(channel->getTopic());
+		writer.putString(channel->getTopicSetBy());
+		writer.putU64(channel->getTopicTime());
+		const std::vector<std::string>& invitations = channel->getInvitations();
+		writer.putU32(invitations.size());
+		for (size_t i = 0; i < invitations.size(); ++i)
+			writer.putString(invitations[i]);
+		const std::vector<Client*>& members = channel->getMembers();
+		writer.putU32(members.size());
+		for (size_t i = 0; i < members.size(); ++i)
 		{
-		if (params.size() > 1)
-		{ // L'utilisateur tente de modifier le sujet
-			sendToClient(client_index, "482 " + channel + " :You're not channel operator\r\n");
-			return;
+			// Rang du client dans la liste ecrite plus haut
+			writer.putU32(clients.indexOf(members[i]));
+			writer.putU8(channel->isOperator(members[i]));
 		}
+		// Operateurs relus du disque et pas encore revenus
+		const std::vector<std::string>& pending_operators = channel->getPendingOperators();
+		writer.putU32(pending_operators.size());
+		for (size_t i = 0; i < pending_operators.size(); ++i)
+			writer.putString(pending_operators[i]);
 	}
+	return state;
+}
 
-	if (params.size() == 1)
+// Cote nouveau processus, avant le demarrage des reacteurs. Les clients sont
+// repartis entre les reacteurs, leurs delais repartent de maintenant.
+// La version 2 ne transmettait pas la date d'enregistrement, la version 3
+// pas les operateurs en attente.
+bool ServerSocket::restoreState(StateReader& reader, const std::vector<int>& fds, int version)
+{
+	std::vector<Client*> restored;
+	uint32_t client_count = reader.getU32();
+	for (uint32_t i = 0; i < client_count && reader.ok(); ++i)
 	{
-		// Afficher le sujet actuel du canal
-		std::map<std::string, std::string>::iterator topic_it = topics.find(channel);
-		if (topic_it != topics.end())
-		{
-			time_t topic_time = topic_times[channel];
-			char time_str[32];
-			std::strftime(time_str, sizeof(time_str), "%a %b %d %T %Y", std::localtime(&topic_time));
-			sendToClient(client_index, "332 " + clients[client_index]->getNickname() + " " + channel + " :" + topic_it->second + "\r\n");
-			sendToClient(client_index, "333 " + clients[client_index]->getNickname() + " " + channel + " " + clients[client_index]->getNickname() + " " + std::string(time_str) + "\r\n");
-		}
-		else
+		uint32_t fd_index = reader.getU32();
+		struct in_addr address;
+		address.s_addr = reader.getU32();
+		bool nick_set = reader.getU8();
+		bool user_set = reader.getU8();
+		bool registered = reader.getU8();
+		bool authenticated = reader.getU8();
+		unsigned int caps = reader.getU8();
+		time_t signon = version >= 3 ? static_cast<time_t>(reader.getU64()) : time(NULL);
+		std::string nickname = reader.getString();
+		std::string username = reader.getString();
+		std::string hostname = reader.getString();
+		std::string realname = reader.getString();
+		std::string input = reader.getString();
+		bool discarding = reader.getU8();
+		std::string output = reader.getString();
+		if (!reader.ok() || fd_index >= fds.size() || input.size() > RecvBuffer::CAPACITY)
+			return false;
+
+		Reactor& reactor = *reactors[i % reactors.size()];
+		Client *client = reactor.createClient(fds[fd_index], address);
+		// Avant toute trace dans nick_index ou la roue : un echec ne laisse rien derriere
+		if (!reactor.getLoop()->add(client->getFd(), client, EventLoop::EV_READ))
 		{
-			sendToClient(client_index, "331 " + clients[client_index]->getNickname() + " " + channel + " :No topic is set\r\n");
+			close(client->getFd());
+			reactor.destroyClient(client);
+			restored.push_back(NULL);
+			continue;
 		}
+		if (nick_set)
+			setClientNickname(client, nickname);
+		if (user_set)
+			client->setUsername(username);
+		client->setHostname(hostname);
+		client->setRealname(realname);
+		client->setRegistered(registered);
+		client->setAuthenticated(authenticated);
+		client->setCaps(caps);
+		client->setSignon(signon);
+		RecvBuffer& buffer = client->getRecvBuffer();
+		std::memcpy(buffer.writePtr(), input.data(), input.size());
+		buffer.commit(input.size());
+		buffer.setDiscarding(discarding);
+		client->getBucket().reset(reactor.getNow(), config.flood_burst);
+		client->touch(reactor.getNow());
+		long delay = client->isFullyRegistered() ? config.ping_interval : config.registration_timeout;
+		reactor.getTimers().schedule(&client->getTimer(), reactor.getNow() + delay * 1000);
+		clients.insert(client);
+		limiter.restore(client->getAddr(), reactor.getNow());
+		++reactor.getStats().accepted;
+		restored.push_back(client);
+		// Lignes deja recues mais pas encore traitees
+		if (input.size() > 0)
+			deferInput(client);
+		if (!output.empty())
+			queueOutput(client, SharedBuffer(output));
 	}
-	else if (params.size() == 2 && params[0] == "-delete")
-	{
-		// Supprimer le sujet du canal
-		topics.erase(channel);
-		topic_set_by.erase(channel);
-		sendToClient(client_index, "331 " + clients[client_index]->getNickname() + " " + channel + " :No topic is set\r\n");
-	}
-	else
+
+	uint32_t channel_count = reader.getU32();
+	for (uint32_t i = 0; i < channel_count && reader.ok(); ++i)
 	{
-		// Construire le sujet du canal en traitant correctement les paramètres
-		std::string topic;
-		if (params[1][0] == ':')
-		{
-			topic = params[1].substr(1);
-		}
-		else
+		Channel *channel = channels.create(reader.getString());
+		channel->setMode(Channel::MODE_INVITE, reader.getU8());
+		channel->setMode(Channel::MODE_TOPIC, reader.getU8());
+		channel->setMode(Channel::MODE_KEY, reader.getU8());
+		channel->setMode(Channel::MODE_LIMIT, reader.getU8());
+		channel->setKey(reader.getString());
+		channel->setLimit(reader.getU64());
+		bool has_topic = reader.getU8();
+		std::string topic = reader.getString();
+		std::string set_by = reader.getString();
+		time_t topic_time = reader.getU64();
+		if (has_topic)
+			channel->setTopic(topic, set_by, topic_time);
+		uint32_t invitation_count = reader.getU32();
+		for (uint32_t j = 0; j < invitation_count && reader.ok(); ++j)
+			channel->addInvitation(reader.getString());
+		uint32_t member_count = reader.getU32();
+		for (uint32_t j = 0; j < member_count && reader.ok(); ++j)
 		{
-			topic = params[1];
+			uint32_t index = reader.getU32();
+			bool op = reader.getU8();
+			Client *client = index < restored.size() ? restored[index] : NULL;
+			if (client == NULL)
+				continue;
+			channel->addMember(client, op);
+			client->joinChannel(channel->getId());
+			++stats.header().members;
 		}
+		uint32_t pending_count = version >= 4 ? reader.getU32() : 0;
+		for (uint32_t j = 0; j < pending_count && reader.ok(); ++j)
+			channel->addPendingOperator(reader.getString());
+		// Tous les membres ont pu disparaitre a la reprise
+		if (channel->isDisposable())
+			destroyChannel(channel);
+	}
+	stats.header().channels = channels.size();
+	for (size_t id = 0; id < channels.capacity(); ++id)
+		if (channels.get(id) != NULL)
+			persistChannel(channels.get(id));
+	return reader.ok();
+}
 
-		for (size_t i = 2; i < params.size(); ++i)
-		{
-			topic += " " + params[i];
-		}
-		topics[channel] = topic;
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 
-		// Définir la date de modification du topic
-		time_t now = time(NULL);
-		topic_times[channel] = now;
-		topic_set_by[channel] = clients[client_index]->getNickname();
 
-		std::string topicMessage = ":" + clients[client_index]->getNickname() + " TOPIC " + channel + " :" + topic + "\r\n";
+//-----------------HANDLE-COMMAND-----------------------------------------
 
-		// Notifier tous les clients du canal du nouveau sujet une seule fois
-		for (std::vector<Client*>::iterator it = channels[channel].begin(); it != channels[channel].end(); ++it)
-		{
-			sendToClient(std::distance(clients.begin(), std::find(clients.begin(), clients.end(), *it)), topicMessage);
-		}
+// Jusqu'a 8 octets de commande ranges dans un entier : le switch de
+// lookupCommand() compare des constantes, jamais des chaines.
+#define CMD_PACK(a, b, c, d, e, f, g, h) \
+	(static_cast<uint64_t>(a) | static_cast<uint64_t>(b) << 8 | static_cast<uint64_t>(c) << 16 \
+	| static_cast<uint64_t>(d) << 24 | static_cast<uint64_t>(e) << 32 | static_cast<uint64_t>(f) << 40 \
+	| static_cast<uint64_t>(g) << 48 | static_cast<uint64_t>(h) << 56)
+
+// Position dans command_table
+enum
+{
+	CMD_PASS, CMD_NICK, CMD_USER, CMD_CAP, CMD_PING, CMD_PONG, CMD_QUIT,
+	CMD_JOIN, CMD_PRIVMSG, CMD_KICK, CMD_INVITE, CMD_TOPIC, CMD_MODE,
+	CMD_PART, CMD_NOTICE, CMD_CHATHISTORY, CMD_SERVER
+};
+
+enum
+{
+	CMD_REGISTERED = 1 << 0, // refusee avant l'enregistrement complet
+	CMD_REGISTERS = 1 << 1, // peut terminer l'enregistrement (PASS/NICK/USER)
+	CMD_SHARED = 1 << 2 // ne fait que lire l'etat commun : verrou partage
+};
+
+// Un ajout de commande = une entree ici + une ligne dans lookupCommand().
+// Derniere colonne : cout en jetons pour le controle de flood.
+const ServerSocket::CommandDescriptor ServerSocket::command_table[] =
+{
+	{ "PASS",		&ServerSocket::commandPass,		1, CMD_REGISTERS,	1 },
+	{ "NICK",		&ServerSocket::commandNick,		0, CMD_REGISTERS,	2 },
+	{ "USER",		&ServerSocket::commandUser,		4, CMD_REGISTERS,	1 },
+	{ "CAP",		&ServerSocket::commandCap,		0, 0,				0 },
+	{ "PING",		&ServerSocket::commandPing,		0, CMD_SHARED,		1 },
+	{ "PONG",		&ServerSocket::commandPong,		0, CMD_SHARED,		0 },
+	{ "QUIT",		&ServerSocket::commandQuit,		0, 0,				0 },
+	{ "JOIN",		&ServerSocket::commandJoin,		1, CMD_REGISTERED,	2 },
+	{ "PRIVMSG",	&ServerSocket::commandPrivmsg,	2, CMD_REGISTERED | CMD_SHARED,	1 },
+	{ "KICK",		&ServerSocket::commandKick,		2, CMD_REGISTERED,	2 },
+	{ "INVITE",		&ServerSocket::commandInvite,	2, CMD_REGISTERED,	3 },
+	{ "TOPIC",		&ServerSocket::commandTopic,	1, CMD_REGISTERED,	2 },
+	{ "MODE",		&ServerSocket::commandMode,		2, CMD_REGISTERED,	2 },
+	{ "PART",		&ServerSocket::commandPart,		1, CMD_REGISTERED,	2 },
+	{ "NOTICE",		&ServerSocket::commandNotice,	2, CMD_REGISTERED | CMD_SHARED,	1 },
+	{ "CHATHISTORY", &ServerSocket::commandChathistory, 3, CMD_REGISTERED | CMD_SHARED, 3 },
+	{ "SERVER",		&ServerSocket::commandServer,	2, 0,				1 }
+};
+
+const size_t ServerSocket::command_count = sizeof(command_table) / sizeof(command_table[0]);
+
+// Jusqu'a 8 octets de nom en majuscules dans un entier, 0 s'ils ne tiennent pas
+static uint64_t packCommand(const char *data, size_t size)
+{
+	if (size == 0 || size > 8)
+		return 0;
+	uint64_t key = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		unsigned char c = data[i];
+		if (c == 0)
+			return 0;
+		if (c >= 'a' && c <= 'z')
+			c -= 32;
+		key |= static_cast<uint64_t>(c) << (8 * i);
 	}
+	return key;
 }
 
-//----------------------QUIT------------------------------------------
+static uint64_t packCommand(const StringView& name)
+{
+	return packCommand(name.data, name.size);
+}
 
-void ServerSocket::commandQuit(int client_index, const std::vector<std::string>& params)
+const ServerSocket::CommandDescriptor *ServerSocket::lookupCommand(const StringView& name)
 {
-	std::cerr << "Processing QUIT command" << std::endl;
-	std::string message = "Client has quit";
-	if (!params.empty())
+	// Nom de 9 a 16 octets : cle des 8 premiers, puis celle du reste
+	if (name.size > 8)
 	{
-		message = params[0];
-		for (size_t i = 1; i < params.size(); ++i)
+		if (name.size > 16)
+			return NULL;
+		uint64_t tail = packCommand(name.data + 8, name.size - 8);
+		switch (packCommand(name.data, 8))
 		{
-			message += " " + params[i];
+			case CMD_PACK('C', 'H', 'A', 'T', 'H', 'I', 'S', 'T'):
+				return tail == CMD_PACK('O', 'R', 'Y', 0, 0, 0, 0, 0) ? &command_table[CMD_CHATHISTORY] : NULL;
+			default:
+				return NULL;
 		}
 	}
-	std::string quitMessage = ":" + clients[client_index]->getNickname() + " QUIT :" + message + "\r\n";
-	for (size_t i = 0; i < clients.size(); ++i)
+	switch (packCommand(name))
 	{
-		if (static_cast<int>(i) != client_index)
-		{
-			sendToClient(i, quitMessage);
-		}
+		case CMD_PACK('P', 'A', 'S', 'S', 0, 0, 0, 0):			return &command_table[CMD_PASS];
+		case CMD_PACK('N', 'I', 'C', 'K', 0, 0, 0, 0):			return &command_table[CMD_NICK];
+		case CMD_PACK('U', 'S', 'E', 'R', 0, 0, 0, 0):			return &command_table[CMD_USER];
+		case CMD_PACK('C', 'A', 'P', 0, 0, 0, 0, 0):			return &command_table[CMD_CAP];
+		case CMD_PACK('P', 'I', 'N', 'G', 0, 0, 0, 0):			return &command_table[CMD_PING];
+		case CMD_PACK('P', 'O', 'N', 'G', 0, 0, 0, 0):			return &command_table[CMD_PONG];
+		case CMD_PACK('Q', 'U', 'I', 'T', 0, 0, 0, 0):			return &command_table[CMD_QUIT];
+		case CMD_PACK('J', 'O', 'I', 'N', 0, 0, 0, 0):			return &command_table[CMD_JOIN];
+		case CMD_PACK('P', 'R', 'I', 'V', 'M', 'S', 'G', 0):	return &command_table[CMD_PRIVMSG];
+		case CMD_PACK('K', 'I', 'C', 'K', 0, 0, 0, 0):			return &command_table[CMD_KICK];
+		case CMD_PACK('I', 'N', 'V', 'I', 'T', 'E', 0, 0):		return &command_table[CMD_INVITE];
+		case CMD_PACK('T', 'O', 'P', 'I', 'C', 0, 0, 0):		return &command_table[CMD_TOPIC];
+		case CMD_PACK('M', 'O', 'D', 'E', 0, 0, 0, 0):			return &command_table[CMD_MODE];
+		case CMD_PACK('P', 'A', 'R', 'T', 0, 0, 0, 0):			return &command_table[CMD_PART];
+		case CMD_PACK('N', 'O', 'T', 'I', 'C', 'E', 0, 0):		return &command_table[CMD_NOTICE];
+		case CMD_PACK('S', 'E', 'R', 'V', 'E', 'R', 0, 0):		return &command_table[CMD_SERVER];
+		default:												return NULL;
 	}
-	removeClient(client_index);
 }
 
-
-//----------------------MODE-----------------------------------------
-
-
-int stringToInt(const std::string& str)
+void ServerSocket::tryRegister(Client *client)
 {
-	std::istringstream iss(str);
-	int num;
-	iss >> num;
-	return num;
+	if (client->isNickSet() && client->isUserSet() && !client->isFullyRegistered() && client->isAuthenticated())
+	{
+		client->setRegistered(true);
+		client->setSignon(time(NULL));
+		introduceUser(client, NULL);
+		++client->getOwner()->getStats().registrations;
+		// Fin du delai d'enregistrement, debut du keepalive
+		Reactor *owner = client->getOwner();
+		owner->getTimers().schedule(&client->getTimer(), owner->getNow() + config.ping_interval * 1000);
+		sendToClient(client, MessageBuilder() << "001 " << client->getNickname() << " :Welcome to the IRC server\r\n");
+		sendSupport(client);
+		LOG_INFO << "Client fd " << client->getFd() << " registered as " << client->getNickname();
+	}
 }
 
-template<typename T>
-void vectorInsert(std::vector<T>& vec, const T& element)
+// RPL_ISUPPORT : les clients y lisent combien de cibles regrouper par commande
+void ServerSocket::sendSupport(Client *client)
 {
-	if (std::find(vec.begin(), vec.end(), element) == vec.end())
-		vec.push_back(element);
+	size_t n = config.targmax;
+	MessageBuilder support;
+	support << "005 " << client->getNickname()
+		<< " CHANTYPES=# PREFIX=(o)@ CHANMODES=,k,l,it"
+		<< " TARGMAX=JOIN:" << n << ",PART:" << n << ",PRIVMSG:" << n << ",NOTICE:" << n << ",KICK:" << n;
+	if (history_arena.isEnabled())
+		support << " CHATHISTORY=" << config.history_lines << " MSGREFTYPES=msgid,timestamp";
+	support << " :are supported by this server\r\n";
+	sendToClient(client, support);
 }
 
-template<typename T>
-void vectorErase(std::vector<T>& vec, const T& element)
+// Recherche, debit du seau et copie des parametres se font hors verrou. La
+// commande s'execute ensuite sous state_lock, partage si elle ne fait que
+// lire l'etat commun (CMD_SHARED), exclusif sinon.
+void ServerSocket::handleCommand(Client *client, const IrcMessage& message)
 {
-	typename std::vector<T>::iterator it = std::find(vec.begin(), vec.end(), element);
-	if (it != vec.end())
-		vec.erase(it);
-}
+	const CommandDescriptor *command = lookupCommand(message.command);
+	StatsShard& counters = client->getOwner()->getStats();
+	client->getBucket().consume(command != NULL ? command->cost : 1);
+	if (command == NULL)
+	{
+		++counters.unknown_commands;
+		LOG_DEBUG << "Unknown command: " << message.command.str();
+		SharedLock lock(state_lock);
+		if (client->isFullyRegistered())
+			sendToClient(client, MessageBuilder() << "421 " << client->getNickname() << " " << message.command.str() << " :Unknown command\r\n");
+		return;
+	}
+	++counters.commands[command - command_table];
 
-bool	isClientAutorize(std::vector<Client*> vec, Client *user)
-{
-	bool	value = false;
-	for (std::vector<Client*>::iterator it = vec.begin(); it != vec.end(); ++it)
+	// Le vecteur est reutilise d'un message a l'autre pour garder sa capacite
+	std::vector<std::string>& params = currentReactor()->getCommandParams();
+	params.resize(message.param_count);
+	for (size_t i = 0; i < message.param_count; ++i)
+		params[i].assign(message.params[i].data, message.params[i].size);
+
+	// Une liste de cibles dedoublonne par les marques des destinataires :
+	// c'est une ecriture, donc verrou exclusif
+	if ((command->flags & CMD_SHARED) && (params.empty() || params[0].find(',') == std::string::npos))
 	{
-		if (*it == user)
-			value = true;
+		SharedLock lock(state_lock);
+		dispatchCommand(client, command, params);
+	}
+	else
+	{
+		ExclusiveLock lock(state_lock);
+		dispatchCommand(client, command, params);
 	}
-	return value;
 }
 
-void ServerSocket::commandMode(int client_index, const std::vector<std::string>& params)
+void ServerSocket::dispatchCommand(Client *client, const CommandDescriptor *command, const std::vector<std::string>& params)
 {
-	std::cerr << "Processing MODE command" << std::endl;
-	if (params.size() < 2)
+	// Vérifier si le client est enregistré
+	if (command->flags & CMD_REGISTERED)
 	{
-		sendToClient(client_index, "461 MODE :Not enough parameters\r\n");
-		return;
+		if (!client->isAuthenticated())
+		{
+			sendToClient(client, "464 :Password required\r\n");
+			return;
+		}
+		if (!client->isFullyRegistered())
+		{
+			sendToClient(client, "451 :You have not registered\r\n");
+			return;
+		}
 	}
-	std::string channel = params[0];
-	std::string modes = params[1];
-	bool add_mode = true;
-	std::map<std::string, std::vector<Client*> >::iterator it = channels.find(channel);
-	if (it == channels.end())
+	if (params.size() < command->min_params)
 	{
-		sendToClient(client_index, "403 " + channel + " :No such channel\r\n");
+		sendToClient(client, MessageBuilder() << "461 " << command->name << " :Not enough parameters\r\n");
 		return;
 	}
-	if (!isClientAutorize(channel_operators[channel], clients[client_index]))
+
+	(this->*command->handler)(client->getHandle(), params);
+
+	// Après PASS, NICK ou USER, vérifiez si le client peut être enregistré
+	if ((command->flags & CMD_REGISTERS) && !client->isClosing())
+		tryRegister(client);
+}
+
+//----------------------CAP----------------------------------------
+
+// Capacites proposees, le bit correspondant dans Client, et si elles n'ont
+// de sens qu'avec l'historique des canaux (history_lines > 0)
+static const struct
+{
+	const char				*name;
+	Client::Capability		bit;
+	bool					needs_history;
+} capabilities[] =
+{
+	{ "batch",				Client::CAP_BATCH,			true },
+	{ "draft/chathistory",	Client::CAP_CHATHISTORY,	true },
+	{ "message-tags",		Client::CAP_MESSAGE_TAGS,	false },
+	{ "server-time",		Client::CAP_SERVER_TIME,	false }
+};
+static const size_t capability_count = sizeof(capabilities) / sizeof(capabilities[0]);
+
+void ServerSocket::commandCap(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	std::string nick = client->isNickSet() ? client->getNickname() : "*";
+	if (params.size() > 0 && params[0] == "LS")
+	{
+		MessageBuilder reply;
+		reply << "CAP " << nick << " LS :";
+		const char *separator = "";
+		for (size_t i = 0; i < capability_count; ++i)
+		{
+			if (!capabilities[i].needs_history || history_arena.isEnabled())
+			{
+				reply << separator << capabilities[i].name;
+				separator = " ";
+			}
+		}
+		reply << "\r\n";
+		sendToClient(client, reply);
+	}
+	else if (params.size() > 0 && params[0] == "LIST")
+	{
+		MessageBuilder reply;
+		reply << "CAP " << nick << " LIST :";
+		const char *separator = "";
+		for (size_t i = 0; i < capability_count; ++i)
+		{
+			if (client->hasCap(capabilities[i].bit))
+			{
+				reply << separator << capabilities[i].name;
+				separator = " ";
+			}
+		}
+		reply << "\r\n";
+		sendToClient(client, reply);
+	}
+	else if (params.size() > 1 && params[0] == "REQ")
+	{
+		// Tout ou rien : une seule capacite inconnue refuse la demande entiere
+		std::istringstream requested(params[1]);
+		std::string name;
+		unsigned int caps = client->getCaps();
+		bool accepted = true;
+		while (accepted && requested >> name)
+		{
+			bool remove = name[0] == '-';
+			size_t i = 0;
+			while (i < capability_count && name.compare(remove ? 1 : 0, std::string::npos, capabilities[i].name) != 0)
+				++i;
+			if (i == capability_count || (capabilities[i].needs_history && !history_arena.isEnabled()))
+				accepted = false;
+			else if (remove)
+				caps &= ~capabilities[i].bit;
+			else
+				caps |= capabilities[i].bit;
+		}
+		if (accepted)
+			client->setCaps(caps);
+		sendToClient(client, MessageBuilder() << "CAP " << nick << (accepted ? " ACK :" : " NAK :") << params[1] << "\r\n");
+	}
+	else if (params.size() > 0 && params[0] == "END")
+	{
+		LOG_DEBUG << "Handling CAP END, checking registration status...";
+		tryRegister(client);
+	}
+}
+
+//----------------------PING----------------------------------------
+
+void ServerSocket::commandPing(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	if (params.empty())
+		sendToClient(client, MessageBuilder() << "409 " << client->getNickname() << " :No origin specified\r\n");
+	else
+		sendToClient(client, MessageBuilder() << "PONG " << params[0] << "\r\n");
+}
+
+// Reponse a notre PING : l'activite est deja notee par processInput()
+void ServerSocket::commandPong(ClientHandle handle, const std::vector<std::string>& params)
+{
+	(void)handle;
+	(void)params;
+}
+
+//----------------------PASS----------------------------------------
+
+void ServerSocket::commandPass(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+
+	std::string given_password = params[0];
+	if (given_password == server_password)
+	{
+		client->setAuthenticated(true);
+	}
+	else
+	{
+		sendToClient(client, "464 :Password incorrect\r\n");
+		removeClient(handle);
+	}
+}
+
+//----------------------NICK-----------------------------------------
+
+// Le dernier suffixe attribue pour chaque base est memorise : une rafale de
+// connexions "guest" ne reteste pas guest1..guestN a chaque fois.
+std::string ServerSocket::generateUniqueNickname(const std::string& base_nickname)
+{
+	std::string base_key = ircFold(base_nickname);
+	int *hint = nick_suffix_hints.find(base_key);
+	int suffix = hint ? *hint : 1;
+	std::string unique_nickname;
+	while (true) {
+		std::stringstream out;
+		out << suffix;
+		// Le suffixe doit tenir dans NICKLEN avec la base
+		size_t keep = std::min(base_nickname.size(), static_cast<size_t>(Client::NICKLEN) - out.str().size());
+		unique_nickname = base_nickname.substr(0, keep) + out.str();
+		if (findClientByNickname(unique_nickname) == NULL)
+			break;
+		++suffix;
+	}
+	if (hint)
+		*hint = suffix + 1;
+	else
+	{
+		if (nick_suffix_hints.size() >= 4096)
+			nick_suffix_hints.clear();
+		nick_suffix_hints.insert(base_key, suffix + 1);
+	}
+	return unique_nickname;
+}
+
+// Met a jour l'index des pseudos et le client ensemble
+void ServerSocket::setClientNickname(Client *client, const std::string& nickname)
+{
+	if (client->isNickSet())
+		nick_index.erase(ircFold(client->getNickname()));
+	nick_index.insert(ircFold(nickname), client);
+	stats.header().nicknames = nick_index.size();
+	client->setNickname(nickname);
+}
+
+void ServerSocket::commandNick(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing NICK command";
+	if (params.size() < 1)
+	{
+		sendToClient(client, "431 :No nickname given\r\n");
+		return;
+	}
+	// Tronque comme les autres serveurs plutot que de refuser
+	std::string new_nick = params[0].substr(0, Client::NICKLEN);
+
+	// Un changement de casse de son propre pseudo n'est pas une collision
+	Client *owner = findClientByNickname(new_nick);
+	if (owner != NULL && owner != client)
+	{
+		new_nick = generateUniqueNickname(new_nick);
+	}
+
+	std::string old_nick = client->getNickname();
+	setClientNickname(client, new_nick);
+	MessageBuilder nick_message;
+	nick_message << ':' << old_nick << " NICK " << new_nick << "\r\n";
+	SharedBuffer shared = nick_message.share();
+	sendToClient(client, shared);
+	// Avant l'enregistrement, le reseau ne connait pas encore le client
+	if (client->isFullyRegistered())
+		propagate(shared, NULL);
+
+	LOG_DEBUG << "NICK command processed: " << new_nick;
+}
+
+//----------------------USER-----------------------------------------
+
+void ServerSocket::commandUser(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	std::string RealName;
+
+	LOG_DEBUG << "Processing USER command";
+
+	client->setUsername(params[0]);
+	std::string hostname = params[1];
+	if (hostname.empty() || hostname == "NULL") {
+		hostname = "default";
+	}
+	client->setHostname(hostname);
+	RealName = params[3];
+	client->setRealname(RealName);
+
+	sendToClient(client, MessageBuilder() << ":localhost 001 " << client->getNickname() << " :Welcome to bdtServer " << client->getNickname() << "!~" << client->getUsername() << "@127.0.0.1\r\n");
+
+	LOG_DEBUG << "USER command processed: " << params[0] << " " << params[1] << " " << RealName;
+}
+
+//----------------------JOIN-----------------------------------------
+
+// Decoupe une liste "a,b,c" ; les elements vides ne sont gardes que si leur
+// position compte (cles de JOIN)
+static void splitList(const std::string& list, std::vector<std::string>& out, bool keep_empty)
+{
+	out.clear();
+	std::string::size_type begin = 0;
+	while (begin <= list.size())
+	{
+		std::string::size_type comma = list.find(',', begin);
+		if (comma == std::string::npos)
+			comma = list.size();
+		if (comma > begin || keep_empty)
+			out.push_back(list.substr(begin, comma - begin));
+		begin = comma + 1;
+	}
+}
+
+// Au-dela de TARGMAX la commande entiere est refusee, comme l'annonce le 005
+bool ServerSocket::splitTargets(Client *client, const std::string& list, std::vector<std::string>& targets)
+{
+	splitList(list, targets, false);
+	if (targets.size() > config.targmax)
+	{
+		sendToClient(client, MessageBuilder() << "407 " << client->getNickname() << " " << list << " :Too many targets\r\n");
+		return false;
+	}
+	return true;
+}
+
+// Un numero par envoi : un client deja marque de ce numero a eu sa copie
+unsigned int ServerSocket::nextDeliveryMark()
+{
+	if (++delivery_mark == 0)
+		++delivery_mark;
+	return delivery_mark;
+}
+
+void ServerSocket::commandJoin(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing JOIN command";
+
+	// JOIN #a,#b,#c cleA,cleB : les cles s'appliquent aux premiers canaux
+	std::vector<std::string> names;
+	std::vector<std::string> keys;
+	if (!splitTargets(client, params[0], names))
+		return;
+	if (params.size() > 1)
+		splitList(params[1], keys, true);
+	for (size_t i = 0; i < names.size() && !client->isClosing(); ++i)
+		joinChannel(client, names[i], i < keys.size() ? keys[i] : "");
+}
+
+void ServerSocket::joinChannel(Client *client, const std::string& name, const std::string& password)
+{
+	if (name[0] != '#')
+	{
+		sendToClient(client, MessageBuilder() << "403 " << client->getNickname() << " " << name << " :No such channel\r\n");
+		return;
+	}
+
+	// Une seule recherche : le canal est cree s'il n'existe pas encore
+	Channel *channel = channels.find(name);
+	bool created = channel == NULL;
+	if (created)
+	{
+		channel = channels.create(name);
+		stats.header().channels = channels.size();
+	}
+
+	// Vérifiez si l'utilisateur est déjà dans le canal
+	if (client->isInChannel(channel->getId()))
+		return;
+
+	// Vérifiez la limite du canal si le mode +l est activé
+	if (channel->hasMode(Channel::MODE_LIMIT) && channel->memberCount() >= channel->getLimit())
+	{
+		sendToClient(client, MessageBuilder() << "471 " << client->getNickname() << " " << channel->getName() << " :Cannot join channel (+l)\r\n");
+		return;
+	}
+
+	// Vérifiez si le canal est en mode +i ; l'invitation est consommee
+	if (channel->hasMode(Channel::MODE_INVITE) && !channel->consumeInvitation(ircFold(client->getNickname())))
+	{
+		sendToClient(client, MessageBuilder() << "473 " << client->getNickname() << " " << channel->getName() << " :Cannot join channel (+i)\r\n");
+		return;
+	}
+
+	// Vérifiez le mot de passe du canal si le mode +k est activé
+	if (channel->hasMode(Channel::MODE_KEY) && channel->getKey() != password)
+	{
+		sendToClient(client, MessageBuilder() << "475 " << client->getNickname() << " " << channel->getName() << " :Cannot join channel (+k)\r\n");
+		return;
+	}
+
+	// Ajouter l'utilisateur au canal ; le premier arrive dans un canal vide en
+	// est operateur, sauf si le canal attend ses operateurs d'avant le redemarrage
+	std::string folded_nick = ircFold(client->getNickname());
+	bool op = channel->consumePendingOperator(folded_nick)
+		|| (channel->memberCount() == 0 && channel->getPendingOperators().empty());
+	channel->addMember(client, op);
+	++stats.header().members;
+	client->joinChannel(channel->getId());
+	if (created || op || channel->hasMode(Channel::MODE_INVITE))
+		persistChannel(channel);
+	MessageBuilder joinBuilder;
+	joinBuilder << ':' << client->getNickname() << "!~" << client->getUsername() << " JOIN :" << channel->getName() << "\r\n";
+	SharedBuffer joinMessage = joinBuilder.share();
+	sendToClient(client, joinMessage);
+
+	// Envoyer le sujet actuel du canal au nouveau client
+	if (channel->hasTopic())
+		sendToClient(client, MessageBuilder() << "332 " << client->getNickname() << " " << channel->getName() << " :" << channel->getTopic() << "\r\n");
+	else
+		sendToClient(client, MessageBuilder() << "331 " << client->getNickname() << " " << channel->getName() << " :No topic is set\r\n");
+
+	// Notifier tous les autres clients du canal que ce client a rejoint
+	broadcast(channel->getMembers(), joinMessage, client);
+	if (!links.empty())
+		propagate((MessageBuilder() << ':' << config.server_name << " NJOIN " << channel->getName()
+			<< " :" << (op ? "@" : "") << client->getNickname() << "\r\n").share(), NULL);
+}
+
+//----------------------PRIVMSG-----------------------------------------
+
+void ServerSocket::commandPrivmsg(ClientHandle handle, const std::vector<std::string>& params)
+{
+	LOG_DEBUG << "Processing PRIVMSG command";
+	deliverMessage(handle, params, "PRIVMSG", false);
+}
+
+//----------------------NOTICE-----------------------------------------
+
+void ServerSocket::commandNotice(ClientHandle handle, const std::vector<std::string>& params)
+{
+	LOG_DEBUG << "Processing NOTICE command";
+	deliverMessage(handle, params, "NOTICE", true);
+}
+
+// PRIVMSG/NOTICE vers une liste de cibles en une passe. Chaque ligne est
+// formatee une fois par cible, jamais par destinataire, et un destinataire
+// present dans plusieurs cibles ne recoit que la premiere. NOTICE ne
+// renvoie jamais d'erreur (RFC 1459).
+void ServerSocket::deliverMessage(ClientHandle handle, const std::vector<std::string>& params, const char *verb, bool notice)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	// Le texte est le dernier parametre ; les mots en trop hors ":trailing"
+	// sont ignores (RFC 1459)
+	const std::string& message = params[1];
+	std::vector<std::string> targets;
+	if (!splitTargets(client, params[0], targets))
+		return;
+
+	// Une seule cible : rien a dedoublonner, et aucune ecriture sur les
+	// destinataires (la commande tient alors sous le verrou partage)
+	unsigned int mark = targets.size() > 1 ? nextDeliveryMark() : 0;
+	for (size_t t = 0; t < targets.size(); ++t)
+	{
+		const std::string& target = targets[t];
+		// Check if the target is a channel
+		if (target[0] == '#')
+		{
+			Channel *channel = channels.find(target);
+			if (channel == NULL)
+			{
+				if (!notice)
+					sendToClient(client, MessageBuilder() << "403 " << target << " :No such channel\r\n");
+				continue;
+			}
+			// Check if the client has joined the channel
+			if (!client->isInChannel(channel->getId()))
+			{
+				if (!notice)
+					sendToClient(client, MessageBuilder() << "442 " << target << " :You're not on that channel\r\n");
+				continue;
+			}
+			MessageBuilder line;
+			line << ':' << client->getNickname() << ' ' << verb << ' ' << target << " :" << message << "\r\n";
+			SharedBuffer shared = line.share();
+			MessageTags tags = recordHistory(channel, shared);
+			TaggedLine tagged(tags, shared);
+			relayToChannel(channel, tagged, client, NULL, mark);
+		}
+		else
+		{
+			// Direct message to a user
+			Client *recipient = findClientByNickname(target);
+			if (recipient == NULL)
+			{
+				if (!notice)
+					sendToClient(client, MessageBuilder() << "401 " << target << " :No such nick\r\n");
+				continue;
+			}
+			if (mark == 0 || recipient->markDelivered(mark))
+			{
+				MessageBuilder line;
+				line << ':' << client->getNickname() << ' ' << verb << ' ' << target << " :" << message << "\r\n";
+				MessageTags tags(history_arena.nextId());
+				TaggedLine tagged(tags, line.share());
+				sendToClient(recipient, tagged.forClient(recipient));
+			}
+		}
+	}
+}
+
+//----------------------CHATHISTORY-----------------------------------------
+
+// Etiquettes d'une ligne de canal, copiee dans l'arene avec elles : le msgid
+// vu par un client est celui que CHATHISTORY attend. msgid et horodatage sont
+// pris dans la meme section que l'ajout ; sous le verrou partage, plusieurs
+// reacteurs ecrivent dans un meme canal et l'historique doit rester trie.
+MessageTags ServerSocket::recordHistory(Channel *channel, const SharedBuffer& line)
+{
+	if (!history_arena.isEnabled())
+		return MessageTags(history_arena.nextId());
+	ScopedLock lock(history_lock);
+	MessageTags tags(history_arena.nextId());
+	channel->getHistory().append(history_arena, config.history_lines, tags, line.data(), line.size());
+	return tags;
+}
+
+// CHATHISTORY LATEST|BEFORE|AFTER|AROUND <canal> <ref> <limite>
+// CHATHISTORY BETWEEN <canal> <ref> <ref> <limite>
+void ServerSocket::commandChathistory(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing CHATHISTORY command";
+	if (!history_arena.isEnabled() || !client->hasCap(Client::CAP_CHATHISTORY))
+	{
+		sendToClient(client, MessageBuilder() << "421 " << client->getNickname() << " CHATHISTORY :Unknown command\r\n");
+		return;
+	}
+	std::string subcommand = params[0];
+	for (size_t i = 0; i < subcommand.size(); ++i)
+		subcommand[i] = std::toupper(static_cast<unsigned char>(subcommand[i]));
+	if (subcommand != "LATEST" && subcommand != "BEFORE" && subcommand != "AFTER"
+		&& subcommand != "AROUND" && subcommand != "BETWEEN")
+	{
+		sendToClient(client, MessageBuilder() << "FAIL CHATHISTORY INVALID_PARAMS " << params[0] << " :Unknown subcommand\r\n");
+		return;
+	}
+	bool between = subcommand == "BETWEEN";
+	size_t limit_index = between ? 4 : 3;
+	if (params.size() <= limit_index)
+	{
+		sendToClient(client, MessageBuilder() << "FAIL CHATHISTORY NEED_MORE_PARAMS " << subcommand << " :Missing parameters\r\n");
+		return;
+	}
+	HistoryRef from;
+	HistoryRef to;
+	if (!from.parse(params[2]) || (from.type == HistoryRef::NONE && subcommand != "LATEST")
+		|| (between && (!to.parse(params[3]) || to.type == HistoryRef::NONE)))
+	{
+		sendToClient(client, MessageBuilder() << "FAIL CHATHISTORY INVALID_PARAMS " << subcommand << " :Invalid message reference\r\n");
+		return;
+	}
+	const std::string& limit_text = params[limit_index];
+	size_t limit = std::strtoul(limit_text.c_str(), NULL, 10);
+	if (limit_text.empty() || limit_text.find_first_not_of("0123456789") != std::string::npos || limit == 0)
+	{
+		sendToClient(client, MessageBuilder() << "FAIL CHATHISTORY INVALID_PARAMS " << subcommand << " :Invalid limit\r\n");
+		return;
+	}
+	limit = std::min(limit, config.history_lines);
+	// Seuls les canaux dont le client est membre ont un historique lisible
+	const std::string& target = params[1];
+	Channel *channel = target[0] == '#' ? channels.find(target) : NULL;
+	if (channel == NULL || !client->isInChannel(channel->getId()))
+	{
+		sendToClient(client, MessageBuilder() << "FAIL CHATHISTORY INVALID_TARGET " << subcommand << " " << target << " :Messages could not be retrieved\r\n");
+		return;
+	}
+
+	// Les autres reacteurs ecrivent l'historique sous le verrou partage
+	ScopedLock lock(history_lock);
+	ChannelHistory& history = channel->getHistory();
+	history.prune(history_arena);
+	size_t first = 0;
+	size_t last = 0;
+	if (subcommand == "LATEST")
+		history.latest(from, limit, first, last);
+	else if (subcommand == "BEFORE")
+		history.before(from, limit, first, last);
+	else if (subcommand == "AFTER")
+		history.after(from, limit, first, last);
+	else if (subcommand == "AROUND")
+		history.around(from, limit, first, last);
+	else
+		history.between(from, to, limit, first, last);
+
+	// Une seule reponse. Chaque ligne est copiee depuis l'arene a partir du
+	// point qui correspond aux capacites du client, derriere une amorce
+	// commune : rien n'est reformate. BATCH seulement si `batch` est accepte.
+	bool batch = client->hasCap(Client::CAP_BATCH);
+	bool all_tags = client->hasCap(Client::CAP_MESSAGE_TAGS);
+	bool time_tag = all_tags || client->hasCap(Client::CAP_SERVER_TIME);
+	std::string lead = batch ? (time_tag ? "@batch=history;" : "@batch=history ") : (time_tag ? "@" : "");
+	std::string opening;
+	std::string closing;
+	if (batch)
+	{
+		opening = ":" + config.server_name + " BATCH +history chathistory " + channel->getName() + "\r\n";
+		closing = ":" + config.server_name + " BATCH -history\r\n";
+	}
+	size_t total = opening.size() + closing.size();
+	for (size_t i = first; i < last; ++i)
+	{
+		const ChannelHistory::Entry& entry = history.at(i);
+		size_t skip = all_tags ? 1 : time_tag ? entry.time_offset : entry.tags_length;
+		total += lead.size() + entry.length - skip;
+	}
+	if (total == 0)
+		return;
+	SharedBuffer reply(total);
+	char *out = reply.writable();
+	std::memcpy(out, opening.data(), opening.size());
+	out += opening.size();
+	for (size_t i = first; i < last; ++i)
+	{
+		const ChannelHistory::Entry& entry = history.at(i);
+		size_t skip = all_tags ? 1 : time_tag ? entry.time_offset : entry.tags_length;
+		std::memcpy(out, lead.data(), lead.size());
+		out += lead.size();
+		std::memcpy(out, history_arena.at(entry.pos) + skip, entry.length - skip);
+		out += entry.length - skip;
+	}
+	std::memcpy(out, closing.data(), closing.size());
+	sendToClient(client, reply);
+}
+
+//-------------------FIND-NICKNAMES-----------------------------------------
+
+bool ServerSocket::nicknameMatches(Client* client, const std::string& nickname)
+{
+	return ircEquals(client->getNickname(), nickname);
+}
+
+Client* ServerSocket::findClientByNickname(const std::string& nickname)
+{
+	Client **client = nick_index.find(ircFold(nickname));
+	return client ? *client : NULL;
+}
+
+//----------------------KICK-----------------------------------------
+
+// KICK #canal a,b,c ou KICK #a,#b a,b (un canal par pseudo)
+void ServerSocket::commandKick(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing KICK command";
+	std::vector<std::string> channel_names;
+	std::vector<std::string> target_nicks;
+	if (!splitTargets(client, params[0], channel_names) || !splitTargets(client, params[1], target_nicks))
+		return;
+	if (channel_names.empty() || target_nicks.empty()
+		|| (channel_names.size() != 1 && channel_names.size() != target_nicks.size()))
+	{
+		sendToClient(client, "461 KICK :Not enough parameters\r\n");
+		return;
+	}
+	std::string message = (params.size() > 2) ? params[2] : "";
+	for (size_t i = 0; i < target_nicks.size(); ++i)
+	{
+		const std::string& channel_name = channel_names[channel_names.size() == 1 ? 0 : i];
+		const std::string& target_nick = target_nicks[i];
+		Channel *channel = channels.find(channel_name);
+		if (channel == NULL)
+		{
+			sendToClient(client, MessageBuilder() << "403 " << channel_name << " :No such channel\r\n");
+			continue;
+		}
+		if (!channel->isOperator(client))
+		{
+			sendToClient(client, MessageBuilder() << "482 " << channel->getName() << " :You're not channel operator\r\n");
+			sendToClient(client, "481 :Permission Denied- You're not an IRC operator\r\n");
+			continue;
+		}
+		Client *target = findClientByNickname(target_nick);
+		if (target == NULL || !channel->isMember(target))
+		{
+			sendToClient(client, MessageBuilder() << "441 " << target_nick << " " << channel->getName() << " :They aren't on that channel\r\n");
+			continue;
+		}
+		MessageBuilder kick_message;
+		kick_message << ':' << client->getNickname() << " KICK " << channel->getName() << ' ' << target_nick << " :" << message << "\r\n";
+		SharedBuffer shared = kick_message.share();
+		broadcast(channel->getMembers(), shared, NULL);
+		propagate(shared, NULL);
+		partChannel(target, channel);
+	}
+}
+
+//----------------------PART-----------------------------------------
+
+void ServerSocket::commandPart(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing PART command";
+	std::vector<std::string> channel_names;
+	if (!splitTargets(client, params[0], channel_names))
+		return;
+	std::string reason = (params.size() > 1) ? params[1] : "";
+	for (size_t i = 0; i < channel_names.size(); ++i)
+	{
+		Channel *channel = channels.find(channel_names[i]);
+		if (channel == NULL)
+		{
+			sendToClient(client, MessageBuilder() << "403 " << client->getNickname() << " " << channel_names[i] << " :No such channel\r\n");
+			continue;
+		}
+		if (!client->isInChannel(channel->getId()))
+		{
+			sendToClient(client, MessageBuilder() << "442 " << client->getNickname() << " " << channel->getName() << " :You're not on that channel\r\n");
+			continue;
+		}
+		MessageBuilder part_message;
+		part_message << ':' << client->getNickname() << "!~" << client->getUsername() << " PART " << channel->getName();
+		if (!reason.empty())
+			part_message << " :" << reason;
+		part_message << "\r\n";
+		// Diffusion avant le retrait : le canal peut etre libere par partChannel
+		SharedBuffer shared = part_message.share();
+		broadcast(channel->getMembers(), shared, NULL);
+		propagate(shared, NULL);
+		partChannel(client, channel);
+	}
+}
+
+//----------------------INVITE-----------------------------------------
+
+void ServerSocket::commandInvite(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing INVITE command";
+	std::string target_nick = params[0];
+	Channel *channel = channels.find(params[1]);
+	if (channel == NULL)
+	{
+		sendToClient(client, MessageBuilder() << "403 " << params[1] << " :No such channel\r\n");
+		return;
+	}
+	if (!channel->isOperator(client))
+	{
+		sendToClient(client, MessageBuilder() << "482 " << channel->getName() << " :You're not channel operator\r\n");
+		sendToClient(client, "481 :Permission Denied- You're not an IRC operator\r\n");
+		return;
+	}
+	Client *target = findClientByNickname(target_nick);
+	if (target != NULL)
+	{
+		sendToClient(target, MessageBuilder() << ':' << client->getNickname() << " INVITE " << target_nick << " :" << channel->getName() << "\r\n");
+		sendToClient(client, MessageBuilder() << "341 " << client->getNickname() << " " << target_nick << " " << channel->getName() << "\r\n");
+		channel->addInvitation(ircFold(target_nick)); // Ajout de l'invitation
+		persistChannel(channel);
+	}
+	else
+	{
+		sendToClient(client, MessageBuilder() << "401 " << target_nick << " :No such nick\r\n");
+	}
+}
+
+
+//----------------------TOPIC-----------------------------------------
+
+void ServerSocket::commandTopic(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing TOPIC command";
+
+	Channel *channel = channels.find(params[0]);
+	if (channel == NULL)
+	{
+		sendToClient(client, MessageBuilder() << "403 " << params[0] << " :No such channel\r\n");
+		return;
+	}
+
+	// Vérifiez si le mode +t est activé et si l'utilisateur est opérateur
+	if (channel->hasMode(Channel::MODE_TOPIC) && !channel->isOperator(client))
+	{
+		if (params.size() > 1)
+		{ // L'utilisateur tente de modifier le sujet
+			sendToClient(client, MessageBuilder() << "482 " << channel->getName() << " :You're not channel operator\r\n");
+			return;
+		}
+	}
+
+	if (params.size() == 1)
+	{
+		// Afficher le sujet actuel du canal
+		if (channel->hasTopic())
+		{
+			time_t topic_time = channel->getTopicTime();
+			char time_str[32];
+			std::strftime(time_str, sizeof(time_str), "%a %b %d %T %Y", std::localtime(&topic_time));
+			sendToClient(client, MessageBuilder() << "332 " << client->getNickname() << " " << channel->getName() << " :" << channel->getTopic() << "\r\n");
+			sendToClient(client, MessageBuilder() << "333 " << client->getNickname() << " " << channel->getName() << " " << channel->getTopicSetBy() << " " << time_str << "\r\n");
+		}
+		else
+		{
+			sendToClient(client, MessageBuilder() << "331 " << client->getNickname() << " " << channel->getName() << " :No topic is set\r\n");
+		}
+	}
+	else if (params.size() == 2 && params[0] == "-delete")
+	{
+		// Supprimer le sujet du canal
+		channel->clearTopic();
+		persistChannel(channel);
+		sendToClient(client, MessageBuilder() << "331 " << client->getNickname() << " " << channel->getName() << " :No topic is set\r\n");
+	}
+	else
+	{
+		const std::string& topic = params[1];
+
+		// Définir le sujet, son auteur et sa date de modification
+		channel->setTopic(topic, client->getNickname(), time(NULL));
+		persistChannel(channel);
+
+		MessageBuilder topicMessage;
+		topicMessage << ':' << client->getNickname() << " TOPIC " << channel->getName() << " :" << topic << "\r\n";
+
+		// Notifier tous les clients du canal du nouveau sujet une seule fois
+		SharedBuffer shared = topicMessage.share();
+		broadcast(channel->getMembers(), shared, NULL);
+		propagate(shared, NULL);
+	}
+}
+
+//----------------------QUIT------------------------------------------
+
+void ServerSocket::commandQuit(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing QUIT command";
+	std::string message = "Client has quit";
+	if (!params.empty())
+	{
+		message = params[0];
+	}
+	MessageBuilder quitBuilder;
+	quitBuilder << ':' << client->getNickname() << " QUIT :" << message << "\r\n";
+	SharedBuffer quitMessage = quitBuilder.share();
+	for (size_t i = 0; i < clients.size(); ++i)
+	{
+		if (clients.at(i) != client && !clients.at(i)->isLink())
+		{
+			sendToClient(clients.at(i), quitMessage);
+		}
+	}
+	// Annonce avec son motif ; reapClients() n'aura plus rien a propager
+	if (client->isFullyRegistered())
+		propagate(quitMessage, NULL);
+	forgetUser(client);
+	removeClient(handle);
+}
+
+
+//----------------------MODE-----------------------------------------
+
+
+// Chaque changement est renvoye a son auteur seulement, et aux autres serveurs
+void ServerSocket::echoMode(Client *client, const MessageBuilder& line)
+{
+	SharedBuffer shared = line.share();
+	sendToClient(client, shared);
+	propagate(shared, NULL);
+}
+
+int stringToInt(const std::string& str)
+{
+	std::istringstream iss(str);
+	int num;
+	iss >> num;
+	return num;
+}
+
+void ServerSocket::commandMode(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	LOG_DEBUG << "Processing MODE command";
+	// Mode utilisateur sur soi-meme : simple echo
+	if (ircEquals(client->getNickname(), params[0]))
+	{
+		sendToClient(client, MessageBuilder() << "MODE " << params[0] << " :" << params[1] << "\r\n");
+		return;
+	}
+	std::string modes = params[1];
+	bool add_mode = true;
+	Channel *channel = channels.find(params[0]);
+	if (channel == NULL)
+	{
+		sendToClient(client, MessageBuilder() << "403 " << params[0] << " :No such channel\r\n");
+		return;
+	}
+	const std::string& name = channel->getName();
+	if (!channel->isOperator(client))
+	{
+		sendToClient(client, "481 :Permission Denied- You're not an IRC operator\r\n");
+		sendToClient(client, MessageBuilder() << "482 " << name << " :You're not channel operator\r\n");
+		return;
+	}
+	Client* target = NULL; // Déclaration ici pour éviter l'erreur de saut
+	int limit = 0;
+	for (size_t i = 0; i < modes.size(); ++i)
+	{
+		char mode = modes[i];
+		switch (mode) {
+			case '+':
+				add_mode = true;
+				break;
+			case '-':
+				add_mode = false;
+				break;
+			case 'i':
+				channel->setMode(Channel::MODE_INVITE, add_mode);
+				echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << (add_mode ? " +i" : " -i") << "\r\n");
+				break;
+			case 'k':
+				if (add_mode) {
+					if (params.size() < 3) {
+						sendToClient(client, "461 MODE :Not enough parameters for +k\r\n");
+						persistChannel(channel);
+						return;
+					}
+					// Ajouter un mot de passe au canal
+					channel->setKey(params[2]);
+					channel->setMode(Channel::MODE_KEY, true);
+					echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << " +k " << params[2] << "\r\n");
+				} else {
+					// Supprimer le mot de passe du canal
+					channel->setKey("");
+					channel->setMode(Channel::MODE_KEY, false);
+					echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << " -k\r\n");
+				}
+				break;
+			case 'l':
+				if (add_mode) {
+					if (params.size() < 3) {
+						sendToClient(client, "461 MODE :Not enough parameters for +l\r\n");
+						persistChannel(channel);
+						return;
+					}
+					// Limiter le nombre d'utilisateurs dans le canal
+					limit = std::atoi(params[2].c_str());
+					channel->setLimit(limit > 0 ? limit : 0);
+					channel->setMode(Channel::MODE_LIMIT, true);
+					echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << " +l " << params[2] << "\r\n");
+				} else {
+					// Supprimer la limite du nombre d'utilisateurs
+					channel->setLimit(0);
+					channel->setMode(Channel::MODE_LIMIT, false);
+					echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << " -l\r\n");
+				}
+				break;
+			case 't':
+				channel->setMode(Channel::MODE_TOPIC, add_mode);
+				echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << (add_mode ? " +t" : " -t") << "\r\n");
+				break;
+			case 'o':
+				if (params.size() < 3)
+				{
+					sendToClient(client, "461 MODE :Not enough parameters for +o\r\n");
+					persistChannel(channel);
+					return;
+				}
+				target = findClientByNickname(params[2]);
+				if (target == NULL)
+					sendToClient(client, MessageBuilder() << "401 " << params[2] << " :No such nick/channel\r\n");
+				else if (!channel->setOperator(target, add_mode))
+					sendToClient(client, MessageBuilder() << "441 " << params[2] << " " << name << " :They aren't on that channel\r\n");
+				else
+					echoMode(client, MessageBuilder() << ":" << client->getNickname() << " MODE " << name << (add_mode ? " +o " : " -o ") << params[2] << "\r\n");
+				break;
+			default:
+				sendToClient(client, MessageBuilder() << "472 " << name << " " << mode << " :is unknown mode char to me\r\n");
+				break;
+		}
+	}
+	persistChannel(channel);
+}
+
+//----------------------SERVER-LINKS-----------------------------------------
+
+// Protocole entre serveurs, proche de la RFC 2813. Le reseau est un arbre :
+// chaque ligne recue d'une liaison est appliquee ici puis relayee telle
+// quelle aux autres liaisons, jamais renvoyee d'ou elle vient.
+//
+//   SERVER <nom> <mot de passe> :<description>      poignee de main
+//   :<amont> SERVER <nom> <sauts> :<description>    serveur plus loin
+//   SQUIT <nom> :<motif>                            serveur perdu
+//   NICK <pseudo> <sauts> <date> <user> <hote> <serveur> :<nom reel>
+//   :<pseudo> NICK <nouveau>
+//   :<serveur> NJOIN <#canal> :[@]<pseudo>,...      arrivees dans un canal
+//   KILL <pseudo> :<motif>                          retrait force
+// PRIVMSG, NOTICE, PART, KICK, TOPIC, MODE, INVITE et QUIT gardent la forme
+// qu'en voient les clients.
+
+static const char server_description[] = "ft_irc server";
+
+// Utilisateur distant : un Client sans socket ni reacteur. Sa presentation
+// sur une liaison, ou `server` est son serveur d'origine.
+static SharedBuffer userIntroduction(Client *user, size_t hops, const std::string& server)
+{
+	return (MessageBuilder() << "NICK " << user->getNickname() << ' ' << hops << ' '
+		<< static_cast<unsigned long>(user->getSignon()) << ' ' << user->getUsername() << ' '
+		<< user->getHostname() << ' ' << server << " :" << user->getRealname() << "\r\n").share();
+}
+
+// Poignee de main. Le serveur qui a ouvert la connexion parle le premier,
+// l'autre repond par son propre SERVER ; chacun envoie ensuite tout ce qu'il
+// connait.
+void ServerSocket::commandServer(ClientHandle handle, const std::vector<std::string>& params)
+{
+	Client *client = clients.get(handle);
+	if (client == NULL)
+		return;
+	if (client->isNickSet() || client->isUserSet())
+	{
+		sendToClient(client, "462 :You may not reregister\r\n");
+		return;
+	}
+	const std::string& name = params[0];
+	if (config.link_password.empty() || params[1] != config.link_password)
+	{
+		LOG_WARN << "Link refused from " << client->getAddress() << ": bad password";
+		closeClient(client, "ERROR :Closing link (Bad link password)\r\n");
+		return;
+	}
+	if (!Network::isValidName(name) || ircEquals(name, config.server_name) || network.find(name) != NULL)
+	{
+		LOG_WARN << "Link refused from " << client->getAddress() << ": server " << name << " already linked";
+		closeClient(client, "ERROR :Closing link (Server already linked)\r\n");
+		return;
+	}
+	establishLink(client, name, params.size() > 2 ? params[2] : name);
+}
+
+bool ServerSocket::isOutgoing(Client *client) const
+{
+	ClientHandle handle = client->getHandle();
+	for (size_t i = 0; i < outgoing.size(); ++i)
+		if (outgoing[i].handle.fd == handle.fd && outgoing[i].handle.generation == handle.generation)
+			return true;
+	return false;
+}
+
+void ServerSocket::establishLink(Client *link, const std::string& name, const std::string& description)
+{
+	bool incoming = !isOutgoing(link);
+	link->setLink();
+	link->setServer(network.add(name, description, 1, link, NULL));
+	links.push_back(link);
+	// Fin du delai d'enregistrement, debut du keepalive comme pour un client
+	Reactor *owner = link->getOwner();
+	owner->getTimers().schedule(&link->getTimer(), owner->getNow() + config.ping_interval * 1000);
+	if (incoming)
+		sendToClient(link, MessageBuilder() << "SERVER " << config.server_name << ' ' << config.link_password
+			<< " :" << server_description << "\r\n");
+	sendBurst(link);
+	propagate((MessageBuilder() << ':' << config.server_name << " SERVER " << name << " 2 :" << description << "\r\n").share(), link);
+	LOG_INFO << "Linked with " << name << " (fd " << link->getFd() << (incoming ? ", incoming)" : ", outgoing)");
+}
+
+// Tout notre cote du reseau, dans un ordre ou chaque ligne ne designe que ce
+// qui precede : serveurs, utilisateurs, puis membres, modes et sujet des
+// canaux.
+void ServerSocket::sendBurst(Client *link)
+{
+	const std::vector<LinkedServer*>& servers = network.getServers();
+	for (size_t i = 0; i < servers.size(); ++i)
+	{
+		LinkedServer *server = servers[i];
+		if (server->route == link)
+			continue;
+		sendToClient(link, MessageBuilder() << ':' << (server->uplink ? server->uplink->name : config.server_name)
+			<< " SERVER " << server->name << ' ' << server->hops + 1 << " :" << server->description << "\r\n");
+	}
+	for (size_t i = 0; i < clients.size(); ++i)
+	{
+		Client *user = clients.at(i);
+		if (!user->isLink() && user->isFullyRegistered() && findClientByNickname(user->getNickname()) == user)
+			sendToClient(link, userIntroduction(user, 1, config.server_name));
+	}
+	for (size_t i = 0; i < servers.size(); ++i)
+	{
+		if (servers[i]->route == link)
+			continue;
+		for (size_t j = 0; j < servers[i]->users.size(); ++j)
+			sendToClient(link, userIntroduction(servers[i]->users[j], servers[i]->hops + 1, servers[i]->name));
+	}
+
+	for (size_t id = 0; id < channels.capacity(); ++id)
+	{
+		Channel *channel = channels.get(id);
+		if (channel == NULL || channel->memberCount() == 0)
+			continue;
+		const std::string& name = channel->getName();
+		const std::vector<Client*>& members = channel->getMembers();
+		std::string list;
+		for (size_t j = 0; j < members.size(); ++j)
+		{
+			if (!list.empty())
+				list += ',';
+			if (channel->isOperator(members[j]))
+				list += '@';
+			list += members[j]->getNickname();
+			// Lignes d'au plus ~400 octets, loin de la limite de 512
+			if (list.size() > 400 || j + 1 == members.size())
+			{
+				sendToClient(link, MessageBuilder() << ':' << config.server_name << " NJOIN " << name << " :" << list << "\r\n");
+				list.clear();
+			}
+		}
+		// Modes et sujet groupes en un seul envoi
+		MessageBuilder modes;
+		bool any = channel->getModes() != 0 || channel->hasTopic();
+		if (channel->hasMode(Channel::MODE_INVITE))
+			modes << ':' << config.server_name << " MODE " << name << " +i\r\n";
+		if (channel->hasMode(Channel::MODE_TOPIC))
+			modes << ':' << config.server_name << " MODE " << name << " +t\r\n";
+		if (channel->hasMode(Channel::MODE_KEY))
+			modes << ':' << config.server_name << " MODE " << name << " +k " << channel->getKey() << "\r\n";
+		if (channel->hasMode(Channel::MODE_LIMIT))
+			modes << ':' << config.server_name << " MODE " << name << " +l " << channel->getLimit() << "\r\n";
+		if (channel->hasTopic())
+			modes << ':' << config.server_name << " TOPIC " << name << " :" << channel->getTopic() << "\r\n";
+		if (any)
+			sendToClient(link, modes);
+	}
+}
+
+// Avant un relais : les liaisons ne sont pas transmises au successeur, les
+// tentatives en cours non plus
+void ServerSocket::closeLinks()
+{
+	for (size_t i = 0; i < links.size(); ++i)
+		disconnect(links[i]);
+	for (size_t i = 0; i < outgoing.size(); ++i)
+	{
+		Client *pending = clients.get(outgoing[i].handle);
+		if (pending != NULL && !pending->isClosing())
+			disconnect(pending);
+	}
+}
+
+void ServerSocket::propagate(const SharedBuffer& line, Client *except)
+{
+	for (size_t i = 0; i < links.size(); ++i)
 	{
-		sendToClient(client_index, "481 :Permission Denied- You're not an IRC operator\r\n");
-		sendToClient(client_index, "482 " + channel + " :You're not channel operator\r\n");
+		if (links[i] != except)
+			sendToClient(links[i], line);
+	}
+}
+
+void ServerSocket::introduceUser(Client *user, Client *except)
+{
+	if (!links.empty())
+		propagate(userIntroduction(user, 1, config.server_name), except);
+}
+
+// Retire le pseudo de l'index s'il designe encore ce client : apres un KILL,
+// il peut deja appartenir a un autre
+void ServerSocket::forgetUser(Client *user)
+{
+	if (!user->isNickSet() || findClientByNickname(user->getNickname()) != user)
 		return;
+	nick_index.erase(ircFold(user->getNickname()));
+	stats.header().nicknames = nick_index.size();
+}
+
+// Depart d'un utilisateur distant : vu par les membres locaux de ses canaux,
+// une fois chacun
+void ServerSocket::announceQuit(Client *user, const SharedBuffer& quit)
+{
+	unsigned int mark = nextDeliveryMark();
+	const std::vector<unsigned int>& joined = user->getChannels();
+	for (size_t i = 0; i < joined.size(); ++i)
+	{
+		Channel *channel = channels.get(joined[i]);
+		if (channel == NULL)
+			continue;
+		const std::vector<Client*>& members = channel->getMembers();
+		for (size_t j = 0; j < members.size(); ++j)
+			if (members[j] != user && !members[j]->isRemote() && members[j]->markDelivered(mark))
+				sendToClient(members[j], quit);
 	}
-	Client* target = NULL; // Déclaration ici pour éviter l'erreur de saut
+}
+
+void ServerSocket::removeRemoteUser(Client *user, const SharedBuffer& quit)
+{
+	announceQuit(user, quit);
+	forgetUser(user);
+	detachFromChannels(user);
+	std::vector<Client*>& users = user->getServer()->users;
+	users.erase(std::find(users.begin(), users.end(), user));
+	delete user;
+}
+
+// Retrait force (collision de pseudos, KILL). La propagation reste a
+// l'appelant, seul a savoir quel cote du reseau doit l'apprendre.
+void ServerSocket::killUser(Client *user, const std::string& reason)
+{
+	LOG_INFO << "Killing " << user->getNickname() << " (" << reason << ")";
+	SharedBuffer quit = (MessageBuilder() << ':' << user->getNickname() << " QUIT :Killed (" << reason << ")\r\n").share();
+	if (user->isRemote())
+	{
+		removeRemoteUser(user, quit);
+		return;
+	}
+	announceQuit(user, quit);
+	forgetUser(user);
+	detachFromChannels(user);
+	closeClient(user, "ERROR :Closing link (Killed: " + reason + ")\r\n");
+}
+
+// Coupure : le serveur, ceux annonces a travers lui et tous leurs
+// utilisateurs disparaissent, avec le motif habituel "<serveur> <perdu>"
+void ServerSocket::splitServer(LinkedServer *server, const std::string& reason)
+{
+	propagate((MessageBuilder() << "SQUIT " << server->name << " :" << reason << "\r\n").share(), server->route);
+	std::vector<LinkedServer*> lost;
+	network.collect(server, lost);
+	size_t users = 0;
+	for (size_t i = 0; i < lost.size(); ++i)
+	{
+		while (!lost[i]->users.empty())
+		{
+			Client *user = lost[i]->users.back();
+			removeRemoteUser(user, (MessageBuilder() << ':' << user->getNickname() << " QUIT :" << reason << "\r\n").share());
+			++users;
+		}
+		network.remove(lost[i]);
+	}
+	LOG_INFO << "Netsplit " << reason << ": " << lost.size() << " server(s), " << users << " user(s) lost";
+}
+
+// Une copie par membre local, une seule par liaison menant a des membres
+// distants quel que soit leur nombre. `from` est la liaison d'ou vient la
+// ligne : elle l'a deja. mark a 0 : pas d'autre cible a dedoublonner. Les
+// liaisons deja servies sont notees ici, pas sur les liaisons elles-memes :
+// deux reacteurs peuvent relayer en meme temps sous le verrou partage.
+void ServerSocket::relayToChannel(Channel *channel, TaggedLine& line, Client *sender, Client *from, unsigned int mark)
+{
+	std::vector<Client*> routes;
+	const std::vector<Client*>& members = channel->getMembers();
+	for (std::vector<Client*>::const_iterator it = members.begin(); it != members.end(); ++it)
+	{
+		if (*it == sender)
+			continue;
+		if ((*it)->isRemote())
+		{
+			Client *route = (*it)->getServer()->route;
+			if (route != from && std::find(routes.begin(), routes.end(), route) == routes.end())
+			{
+				routes.push_back(route);
+				sendToClient(route, line.getLine());
+			}
+		}
+		else if (mark == 0 || (*it)->markDelivered(mark))
+			sendToClient(*it, line.forClient(*it));
+	}
+}
+
+// Message d'adieu puis fermeture, depuis n'importe quel reacteur
+void ServerSocket::closeClient(Client *client, const std::string& farewell)
+{
+	Reactor *current = currentReactor();
+	if (client->getOwner() != current)
+	{
+		current->postLater(client->getOwner()->getId(), client->getHandle(), SharedBuffer(farewell), true);
+		return;
+	}
+	queueOutput(client, SharedBuffer(farewell));
+	disconnect(client);
+}
+
+//----------------------OUTGOING-LINKS-----------------------------------------
+
+// Reacteur 0 seulement : les pairs de link_connect sans liaison sont
+// rappeles, au plus une tentative toutes les link_retry secondes chacun
+void ServerSocket::connectLinks(Reactor& reactor)
+{
+	if (outgoing.empty() || reactor.getId() != 0)
+		return;
+	uint64_t now = reactor.getNow();
+	for (size_t i = 0; i < outgoing.size(); ++i)
+	{
+		OutgoingLink& target = outgoing[i];
+		if (now < target.retry_ms)
+			continue;
+		{
+			SharedLock lock(state_lock);
+			if (clients.get(target.handle) != NULL)
+				continue;
+		}
+		target.retry_ms = now + config.link_retry * 1000;
+		struct sockaddr_in address;
+		std::memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(target.peer.port);
+		address.sin_addr = target.peer.address;
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0 || !setNonBlocking(fd)
+			|| (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS))
+		{
+			LOG_WARN << "Link to port " << target.peer.port << " failed: " << std::strerror(errno);
+			if (fd >= 0)
+				close(fd);
+			continue;
+		}
+		int nodelay = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+		Client *link = reactor.createClient(fd, target.peer.address);
+		link->touch(now);
+		if (!reactor.getLoop()->add(fd, link, EventLoop::EV_READ))
+		{
+			LOG_ERROR << "Event loop registration error";
+			close(fd);
+			reactor.destroyClient(link);
+			continue;
+		}
+		// Un pair muet est abandonne comme un client qui ne s'enregistre pas
+		reactor.getTimers().schedule(&link->getTimer(), now + config.registration_timeout * 1000);
+		// Comptee comme une connexion admise : reapClients() la rendra
+		limiter.restore(target.peer.address, now);
+		ExclusiveLock lock(state_lock);
+		target.handle = clients.insert(link);
+		++reactor.getStats().accepted;
+		// Part des que la connexion aboutit (EV_WRITE)
+		sendToClient(link, MessageBuilder() << "SERVER " << config.server_name << ' ' << config.link_password
+			<< " :" << server_description << "\r\n");
+		LOG_INFO << "Linking to " << link->getAddress() << ":" << target.peer.port << " (fd " << fd << ")";
+	}
+}
+
+// Attente jusqu'a la prochaine tentative due, -1 s'il n'y en a aucune
+int ServerSocket::linkTimeout(Reactor& reactor)
+{
+	if (outgoing.empty() || reactor.getId() != 0)
+		return -1;
+	uint64_t now = reactor.getNow();
+	int timeout = -1;
+	SharedLock lock(state_lock);
+	for (size_t i = 0; i < outgoing.size(); ++i)
+	{
+		if (clients.get(outgoing[i].handle) != NULL)
+			continue;
+		int wait = outgoing[i].retry_ms > now ? outgoing[i].retry_ms - now : 0;
+		if (timeout < 0 || wait < timeout)
+			timeout = wait;
+	}
+	return timeout;
+}
+
+//----------------------LINK-MESSAGES-----------------------------------------
+
+// Position dans link_table
+enum
+{
+	LINK_SERVER, LINK_SQUIT, LINK_NICK, LINK_QUIT, LINK_KILL, LINK_NJOIN, LINK_PART,
+	LINK_KICK, LINK_TOPIC, LINK_MODE, LINK_INVITE, LINK_PRIVMSG, LINK_NOTICE,
+	LINK_PING, LINK_PONG, LINK_ERROR
+};
+
+const ServerSocket::LinkCommandDescriptor ServerSocket::link_table[] =
+{
+	{ "SERVER",		&ServerSocket::linkServer,	2 },
+	{ "SQUIT",		&ServerSocket::linkSquit,	1 },
+	{ "NICK",		&ServerSocket::linkNick,	1 },
+	{ "QUIT",		&ServerSocket::linkQuit,	0 },
+	{ "KILL",		&ServerSocket::linkKill,	1 },
+	{ "NJOIN",		&ServerSocket::linkNjoin,	2 },
+	{ "PART",		&ServerSocket::linkPart,	1 },
+	{ "KICK",		&ServerSocket::linkKick,	2 },
+	{ "TOPIC",		&ServerSocket::linkTopic,	2 },
+	{ "MODE",		&ServerSocket::linkMode,	2 },
+	{ "INVITE",		&ServerSocket::linkInvite,	2 },
+	{ "PRIVMSG",	&ServerSocket::linkMessage,	2 },
+	{ "NOTICE",		&ServerSocket::linkMessage,	2 },
+	{ "PING",		&ServerSocket::linkPing,	0 },
+	{ "PONG",		&ServerSocket::linkPong,	0 },
+	{ "ERROR",		&ServerSocket::linkError,	0 }
+};
+
+const ServerSocket::LinkCommandDescriptor *ServerSocket::lookupLinkCommand(const StringView& name)
+{
+	switch (packCommand(name))
+	{
+		case CMD_PACK('S', 'E', 'R', 'V', 'E', 'R', 0, 0):		return &link_table[LINK_SERVER];
+		case CMD_PACK('S', 'Q', 'U', 'I', 'T', 0, 0, 0):		return &link_table[LINK_SQUIT];
+		case CMD_PACK('N', 'I', 'C', 'K', 0, 0, 0, 0):			return &link_table[LINK_NICK];
+		case CMD_PACK('Q', 'U', 'I', 'T', 0, 0, 0, 0):			return &link_table[LINK_QUIT];
+		case CMD_PACK('K', 'I', 'L', 'L', 0, 0, 0, 0):			return &link_table[LINK_KILL];
+		case CMD_PACK('N', 'J', 'O', 'I', 'N', 0, 0, 0):		return &link_table[LINK_NJOIN];
+		case CMD_PACK('P', 'A', 'R', 'T', 0, 0, 0, 0):			return &link_table[LINK_PART];
+		case CMD_PACK('K', 'I', 'C', 'K', 0, 0, 0, 0):			return &link_table[LINK_KICK];
+		case CMD_PACK('T', 'O', 'P', 'I', 'C', 0, 0, 0):		return &link_table[LINK_TOPIC];
+		case CMD_PACK('M', 'O', 'D', 'E', 0, 0, 0, 0):			return &link_table[LINK_MODE];
+		case CMD_PACK('I', 'N', 'V', 'I', 'T', 'E', 0, 0):		return &link_table[LINK_INVITE];
+		case CMD_PACK('P', 'R', 'I', 'V', 'M', 'S', 'G', 0):	return &link_table[LINK_PRIVMSG];
+		case CMD_PACK('N', 'O', 'T', 'I', 'C', 'E', 0, 0):		return &link_table[LINK_NOTICE];
+		case CMD_PACK('P', 'I', 'N', 'G', 0, 0, 0, 0):			return &link_table[LINK_PING];
+		case CMD_PACK('P', 'O', 'N', 'G', 0, 0, 0, 0):			return &link_table[LINK_PONG];
+		case CMD_PACK('E', 'R', 'R', 'O', 'R', 0, 0, 0):		return &link_table[LINK_ERROR];
+		default:												return NULL;
+	}
+}
+
+// Ligne d'une liaison etablie, sous state_lock comme les commandes des
+// clients. Une ligne inconnue ou incoherente (emetteur absent, venu par la
+// mauvaise liaison) est ignoree : les deux cotes finissent par converger.
+void ServerSocket::handleLinkMessage(Client *link, const char *line, size_t len, const IrcMessage& message)
+{
+	const LinkCommandDescriptor *command = lookupLinkCommand(message.command);
+	if (command == NULL || message.param_count < command->min_params)
+	{
+		LOG_DEBUG << "Ignored from " << link->getServer()->name << ": " << LogBytes(line, len);
+		return;
+	}
+	std::vector<std::string>& params = currentReactor()->getCommandParams();
+	params.resize(message.param_count);
+	for (size_t i = 0; i < message.param_count; ++i)
+		params[i].assign(message.params[i].data, message.params[i].size);
+	LinkMessage parsed(params);
+	if (message.prefix.size > 0)
+	{
+		const char *bang = static_cast<const char*>(std::memchr(message.prefix.data, '!', message.prefix.size));
+		parsed.sender.assign(message.prefix.data, bang ? bang - message.prefix.data : message.prefix.size);
+	}
+	// La ligne telle que recue, pour la relayer sans la reformater
+	parsed.line = SharedBuffer(len + 2);
+	char *out = parsed.line.writable();
+	std::memcpy(out, line, len);
+	std::memcpy(out + len, "\r\n", 2);
+	(this->*command->handler)(link, parsed);
+}
+
+// Seul un utilisateur venu par cette liaison peut y parler
+Client *ServerSocket::findRemoteUser(Client *link, const std::string& nickname)
+{
+	Client *user = findClientByNickname(nickname);
+	if (user == NULL || !user->isRemote() || user->getServer()->route != link)
+		return NULL;
+	return user;
+}
+
+// Auteur d'un changement de canal : un utilisateur ou un serveur situe
+// derriere cette liaison. Une ligne venue par la mauvaise liaison, ou au nom
+// d'un de nos clients, est ignoree.
+bool ServerSocket::isBehindLink(Client *link, const std::string& sender)
+{
+	if (findRemoteUser(link, sender) != NULL)
+		return true;
+	LinkedServer *server = network.find(sender);
+	return server != NULL && server->route == link;
+}
+
+void ServerSocket::linkServer(Client *link, const LinkMessage& message)
+{
+	LinkedServer *uplink = network.find(message.sender);
+	if (uplink == NULL || uplink->route != link)
+		return;
+	const std::string& name = message.params[0];
+	// Deja connu : le reseau formerait une boucle
+	if (!Network::isValidName(name) || ircEquals(name, config.server_name) || network.find(name) != NULL)
+	{
+		LOG_WARN << "Server " << name << " announced twice, dropping link with " << link->getServer()->name;
+		closeClient(link, "ERROR :Closing link (Server " + name + " already linked)\r\n");
+		return;
+	}
+	size_t hops = std::strtoul(message.params[1].c_str(), NULL, 10);
+	const std::string description = message.params.size() > 2 ? message.params[2] : name;
+	network.add(name, description, hops, link, uplink);
+	propagate((MessageBuilder() << ':' << uplink->name << " SERVER " << name << ' ' << hops + 1
+		<< " :" << description << "\r\n").share(), link);
+	LOG_INFO << "Server " << name << " joined the network behind " << link->getServer()->name;
+}
+
+void ServerSocket::linkSquit(Client *link, const LinkMessage& message)
+{
+	LinkedServer *server = network.find(message.params[0]);
+	if (server == NULL || server->route != link)
+		return;
+	// Le voisin lui-meme : c'est la liaison qui tombe
+	if (server == link->getServer())
+	{
+		disconnect(link);
+		return;
+	}
+	splitServer(server, (server->uplink ? server->uplink->name : link->getServer()->name) + " " + server->name);
+}
+
+// Collisions : a la presentation, le plus ancien enregistrement garde le
+// pseudo (les deux partent a egalite) ; chaque cote tranche de meme et retire
+// lui-meme son perdant. Un changement de pseudo sur un pseudo pris retire
+// les deux utilisateurs.
+void ServerSocket::linkNick(Client *link, const LinkMessage& message)
+{
+	const std::vector<std::string>& params = message.params;
+	std::string nick = params[0].substr(0, Client::NICKLEN);
+	Client *existing = findClientByNickname(nick);
+	// Un client local encore en cours d'enregistrement cede la place
+	if (existing != NULL && !existing->isRemote() && !existing->isFullyRegistered())
+	{
+		std::string renamed = generateUniqueNickname(nick);
+		sendToClient(existing, MessageBuilder() << ':' << existing->getNickname() << " NICK " << renamed << "\r\n");
+		setClientNickname(existing, renamed);
+		existing = NULL;
+	}
+
+	if (!message.sender.empty())
+	{
+		Client *user = findRemoteUser(link, message.sender);
+		if (user == NULL)
+			return;
+		if (existing != NULL && existing != user)
+		{
+			propagate((MessageBuilder() << "KILL " << user->getNickname() << " :Nick collision\r\n").share(), link);
+			propagate((MessageBuilder() << "KILL " << nick << " :Nick collision\r\n").share(), NULL);
+			killUser(existing, "Nick collision");
+			killUser(user, "Nick collision");
+			return;
+		}
+		setClientNickname(user, nick);
+		propagate(message.line, link);
+		return;
+	}
+
+	if (params.size() < 7)
+		return;
+	LinkedServer *server = network.find(params[5]);
+	if (server == NULL || server->route != link)
+		return;
+	time_t signon = std::strtoul(params[2].c_str(), NULL, 10);
+	if (existing != NULL)
+	{
+		bool keep_existing = existing->getSignon() <= signon;
+		if (existing->getSignon() >= signon)
+		{
+			propagate((MessageBuilder() << "KILL " << nick << " :Nick collision\r\n").share(), link);
+			killUser(existing, "Nick collision");
+		}
+		if (keep_existing)
+			return;
+	}
+	Client *user = new Client(-1, link->getAddr());
+	user->setServer(server);
+	setClientNickname(user, nick);
+	user->setUsername(params[3]);
+	user->setHostname(params[4]);
+	user->setRealname(params[6]);
+	user->setSignon(signon);
+	user->setRegistered(true);
+	server->users.push_back(user);
+	propagate(userIntroduction(user, server->hops + 1, server->name), link);
+}
+
+void ServerSocket::linkQuit(Client *link, const LinkMessage& message)
+{
+	Client *user = findRemoteUser(link, message.sender);
+	if (user == NULL)
+		return;
+	propagate(message.line, link);
+	removeRemoteUser(user, message.line);
+}
+
+void ServerSocket::linkKill(Client *link, const LinkMessage& message)
+{
+	Client *user = findClientByNickname(message.params[0]);
+	if (user == NULL || !user->isFullyRegistered())
+		return;
+	propagate(message.line, link);
+	killUser(user, message.params.size() > 1 ? message.params[1] : "Killed");
+}
+
+void ServerSocket::linkNjoin(Client *link, const LinkMessage& message)
+{
+	const std::string& name = message.params[0];
+	if (name.empty() || name[0] != '#')
+		return;
+	Channel *channel = channels.find(name);
+	if (channel == NULL)
+	{
+		channel = channels.create(name);
+		stats.header().channels = channels.size();
+	}
+	std::vector<std::string> entries;
+	splitList(message.params[1], entries, false);
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		bool op = entries[i][0] == '@';
+		std::string nick = entries[i].substr(op ? 1 : 0);
+		Client *user = findRemoteUser(link, nick);
+		if (user == NULL)
+			continue;
+		if (user->isInChannel(channel->getId()))
+		{
+			if (op)
+				channel->setOperator(user, true);
+			continue;
+		}
+		channel->addMember(user, op);
+		++stats.header().members;
+		user->joinChannel(channel->getId());
+		// L'invitation a ete utilisee sur son serveur
+		channel->consumeInvitation(ircFold(nick));
+		broadcast(channel->getMembers(), (MessageBuilder() << ':' << user->getNickname() << "!~" << user->getUsername()
+			<< " JOIN :" << channel->getName() << "\r\n").share(), user);
+	}
+	if (channel->isDisposable())
+	{
+		destroyChannel(channel);
+		return;
+	}
+	persistChannel(channel);
+	propagate(message.line, link);
+}
+
+void ServerSocket::linkPart(Client *link, const LinkMessage& message)
+{
+	Client *user = findRemoteUser(link, message.sender);
+	Channel *channel = channels.find(message.params[0]);
+	if (user == NULL || channel == NULL || !user->isInChannel(channel->getId()))
+		return;
+	broadcast(channel->getMembers(), message.line, NULL);
+	propagate(message.line, link);
+	partChannel(user, channel);
+}
+
+void ServerSocket::linkKick(Client *link, const LinkMessage& message)
+{
+	if (!isBehindLink(link, message.sender))
+		return;
+	Channel *channel = channels.find(message.params[0]);
+	Client *target = findClientByNickname(message.params[1]);
+	if (channel == NULL || target == NULL || !channel->isMember(target))
+		return;
+	broadcast(channel->getMembers(), message.line, NULL);
+	propagate(message.line, link);
+	partChannel(target, channel);
+}
+
+// Le sujet annonce par un serveur a la liaison ne remplace pas le notre
+void ServerSocket::linkTopic(Client *link, const LinkMessage& message)
+{
+	Channel *channel = channels.find(message.params[0]);
+	if (channel == NULL || !isBehindLink(link, message.sender)
+		|| (channel->hasTopic() && network.find(message.sender) != NULL))
+		return;
+	channel->setTopic(message.params[1], message.sender, time(NULL));
+	persistChannel(channel);
+	broadcast(channel->getMembers(), message.line, NULL);
+	propagate(message.line, link);
+}
+
+// Les droits de l'auteur ont ete verifies par son serveur ; reste a savoir
+// qu'il est bien derriere cette liaison. Comme en local, seul l'auteur voit
+// ses changements de mode.
+void ServerSocket::linkMode(Client *link, const LinkMessage& message)
+{
+	const std::vector<std::string>& params = message.params;
+	Channel *channel = channels.find(params[0]);
+	if (channel == NULL || !isBehindLink(link, message.sender))
+		return;
+	const std::string& modes = params[1];
+	bool add_mode = true;
+	size_t arg = 2;
 	for (size_t i = 0; i < modes.size(); ++i)
 	{
-		char mode = modes[i];
-		switch (mode) {
+		switch (modes[i])
+		{
 			case '+':
-				add_mode = true;
-				break;
 			case '-':
-				add_mode = false;
+				add_mode = modes[i] == '+';
 				break;
 			case 'i':
-				if (add_mode)
-				{
-					vectorInsert(channel_modes[channel], 'i');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " +i\r\n");
-				}
-				else
-				{
-					vectorErase(channel_modes[channel], 'i');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " -i\r\n");
-				}
+				channel->setMode(Channel::MODE_INVITE, add_mode);
+				break;
+			case 't':
+				channel->setMode(Channel::MODE_TOPIC, add_mode);
 				break;
 			case 'k':
-				if (add_mode) {
-					if (params.size() < 3) {
-						sendToClient(client_index, "461 MODE :Not enough parameters for +k\r\n");
-						return;
-					}
-					// Ajouter un mot de passe au canal
-					channel_passwords[channel] = params[2];
-					channel_modes[channel].push_back('k');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " +k " + params[2] + "\r\n");
-				} else {
-					// Supprimer le mot de passe du canal
-					channel_passwords.erase(channel);
-					channel_modes[channel].erase(std::remove(channel_modes[channel].begin(), channel_modes[channel].end(), 'k'), channel_modes[channel].end());
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " -k\r\n");
-				}
+				if (add_mode && arg >= params.size())
+					break;
+				channel->setKey(add_mode ? params[arg++] : "");
+				channel->setMode(Channel::MODE_KEY, add_mode);
 				break;
 			case 'l':
-				if (add_mode) {
-					if (params.size() < 3) {
-						sendToClient(client_index, "461 MODE :Not enough parameters for +l\r\n");
-						return;
-					}
-					// Limiter le nombre d'utilisateurs dans le canal
-					channel_limits[channel] = std::atoi(params[2].c_str());
-					channel_modes[channel].push_back('l');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " +l " + params[2] + "\r\n");
-				} else {
-					// Supprimer la limite du nombre d'utilisateurs
-					channel_limits.erase(channel);
-					channel_modes[channel].erase(std::remove(channel_modes[channel].begin(), channel_modes[channel].end(), 'l'), channel_modes[channel].end());
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " -l\r\n");
-				}
-				break;
-			case 't':
-				if (add_mode)
-				{
-					vectorInsert(channel_modes[channel], 't');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " +t\r\n");
-				}
-				else
-				{
-					vectorErase(channel_modes[channel], 't');
-					sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " -t\r\n");
-				}
+				if (add_mode && arg >= params.size())
+					break;
+				channel->setLimit(add_mode ? std::max(std::atoi(params[arg++].c_str()), 0) : 0);
+				channel->setMode(Channel::MODE_LIMIT, add_mode);
 				break;
 			case 'o':
-				if (params.size() < 3)
-				{
-					sendToClient(client_index, "461 MODE :Not enough parameters for +o\r\n");
-					return;
-				}
-				target = NULL;
-				for (size_t j = 0; j < clients.size(); ++j)
-				{
-					if (clients[j]->getNickname() == params[2])
-					{
-						target = clients[j];
-						break;
-					}
-				}
-				if (target)
+				if (arg < params.size())
 				{
-					if (add_mode)
-					{
-						vectorInsert(channel_operators[channel], target);
-						sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " +o " + params[2] + "\r\n");
-					}
-					else
-					{
-						vectorErase(channel_operators[channel], target);
-						sendToClient(client_index, ":" + clients[client_index]->getNickname() + " MODE " + channel + " -o " + params[2] + "\r\n");
-					}
+					Client *target = findClientByNickname(params[arg++]);
+					if (target != NULL)
+						channel->setOperator(target, add_mode);
 				}
-				else
-					sendToClient(client_index, "401 " + params[2] + " :No such nick/channel\r\n");
-				break;
-			default:
-				sendToClient(client_index, "472 " + channel + " " + mode + " :is unknown mode char to me\r\n");
 				break;
 		}
 	}
+	persistChannel(channel);
+	propagate(message.line, link);
+}
+
+// Chaque serveur du chemin note l'invitation : le +i est verifie la ou
+// l'invite rejoindra
+void ServerSocket::linkInvite(Client *link, const LinkMessage& message)
+{
+	if (findRemoteUser(link, message.sender) == NULL)
+		return;
+	Client *target = findClientByNickname(message.params[0]);
+	Channel *channel = channels.find(message.params[1]);
+	if (channel != NULL)
+	{
+		channel->addInvitation(ircFold(message.params[0]));
+		persistChannel(channel);
+	}
+	if (target != NULL && (!target->isRemote() || target->getServer()->route != link))
+		sendToClient(target, message.line);
+}
+
+void ServerSocket::linkMessage(Client *link, const LinkMessage& message)
+{
+	Client *sender = findRemoteUser(link, message.sender);
+	if (sender == NULL)
+		return;
+	const std::string& target = message.params[0];
+	if (target[0] == '#')
+	{
+		Channel *channel = channels.find(target);
+		if (channel == NULL)
+			return;
+		MessageTags tags = recordHistory(channel, message.line);
+		TaggedLine tagged(tags, message.line);
+		relayToChannel(channel, tagged, sender, link, 0);
+		return;
+	}
+	Client *recipient = findClientByNickname(target);
+	if (recipient != NULL && (!recipient->isRemote() || recipient->getServer()->route != link))
+	{
+		MessageTags tags(history_arena.nextId());
+		TaggedLine tagged(tags, message.line);
+		sendToClient(recipient, tagged.forClient(recipient));
+	}
+}
+
+void ServerSocket::linkPing(Client *link, const LinkMessage& message)
+{
+	sendToClient(link, MessageBuilder() << "PONG " << config.server_name << " :"
+		<< (message.params.empty() ? config.server_name : message.params.back()) << "\r\n");
+}
+
+// Reponse a notre PING : l'activite est deja notee par processInput()
+void ServerSocket::linkPong(Client *link, const LinkMessage& message)
+{
+	(void)link;
+	(void)message;
+}
+
+void ServerSocket::linkError(Client *link, const LinkMessage& message)
+{
+	LOG_WARN << "Link with " << link->getServer()->name << " closed by peer: "
+		<< (message.params.empty() ? std::string() : message.params[0]);
+	disconnect(link);
 }
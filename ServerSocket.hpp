@@ -15,61 +15,222 @@
 
 #include <netinet/in.h>
 #include <vector>
-#include <map>
 #include "Client.hpp"
+#include "ClientTable.hpp"
+#include "ChannelTable.hpp"
+#include "Config.hpp"
+#include "StringMap.hpp"
+#include "EventLoop.hpp"
+#include "IrcMessage.hpp"
+#include "Reactor.hpp"
+#include "Mutex.hpp"
+#include "Stats.hpp"
+#include "MessageBuilder.hpp"
+#include "Handoff.hpp"
+#include "ChannelStore.hpp"
+#include "ChannelHistory.hpp"
+#include "MessageTags.hpp"
+#include "ConnectionLimiter.hpp"
+#include "Network.hpp"
 #include <ctime>
+#include <csignal>
+#include <stdint.h>
 
 class ServerSocket
 {
 	public:
-		ServerSocket(const std::string& password);
+		ServerSocket(const std::string& password, const Config& config);
 		~ServerSocket();
 		bool setup(int port);
 		static void closeServer(int signal);
-		int acceptConnection();
+		static void upgradeServer(int signal);
+		void setProgram(char **argv);
+		bool acceptConnection(Reactor& reactor);
+		void acceptBatch(Reactor& reactor);
 		int getSocket() const;
-		void handleClient(int index);
-		void removeClient(int index);
-		void sendToClient(int index, const std::string& message);
+		void handleClient(Client *client);
+		void removeClient(ClientHandle handle);
+		void reapClients(Reactor& reactor);
+		void sendToClient(ClientHandle handle, const std::string& message);
+		void sendToClient(Client *client, const std::string& message);
+		void sendToClient(Client *client, const char *message);
+		void sendToClient(Client *client, const MessageBuilder& message);
+		void sendToClient(Client *client, const SharedBuffer& message);
+		void broadcast(const std::vector<Client*>& recipients, const SharedBuffer& message, Client *except);
 
-		void handleCommand(int client_index, const std::string& command);
-		void commandPass(int client_index, const std::vector<std::string>& params);
-		void commandNick(int client_index, const std::vector<std::string>& params);
-		void commandUser(int client_index, const std::vector<std::string>& params);
-		void commandJoin(int client_index, const std::vector<std::string>& params);
-		void commandPrivmsg(int client_index, const std::vector<std::string>& params);
-		void commandKick(int client_index, const std::vector<std::string>& params);
-		void commandInvite(int client_index, const std::vector<std::string>& params);
-		void commandTopic(int client_index, const std::vector<std::string>& params);
-		void commandQuit(int client_index, const std::vector<std::string>& params);
-		void commandMode(int client_index, const std::vector<std::string>& params);
+		void handleCommand(Client *client, const IrcMessage& message);
+		void commandPass(ClientHandle handle, const std::vector<std::string>& params);
+		void commandNick(ClientHandle handle, const std::vector<std::string>& params);
+		void commandUser(ClientHandle handle, const std::vector<std::string>& params);
+		void commandJoin(ClientHandle handle, const std::vector<std::string>& params);
+		void commandPrivmsg(ClientHandle handle, const std::vector<std::string>& params);
+		void commandKick(ClientHandle handle, const std::vector<std::string>& params);
+		void commandPart(ClientHandle handle, const std::vector<std::string>& params);
+		void commandNotice(ClientHandle handle, const std::vector<std::string>& params);
+		void commandInvite(ClientHandle handle, const std::vector<std::string>& params);
+		void commandTopic(ClientHandle handle, const std::vector<std::string>& params);
+		void commandQuit(ClientHandle handle, const std::vector<std::string>& params);
+		void commandMode(ClientHandle handle, const std::vector<std::string>& params);
+		void commandCap(ClientHandle handle, const std::vector<std::string>& params);
+		void commandPing(ClientHandle handle, const std::vector<std::string>& params);
+		void commandPong(ClientHandle handle, const std::vector<std::string>& params);
+		void commandChathistory(ClientHandle handle, const std::vector<std::string>& params);
+		void commandServer(ClientHandle handle, const std::vector<std::string>& params);
 		void run();
 
 		std::string generateUniqueNickname(const std::string& base_nickname);
 		static bool nicknameMatches(Client* client, const std::string& nickname);
 		Client* findClientByNickname(const std::string& nickname);
-		std::vector<struct pollfd> poll_fds;  // Liste des descripteurs de fichiers surveillés
+		void setClientNickname(Client *client, const std::string& nickname);
 
 	private:
+		friend class ServerSocketTest; // tests/test_server.cpp
+
+		typedef void (ServerSocket::*CommandHandler)(ClientHandle, const std::vector<std::string>&);
+		struct CommandDescriptor
+		{
+			const char		*name;
+			CommandHandler	handler;
+			size_t			min_params;
+			int				flags;
+			long			cost; // Jetons debites du seau du client
+		};
+		enum { LINK_SENDQ_FACTOR = 16 }; // sendq d'une liaison, en multiples de celui d'un client
+		enum { STATE_VERSION = 4 }; // Format transmis au nouveau binaire (SIGUSR2)
+		static const CommandDescriptor command_table[];
+		static const size_t command_count;
+		static const CommandDescriptor *lookupCommand(const StringView& name);
+		void dispatchCommand(Client *client, const CommandDescriptor *command, const std::vector<std::string>& params);
+
+		// Ligne recue d'un autre serveur : emetteur (prefixe sans !user@host),
+		// parametres, et la ligne elle-meme pour la relayer sans la reformater
+		struct LinkMessage
+		{
+			std::string					sender;
+			std::vector<std::string>&	params;
+			SharedBuffer				line;
+
+			LinkMessage(std::vector<std::string>& params) : params(params) {}
+		};
+		typedef void (ServerSocket::*LinkHandler)(Client*, const LinkMessage&);
+		struct LinkCommandDescriptor
+		{
+			const char		*name;
+			LinkHandler		handler;
+			size_t			min_params;
+		};
+		static const LinkCommandDescriptor link_table[];
+		static const LinkCommandDescriptor *lookupLinkCommand(const StringView& name);
+
+		// Pair de link_connect, rejoint par le reacteur 0
+		struct OutgoingLink
+		{
+			LinkPeer		peer;
+			ClientHandle	handle; // Connexion en cours ou etablie
+			uint64_t		retry_ms; // Prochaine tentative permise
+		};
+
 		std::string server_password;
 		int server_socket;
 		static ServerSocket *_ptrServer;
+		static volatile sig_atomic_t _stopRequested;
+		static volatile sig_atomic_t _upgradeRequested; // SIGUSR2 : relais vers un nouveau binaire
+		char **program_argv; // Reexecute tel quel lors du relais
+		std::string program_path; // argv[0] resolu dans le PATH
+		Config config;
+		std::vector<Reactor*> reactors; // Un par thread ; le 0 tourne sur le thread principal
+		pthread_key_t reactor_key; // Reacteur du thread courant
+		// Protege clients, nick_index, nick_suffix_hints, channels, links et network.
+		// Partage pour les commandes qui ne font que lire cet etat (CMD_SHARED),
+		// exclusif pour toute modification.
+		RwLock state_lock;
+		Stats stats; // Segment partage lu par ircstat
+
 		struct sockaddr_in server_addr;
-		std::vector<Client*> clients;
-		std::map<std::string, std::vector<Client*> > channels;
-		std::map<std::string, std::string> topics;
-		std::map<std::string, time_t> topic_times;
-		std::map<std::string, std::string> topic_set_by; // Nom de l'utilisateur qui a défini le topic
-		std::map<std::string, std::vector<char> > channel_modes; // Modes de canal
-		std::map<std::string, std::string> channel_passwords; // Mots de passe de canal
-		std::map<std::string, int> channel_limits; // Limites de canal
-		std::map<std::string, std::vector<Client*> > channel_operators; // Opérateurs de canal
-		std::map<std::string, std::vector<std::string> > channel_invitations; // Invitations de canal
-		std::map<std::string, std::vector<Client*> > pending_invites; //tentatives de connexion
+		ClientTable clients; // Indexee par fd, handles stables
+		StringMap<Client*> nick_index; // Pseudo replie (RFC 1459) -> client
+		StringMap<int> nick_suffix_hints; // Base repliee -> prochain suffixe a essayer
+		ChannelTable channels; // Nom replie -> ID interne -> Channel
+		ChannelStore channel_store; // Instantane + journal, si channel_store= est donne
+		unsigned int delivery_mark; // Numero du dernier envoi multi-cibles (verrou exclusif)
+		HistoryArena history_arena; // Lignes de tous les historiques de canaux
+		Mutex history_lock; // Arene et historiques, ecrits aussi sous le verrou partage
+		ConnectionLimiter limiter; // Admission par adresse source, avant toute allocation
+		Network network; // Serveurs distants, tous derriere l'une de nos liaisons
+		std::vector<Client*> links; // Liaisons etablies (sous state_lock)
+		std::vector<OutgoingLink> outgoing; // Une par pair de link_connect
 
+		int createListener(int port, bool reuse_port);
+		void runReactors();
+		bool upgrade();
+		std::string serializeState(std::vector<int>& fds);
+		bool restoreState(StateReader& reader, const std::vector<int>& fds, int version);
+		static void *reactorThread(void *arg);
+		void runReactor(Reactor& reactor);
+		void settleReactor(Reactor& reactor);
+		Reactor *currentReactor() const;
+		void deliverMailbox(Reactor& reactor);
+		void flushDirty(Reactor& reactor);
+		void queueOutput(Client *client, const SharedBuffer& message);
+		bool openStats(int port);
+		bool openChannelStore(bool create_channels);
+		void persistChannel(Channel *channel);
+		void destroyChannel(Channel *channel);
+		void processInput(Client *client);
+		void tryRegister(Client *client);
+		void detachFromChannels(Client *client);
+		void partChannel(Client *client, Channel *channel);
+		bool splitTargets(Client *client, const std::string& list, std::vector<std::string>& targets);
+		unsigned int nextDeliveryMark();
+		void joinChannel(Client *client, const std::string& name, const std::string& key);
+		void deliverMessage(ClientHandle handle, const std::vector<std::string>& params, const char *verb, bool notice);
+		void sendSupport(Client *client);
+		MessageTags recordHistory(Channel *channel, const SharedBuffer& line);
+		void echoMode(Client *client, const MessageBuilder& line);
+		void disconnect(Client *client);
+		int writeOutput(Client *client);
+		void flushClient(Client *client);
+		void sendCompleted(Client *client, int result);
+		void updateInterest(Client *client);
+		void deferInput(Client *client);
+		void processBacklog(Reactor& reactor);
+		int backlogTimeout(Reactor& reactor);
+		void runTimers(Reactor& reactor);
+		void clientTimeout(Client *client);
+		void closeClient(Client *client, const std::string& farewell);
 
+		void connectLinks(Reactor& reactor);
+		int linkTimeout(Reactor& reactor);
+		bool isOutgoing(Client *client) const;
+		void establishLink(Client *link, const std::string& name, const std::string& description);
+		void sendBurst(Client *link);
+		void closeLinks();
+		void propagate(const SharedBuffer& line, Client *except);
+		void introduceUser(Client *user, Client *except);
+		void forgetUser(Client *user);
+		void announceQuit(Client *user, const SharedBuffer& quit);
+		void splitServer(LinkedServer *server, const std::string& reason);
+		void removeRemoteUser(Client *user, const SharedBuffer& quit);
+		void killUser(Client *user, const std::string& reason);
+		void relayToChannel(Channel *channel, TaggedLine& line, Client *sender, Client *from, unsigned int mark);
+		Client *findRemoteUser(Client *link, const std::string& nickname);
+		bool isBehindLink(Client *link, const std::string& sender);
+		void handleLinkMessage(Client *link, const char *line, size_t len, const IrcMessage& message);
+		void linkServer(Client *link, const LinkMessage& message);
+		void linkSquit(Client *link, const LinkMessage& message);
+		void linkNick(Client *link, const LinkMessage& message);
+		void linkQuit(Client *link, const LinkMessage& message);
+		void linkKill(Client *link, const LinkMessage& message);
+		void linkNjoin(Client *link, const LinkMessage& message);
+		void linkPart(Client *link, const LinkMessage& message);
+		void linkKick(Client *link, const LinkMessage& message);
+		void linkTopic(Client *link, const LinkMessage& message);
+		void linkMode(Client *link, const LinkMessage& message);
+		void linkInvite(Client *link, const LinkMessage& message);
+		void linkMessage(Client *link, const LinkMessage& message);
+		void linkPing(Client *link, const LinkMessage& message);
+		void linkPong(Client *link, const LinkMessage& message);
+		void linkError(Client *link, const LinkMessage& message);
 };
 
-bool	isClientAutorize(std::vector<Client*> vec, Client *user);
-
 #endif
@@ -0,0 +1,96 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SharedBuffer.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "SharedBuffer.hpp"
+#include "BufferPool.hpp"
+#include <cstring>
+#include <new>
+
+SharedBuffer::SharedBuffer() : block(NULL) {}
+
+SharedBuffer::SharedBuffer(const std::string& message) : block(NULL)
+{
+	init(message.data(), message.size());
+}
+
+SharedBuffer::SharedBuffer(const char *data, size_t size) : block(NULL)
+{
+	init(data, size);
+}
+
+SharedBuffer::SharedBuffer(size_t size) : block(NULL)
+{
+	init(NULL, size);
+}
+
+void SharedBuffer::init(const char *data, size_t size)
+{
+	if (size == 0)
+		return;
+	block = static_cast<Block*>(BufferPool::allocate(offsetof(Block, data) + size));
+	block->refs = 1;
+	block->size = size;
+	if (data != NULL)
+		std::memcpy(block->data, data, size);
+}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other) : block(other.block)
+{
+	if (block)
+		__sync_add_and_fetch(&block->refs, 1);
+}
+
+SharedBuffer& SharedBuffer::operator=(const SharedBuffer& other)
+{
+	if (block != other.block)
+	{
+		if (other.block)
+			__sync_add_and_fetch(&other.block->refs, 1);
+		release();
+		block = other.block;
+	}
+	return *this;
+}
+
+SharedBuffer::~SharedBuffer()
+{
+	release();
+}
+
+void SharedBuffer::release()
+{
+	// Compteur atomique : un message peut etre partage entre reacteurs
+	if (block && __sync_sub_and_fetch(&block->refs, 1) == 0)
+		BufferPool::release(block, offsetof(Block, data) + block->size);
+	block = NULL;
+}
+
+const char *SharedBuffer::data() const
+{
+	return block ? block->data : NULL;
+}
+
+// Ecriture en place, uniquement tant que le bloc n'est pas partage
+char *SharedBuffer::writable()
+{
+	return block ? block->data : NULL;
+}
+
+size_t SharedBuffer::size() const
+{
+	return block ? block->size : 0;
+}
+
+bool SharedBuffer::empty() const
+{
+	return block == NULL;
+}
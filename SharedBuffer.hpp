@@ -0,0 +1,51 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   SharedBuffer.hpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef SHAREDBUFFER_HPP
+#define SHAREDBUFFER_HPP
+
+#include <string>
+#include <cstddef>
+
+// Message serialise une seule fois, immuable et a comptage de references.
+// Une diffusion sur un canal pousse la meme instance dans la file de chaque
+// membre : une copie de SharedBuffer ne coute qu'un increment.
+class SharedBuffer
+{
+	private:
+		struct Block
+		{
+			size_t	refs;
+			size_t	size;
+			char	data[1];
+		};
+		Block *block;
+
+		void init(const char *data, size_t size);
+		void release();
+
+	public:
+		SharedBuffer();
+		explicit SharedBuffer(const std::string& message);
+		SharedBuffer(const char *data, size_t size);
+		explicit SharedBuffer(size_t size); // Non initialise : remplir via writable() avant de partager
+		SharedBuffer(const SharedBuffer& other);
+		SharedBuffer& operator=(const SharedBuffer& other);
+		~SharedBuffer();
+
+		const char *data() const;
+		char *writable();
+		size_t size() const;
+		bool empty() const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   StateCodec.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "StateCodec.hpp"
+#include <cstring>
+
+void StateWriter::putBytes(const char *data, size_t size)
+{
+	putU32(size);
+	out.append(data, size);
+}
+
+bool StateReader::take(void *dest, size_t count)
+{
+	if (!valid || size - pos < count)
+	{
+		valid = false;
+		std::memset(dest, 0, count);
+		return false;
+	}
+	std::memcpy(dest, in + pos, count);
+	pos += count;
+	return true;
+}
+
+uint8_t StateReader::getU8()
+{
+	uint8_t value;
+	take(&value, sizeof(value));
+	return value;
+}
+
+uint32_t StateReader::getU32()
+{
+	uint32_t value;
+	take(&value, sizeof(value));
+	return value;
+}
+
+uint64_t StateReader::getU64()
+{
+	uint64_t value;
+	take(&value, sizeof(value));
+	return value;
+}
+
+std::string StateReader::getString()
+{
+	uint32_t length = getU32();
+	if (!valid || size - pos < length)
+	{
+		valid = false;
+		return std::string();
+	}
+	std::string value(in + pos, length);
+	pos += length;
+	return value;
+}
@@ -0,0 +1,59 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   StateCodec.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef STATECODEC_HPP
+#define STATECODEC_HPP
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+// Serialisation binaire, entiers en ordre de l'hote (meme machine)
+class StateWriter
+{
+	private:
+		std::string& out;
+
+	public:
+		explicit StateWriter(std::string& out) : out(out) {}
+		void putU8(uint8_t value) { out.append(1, static_cast<char>(value)); }
+		void putU32(uint32_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+		void putU64(uint64_t value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+		void putBytes(const char *data, size_t size);
+		void putString(const std::string& value) { putBytes(value.data(), value.size()); }
+};
+
+// Chaque lecture au-dela de la fin met ok() a faux et rend une valeur nulle.
+// Lit en place : la source (chaine, fichier mappe) doit survivre au lecteur.
+class StateReader
+{
+	private:
+		const char *in;
+		size_t size;
+		size_t pos;
+		bool valid;
+
+		bool take(void *dest, size_t count);
+
+	public:
+		explicit StateReader(const std::string& in) : in(in.data()), size(in.size()), pos(0), valid(true) {}
+		StateReader(const char *data, size_t size) : in(data), size(size), pos(0), valid(true) {}
+		uint8_t getU8();
+		uint32_t getU32();
+		uint64_t getU64();
+		std::string getString();
+		bool ok() const { return valid; }
+		size_t offset() const { return pos; }
+		bool atEnd() const { return pos == size; }
+};
+
+#endif
@@ -0,0 +1,76 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Stats.cpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Stats.hpp"
+#include "Logger.hpp"
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h> // open
+#include <unistd.h> // ftruncate, close, unlink, getpid
+#include <sys/mman.h> // mmap
+
+Stats::Stats() : base(NULL), length(0)
+{
+}
+
+Stats::~Stats()
+{
+	if (base != NULL)
+		munmap(base, length);
+	if (!path.empty())
+		unlink(path.c_str());
+}
+
+bool Stats::open(const std::string& path, size_t shard_count, const std::vector<std::string>& commands)
+{
+	length = StatsHeader::segmentSize(shard_count);
+	if (!path.empty())
+	{
+		int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd >= 0 && ftruncate(fd, length) == 0)
+		{
+			base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (base == MAP_FAILED)
+				base = NULL;
+		}
+		if (fd >= 0)
+			close(fd);
+		if (base != NULL)
+			this->path = path;
+		else
+			LOG_WARN << "Cannot map stats segment " << path << ": " << std::strerror(errno);
+	}
+	if (base == NULL)
+	{
+		base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base == MAP_FAILED)
+		{
+			base = NULL;
+			return false;
+		}
+	}
+
+	// Le fichier vient d'etre tronque : tout est deja a zero
+	StatsHeader& head = header();
+	head.version = STATS_VERSION;
+	head.shard_count = shard_count;
+	head.command_count = std::min(commands.size(), static_cast<size_t>(StatsShard::MAX_COMMANDS));
+	head.pid = getpid();
+	head.started = time(NULL);
+	for (size_t i = 0; i < head.command_count; ++i)
+		std::strncpy(head.command_names[i], commands[i].c_str(), sizeof(head.command_names[i]) - 1);
+	__sync_synchronize();
+	std::memcpy(head.magic, STATS_MAGIC, sizeof(head.magic));
+	return true;
+}
@@ -0,0 +1,102 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Stats.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Compteurs d'un reacteur. Un seul thread ecrit dans chaque shard, par de
+// simples additions en memoire : ni verrou, ni atomique, ni appel systeme.
+// Le lecteur (ircstat) fait la somme des shards. Taille multiple de 64 pour
+// que deux reacteurs ne partagent jamais une ligne de cache.
+struct StatsShard
+{
+	enum { MAX_COMMANDS = 32 };
+
+	volatile uint64_t accepted; // Connexions acceptees
+	volatile uint64_t closed; // Connexions fermees
+	volatile uint64_t registrations;
+	volatile uint64_t bytes_in;
+	volatile uint64_t bytes_out;
+	volatile uint64_t lines_in;
+	volatile uint64_t messages_out; // Messages mis en file (references partagees comprises)
+	volatile uint64_t sendq_bytes; // Jauge : octets en attente dans les files de sortie
+	volatile uint64_t sendq_exceeded; // Clients coupes pour SendQ depassee
+	volatile uint64_t cross_posts; // Messages remis via la boite d'un autre reacteur
+	volatile uint64_t unknown_commands;
+	volatile uint64_t commands[MAX_COMMANDS]; // Indexe comme command_table
+	volatile uint64_t throttled; // Clients mis en attente par le controle de flood
+	volatile uint64_t write_calls; // Appels writev() vers les clients
+	volatile uint64_t buffer_hits; // Blocs de message servis par la BufferPool
+	volatile uint64_t buffer_misses; // Blocs alloues par operator new
+	volatile uint64_t accept_batches; // Reveils du socket d'ecoute avec des connexions en attente
+	volatile uint64_t accept_capped; // Lots arretes a accept_batch, la suite au tour suivant
+	volatile uint64_t accept_errors; // accept() en echec (EMFILE, ENFILE, ENOBUFS...)
+	volatile uint64_t accept_queue_peak; // Jauge : plus longue file d'acceptation observee
+	volatile uint64_t rejected_ip_limit; // Refusees : trop de connexions ouvertes depuis ce prefixe
+	volatile uint64_t rejected_ip_rate; // Refusees : connexions trop rapprochees depuis ce prefixe
+	uint64_t reserved[3];
+};
+
+// En-tete du segment, suivi de shard_count StatsShard alignes sur 64 octets.
+// Les jauges globales sont modifiees sous le verrou d'etat du serveur.
+struct StatsHeader
+{
+	char magic[8]; // "IRCSTAT1", ecrit en dernier
+	uint32_t version;
+	uint32_t shard_count;
+	uint32_t command_count;
+	uint32_t pid;
+	int64_t started;
+	char command_names[StatsShard::MAX_COMMANDS][16];
+	volatile uint64_t channels;
+	volatile uint64_t members; // Total des appartenances canal/client
+	volatile uint64_t nicknames;
+
+	static size_t shardsOffset() { return (sizeof(StatsHeader) + 63) & ~static_cast<size_t>(63); }
+	static size_t segmentSize(size_t shard_count) { return shardsOffset() + shard_count * sizeof(StatsShard); }
+};
+
+#define STATS_MAGIC "IRCSTAT1"
+#define STATS_VERSION 2
+
+// Proprietaire du segment cote serveur : fichier mappe en MAP_SHARED, ou
+// memoire anonyme si aucun chemin n'est donne (les compteurs restent
+// incrementes, personne ne les lit).
+class Stats
+{
+	private:
+		void *base;
+		size_t length;
+		std::string path;
+
+		Stats(const Stats&);
+		Stats& operator=(const Stats&);
+
+	public:
+		Stats();
+		~Stats();
+		bool open(const std::string& path, size_t shard_count, const std::vector<std::string>& commands);
+		StatsHeader& header() { return *static_cast<StatsHeader*>(base); }
+		StatsShard& shard(size_t i)
+		{
+			return reinterpret_cast<StatsShard*>(static_cast<char*>(base) + StatsHeader::shardsOffset())[i];
+		}
+		const std::string& getPath() const { return path; }
+		// Le fichier appartient desormais au nouveau processus : ne pas l'effacer
+		void detach() { path.clear(); }
+};
+
+#endif
@@ -0,0 +1,144 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   StringMap.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef STRINGMAP_HPP
+#define STRINGMAP_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Table de hachage std::string -> T, adressage ouvert et sondage lineaire.
+// Les cles sont utilisees telles quelles : les appelants les normalisent
+// (ircFold) avant insertion et recherche.
+template<typename T>
+class StringMap
+{
+	private:
+		enum State { EMPTY, USED, DELETED };
+		struct Bucket
+		{
+			std::string	key;
+			T			value;
+			State		state;
+			Bucket() : value(), state(EMPTY) {}
+		};
+		std::vector<Bucket> buckets;
+		size_t used; // cles presentes
+		size_t filled; // cles presentes + tombes
+
+		static size_t hash(const std::string& key)
+		{
+			// FNV-1a
+			size_t h = 2166136261u;
+			for (size_t i = 0; i < key.size(); ++i)
+			{
+				h ^= static_cast<unsigned char>(key[i]);
+				h *= 16777619u;
+			}
+			return h;
+		}
+
+		size_t probe(const std::string& key) const
+		{
+			size_t mask = buckets.size() - 1;
+			size_t i = hash(key) & mask;
+			while (buckets[i].state != EMPTY)
+			{
+				if (buckets[i].state == USED && buckets[i].key == key)
+					return i;
+				i = (i + 1) & mask;
+			}
+			return buckets.size();
+		}
+
+		void rehash(size_t capacity)
+		{
+			std::vector<Bucket> old;
+			old.swap(buckets);
+			buckets.resize(capacity);
+			used = 0;
+			filled = 0;
+			for (size_t i = 0; i < old.size(); ++i)
+				if (old[i].state == USED)
+					insert(old[i].key, old[i].value);
+		}
+
+	public:
+		StringMap() : buckets(16), used(0), filled(0) {}
+
+		T *find(const std::string& key)
+		{
+			size_t i = probe(key);
+			return i == buckets.size() ? NULL : &buckets[i].value;
+		}
+
+		const T *find(const std::string& key) const
+		{
+			size_t i = probe(key);
+			return i == buckets.size() ? NULL : &buckets[i].value;
+		}
+
+		// Retourne false (sans rien modifier) si la cle existe deja
+		bool insert(const std::string& key, const T& value)
+		{
+			if ((filled + 1) * 4 > buckets.size() * 3)
+				rehash(used * 2 >= buckets.size() / 2 ? buckets.size() * 2 : buckets.size());
+			size_t mask = buckets.size() - 1;
+			size_t i = hash(key) & mask;
+			size_t slot = buckets.size();
+			while (buckets[i].state != EMPTY)
+			{
+				if (buckets[i].state == USED && buckets[i].key == key)
+					return false;
+				if (buckets[i].state == DELETED && slot == buckets.size())
+					slot = i;
+				i = (i + 1) & mask;
+			}
+			if (slot == buckets.size())
+			{
+				slot = i;
+				++filled;
+			}
+			buckets[slot].key = key;
+			buckets[slot].value = value;
+			buckets[slot].state = USED;
+			++used;
+			return true;
+		}
+
+		bool erase(const std::string& key)
+		{
+			size_t i = probe(key);
+			if (i == buckets.size())
+				return false;
+			buckets[i].state = DELETED;
+			buckets[i].key.clear();
+			buckets[i].value = T();
+			--used;
+			return true;
+		}
+
+		void clear()
+		{
+			buckets.assign(16, Bucket());
+			used = 0;
+			filled = 0;
+		}
+
+		size_t size() const
+		{
+			return used;
+		}
+};
+
+#endif
@@ -0,0 +1,128 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "TimerWheel.hpp"
+
+TimerWheel::TimerWheel(uint64_t now_ms) : current(now_ms / TICK_MS), count(0)
+{
+	for (int level = 0; level < LEVELS; ++level)
+	{
+		for (int slot = 0; slot < SLOTS; ++slot)
+		{
+			slots[level][slot].prev = &slots[level][slot];
+			slots[level][slot].next = &slots[level][slot];
+		}
+	}
+}
+
+// Le niveau est choisi selon l'ecart avec le tick courant, la case selon
+// les bits correspondants de l'echeance
+void TimerWheel::insert(Timer *timer)
+{
+	uint64_t delta = timer->expires > current ? timer->expires - current : 0;
+	int level = 0;
+	while (level < LEVELS - 1 && delta >= (static_cast<uint64_t>(1) << (SLOT_BITS * (level + 1))))
+		++level;
+	uint64_t max_delta = (static_cast<uint64_t>(1) << (SLOT_BITS * LEVELS)) - 1;
+	if (delta > max_delta)
+		timer->expires = current + max_delta;
+	Timer *head = &slots[level][(timer->expires >> (SLOT_BITS * level)) & (SLOTS - 1)];
+	timer->next = head;
+	timer->prev = head->prev;
+	head->prev->next = timer;
+	head->prev = timer;
+}
+
+void TimerWheel::schedule(Timer *timer, uint64_t expires_ms)
+{
+	cancel(timer);
+	timer->expires = (expires_ms + TICK_MS - 1) / TICK_MS;
+	// Une echeance passee expire au prochain tick
+	if (timer->expires <= current)
+		timer->expires = current + 1;
+	insert(timer);
+	++count;
+}
+
+void TimerWheel::cancel(Timer *timer)
+{
+	if (!timer->isScheduled())
+		return;
+	timer->prev->next = timer->next;
+	timer->next->prev = timer->prev;
+	timer->prev = NULL;
+	timer->next = NULL;
+	--count;
+}
+
+// Redistribue la case courante d'un niveau superieur dans les niveaux
+// inferieurs
+void TimerWheel::cascade(int level)
+{
+	Timer *head = &slots[level][(current >> (SLOT_BITS * level)) & (SLOTS - 1)];
+	Timer *timer = head->next;
+	head->next = head;
+	head->prev = head;
+	while (timer != head)
+	{
+		Timer *next = timer->next;
+		insert(timer);
+		timer = next;
+	}
+}
+
+void TimerWheel::advance(uint64_t now_ms, std::vector<Timer*>& expired)
+{
+	uint64_t target = now_ms / TICK_MS;
+	while (current < target)
+	{
+		++current;
+		for (int level = 1; level < LEVELS; ++level)
+		{
+			if ((current & ((static_cast<uint64_t>(1) << (SLOT_BITS * level)) - 1)) != 0)
+				break;
+			cascade(level);
+		}
+		Timer *head = &slots[0][current & (SLOTS - 1)];
+		while (head->next != head)
+		{
+			Timer *timer = head->next;
+			cancel(timer);
+			expired.push_back(timer);
+		}
+	}
+}
+
+// Cherche la prochaine case non vide du niveau 0 ; a defaut, se reveille
+// au prochain tour de roue pour la cascade.
+int TimerWheel::nextTimeout(uint64_t now_ms) const
+{
+	if (count == 0)
+		return -1;
+	uint64_t ticks = SLOTS - (current & (SLOTS - 1));
+	for (uint64_t i = 1; i < ticks; ++i)
+	{
+		const Timer *head = &slots[0][(current + i) & (SLOTS - 1)];
+		if (head->next != head)
+		{
+			ticks = i;
+			break;
+		}
+	}
+	uint64_t wake_ms = (current + ticks) * TICK_MS;
+	return wake_ms > now_ms ? static_cast<int>(wake_ms - now_ms) : 0;
+}
+
+size_t TimerWheel::size() const
+{
+	return count;
+}
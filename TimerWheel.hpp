@@ -0,0 +1,71 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TimerWheel.hpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+// Minuterie intrusive : embarquee dans l'objet qu'elle concerne (un Client
+// par exemple), elle ne coute aucune allocation. `kind` et `data` disent a
+// qui la declenche quoi faire.
+struct Timer
+{
+	Timer		*prev;
+	Timer		*next; // NULL tant que la minuterie n'est pas armee
+	uint64_t	expires; // en ticks
+	int			kind;
+	void		*data;
+
+	Timer() : prev(NULL), next(NULL), expires(0), kind(0), data(NULL) {}
+	bool isScheduled() const { return next != NULL; }
+};
+
+// Roue hierarchique (4 niveaux de 64 cases) : armer, annuler et faire
+// expirer une minuterie sont en O(1), sans jamais parcourir les clients.
+// Les minuteries lointaines descendent d'un niveau a chaque tour complet du
+// niveau inferieur. Pas de verrou : une roue par reacteur.
+class TimerWheel
+{
+	public:
+		enum
+		{
+			TICK_MS = 100,
+			SLOT_BITS = 6,
+			SLOTS = 1 << SLOT_BITS,
+			LEVELS = 4 // 64^4 ticks, soit environ 19 jours
+		};
+
+		explicit TimerWheel(uint64_t now_ms);
+		void schedule(Timer *timer, uint64_t expires_ms);
+		void cancel(Timer *timer);
+		// Avance jusqu'a now_ms et ajoute les minuteries echues a `expired`
+		void advance(uint64_t now_ms, std::vector<Timer*>& expired);
+		// Delai d'attente maximal pour la boucle (-1 : aucune minuterie)
+		int nextTimeout(uint64_t now_ms) const;
+		size_t size() const;
+
+	private:
+		Timer slots[LEVELS][SLOTS]; // sentinelles des listes circulaires
+		uint64_t current; // tick courant
+		size_t count;
+
+		void insert(Timer *timer);
+		void cascade(int level);
+
+		TimerWheel(const TimerWheel&);
+		TimerWheel& operator=(const TimerWheel&);
+};
+
+#endif
@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   TokenBucket.hpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef TOKENBUCKET_HPP
+#define TOKENBUCKET_HPP
+
+#include <stdint.h>
+
+// Seau a jetons d'un client, en milliemes de jeton pour rester en entier.
+// Le seau se remplit de `rate` jetons par seconde jusqu'a `burst`. Une
+// commande est acceptee tant que le solde est positif et son cout est
+// ensuite debite, quitte a passer en negatif : une commande chere passe,
+// mais retarde d'autant les suivantes.
+class TokenBucket
+{
+	private:
+		long		tokens;
+		uint64_t	last_ms;
+
+	public:
+		TokenBucket() : tokens(0), last_ms(0) {}
+
+		void reset(uint64_t now_ms, long burst)
+		{
+			tokens = burst * 1000;
+			last_ms = now_ms;
+		}
+
+		// rate == 0 : controle desactive
+		bool ready(uint64_t now_ms, long rate, long burst)
+		{
+			if (rate == 0)
+				return true;
+			if (now_ms > last_ms)
+			{
+				tokens += static_cast<long>(now_ms - last_ms) * rate;
+				if (tokens > burst * 1000)
+					tokens = burst * 1000;
+				last_ms = now_ms;
+			}
+			return tokens > 0;
+		}
+
+		void consume(long cost)
+		{
+			tokens -= cost * 1000;
+		}
+
+		// Seau rempli : plus aucune trace de l'activite passee
+		bool isFull(uint64_t now_ms, long rate, long burst)
+		{
+			return rate == 0 || (ready(now_ms, rate, burst) && tokens >= burst * 1000);
+		}
+
+		// Delai avant que ready() redevienne vrai
+		uint64_t msUntilReady(long rate) const
+		{
+			if (rate == 0 || tokens > 0)
+				return 0;
+			return (-tokens) / rate + 1;
+		}
+};
+
+#endif
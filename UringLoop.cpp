@@ -0,0 +1,729 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   UringLoop.cpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "UringLoop.hpp"
+
+#ifdef HAVE_IO_URING
+
+#include "Logger.hpp"
+#include <unistd.h> // close, syscall
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+// Pas de liburing : les trois appels systeme suffisent
+static int ioUringSetup(unsigned int entries, struct io_uring_params *params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned int to_submit, unsigned int min_complete,
+	unsigned int flags, void *arg, size_t size)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, size));
+}
+
+static int ioUringRegister(int fd, unsigned int opcode, void *arg, unsigned int count)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+UringLoop::Registration::Registration() : data(NULL), generation(0), interest(0), mode(MODE_POLL),
+	active(false), read_live(false), read_cancel(false), write_live(false), queued(false),
+	ready(0), status(0), chunk_head(0), accepted_head(0) {}
+
+UringLoop::UringLoop() : ring_fd(-1), ring(MAP_FAILED), ring_size(0), sqes(NULL), sqes_size(0),
+	sq_head(NULL), sq_tail(NULL), sq_array(NULL), sq_mask(0), sq_entries(0), sq_local_tail(0),
+	cq_head(NULL), cq_tail(NULL), cq_mask(0), cqes(NULL), buffer_ring(NULL), buffer_ring_size(0),
+	buffers(NULL), buffer_tail(0), buffers_returned(false), quiesced(false), inflight(0)
+{
+	if (!setupRing() || !probeOperations() || !setupBuffers())
+	{
+		// isValid() regarde `buffers`, alloue en dernier
+		if (buffers != NULL)
+			munmap(buffers, static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+		buffers = NULL;
+	}
+}
+
+UringLoop::~UringLoop()
+{
+	// La fermeture de l'anneau annule tout ce qui est encore en vol
+	if (ring_fd != -1)
+		close(ring_fd);
+	for (size_t fd = 0; fd < registrations.size(); ++fd)
+		for (size_t i = registrations[fd].accepted_head; i < registrations[fd].accepted.size(); ++i)
+			close(registrations[fd].accepted[i]);
+	if (buffers != NULL)
+		munmap(buffers, static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+	if (buffer_ring != NULL)
+		munmap(buffer_ring, buffer_ring_size);
+	if (sqes != NULL)
+		munmap(sqes, sqes_size);
+	if (ring != MAP_FAILED)
+		munmap(ring, ring_size);
+}
+
+bool UringLoop::isValid() const
+{
+	return buffers != NULL;
+}
+
+//----------------------MISE EN PLACE-----
+
+bool UringLoop::setupRing()
+{
+	struct io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	// CQ large : un recv multishot peut livrer plusieurs completions par tour
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = CQ_ENTRIES;
+	ring_fd = ioUringSetup(SQ_ENTRIES, &params);
+	if (ring_fd < 0)
+	{
+		LOG_DEBUG << "io_uring_setup: " << std::strerror(errno);
+		ring_fd = -1;
+		return false;
+	}
+	// Descripteurs d'envoi copies a la soumission (SUBMIT_STABLE), attente
+	// avec delai (EXT_ARG), completions jamais perdues (NODROP)
+	const unsigned int required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP
+		| IORING_FEAT_SUBMIT_STABLE | IORING_FEAT_FAST_POLL | IORING_FEAT_EXT_ARG;
+	if ((params.features & required) != required)
+		return false;
+
+	ring_size = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned int),
+		params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe));
+	ring = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd, IORING_OFF_SQ_RING);
+	if (ring == MAP_FAILED)
+		return false;
+	sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	void *entries = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		ring_fd, IORING_OFF_SQES);
+	if (entries == MAP_FAILED)
+		return false;
+	sqes = static_cast<struct io_uring_sqe*>(entries);
+
+	char *base = static_cast<char*>(ring);
+	sq_head = reinterpret_cast<unsigned int*>(base + params.sq_off.head);
+	sq_tail = reinterpret_cast<unsigned int*>(base + params.sq_off.tail);
+	sq_mask = *reinterpret_cast<unsigned int*>(base + params.sq_off.ring_mask);
+	sq_array = reinterpret_cast<unsigned int*>(base + params.sq_off.array);
+	sq_entries = params.sq_entries;
+	sq_local_tail = *sq_tail;
+	cq_head = reinterpret_cast<unsigned int*>(base + params.cq_off.head);
+	cq_tail = reinterpret_cast<unsigned int*>(base + params.cq_off.tail);
+	cq_mask = *reinterpret_cast<unsigned int*>(base + params.cq_off.ring_mask);
+	cqes = reinterpret_cast<struct io_uring_cqe*>(base + params.cq_off.cqes);
+	slots.resize(sq_entries);
+	return true;
+}
+
+// Le recv multishot (6.0) n'a pas d'opcode propre a sonder : SEND_ZC est
+// arrive dans la meme version et sert de temoin
+bool UringLoop::probeOperations()
+{
+	static const int needed[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SENDMSG,
+		IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL, IORING_OP_SEND_ZC };
+	const unsigned int count = 256;
+	std::vector<uint64_t> storage((sizeof(struct io_uring_probe)
+		+ count * sizeof(struct io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+	struct io_uring_probe *probe = reinterpret_cast<struct io_uring_probe*>(&storage[0]);
+	if (ioUringRegister(ring_fd, IORING_REGISTER_PROBE, probe, count) < 0)
+		return false;
+	for (size_t i = 0; i < sizeof(needed) / sizeof(needed[0]); ++i)
+		if (needed[i] > probe->last_op || !(probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED))
+			return false;
+	return true;
+}
+
+bool UringLoop::setupBuffers()
+{
+	buffer_ring_size = BUFFER_COUNT * sizeof(struct io_uring_buf);
+	void *memory = mmap(NULL, buffer_ring_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return false;
+	buffer_ring = static_cast<struct io_uring_buf*>(memory);
+
+	struct io_uring_buf_reg reg;
+	std::memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<uintptr_t>(buffer_ring);
+	reg.ring_entries = BUFFER_COUNT;
+	reg.bgid = BUFFER_GROUP;
+	if (ioUringRegister(ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+	{
+		LOG_DEBUG << "io_uring buffer ring: " << std::strerror(errno);
+		return false;
+	}
+	// Pages engagees au premier recv qui les utilise
+	memory = mmap(NULL, static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return false;
+	buffers = static_cast<char*>(memory);
+	for (unsigned int id = 0; id < BUFFER_COUNT; ++id)
+		recycle(static_cast<uint16_t>(id));
+	buffers_returned = false;
+	return true;
+}
+
+//----------------------ANNEAUX-----
+
+uint64_t UringLoop::tag(Operation op, uint32_t generation, int fd)
+{
+	return (static_cast<uint64_t>(op) << 56)
+		| (static_cast<uint64_t>(generation & 0xffffff) << 32)
+		| static_cast<uint32_t>(fd);
+}
+
+UringLoop::Operation UringLoop::readOperation(const Registration& reg)
+{
+	if (reg.mode == MODE_ACCEPT)
+		return OP_ACCEPT;
+	if (reg.mode == MODE_RECV)
+		return OP_RECV;
+	return OP_POLL_READ;
+}
+
+UringLoop::Registration *UringLoop::lookup(int fd)
+{
+	if (fd < 0 || static_cast<size_t>(fd) >= registrations.size())
+		return NULL;
+	return &registrations[fd];
+}
+
+struct io_uring_sqe *UringLoop::nextSqe()
+{
+	if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+	{
+		// SQ pleine : on soumet ce qui est pret, sans attendre de completion
+		submit(0, 0);
+		if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+			return NULL;
+	}
+	unsigned int index = sq_local_tail & sq_mask;
+	struct io_uring_sqe *sqe = &sqes[index];
+	std::memset(sqe, 0, sizeof(*sqe));
+	sq_array[index] = index;
+	++sq_local_tail;
+	return sqe;
+}
+
+// Publie les entrees preparees et attend au moins `min_complete` completions
+int UringLoop::submit(unsigned int min_complete, int timeout_ms)
+{
+	__atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+	unsigned int pending = sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+	if (pending == 0 && min_complete == 0)
+		return 0;
+	unsigned int flags = 0;
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	void *argp = NULL;
+	size_t size = 0;
+	if (min_complete > 0)
+	{
+		flags |= IORING_ENTER_GETEVENTS;
+		if (timeout_ms >= 0)
+		{
+			std::memset(&arg, 0, sizeof(arg));
+			ts.tv_sec = timeout_ms / 1000;
+			ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000LL;
+			arg.ts = reinterpret_cast<uintptr_t>(&ts);
+			flags |= IORING_ENTER_EXT_ARG;
+			argp = &arg;
+			size = sizeof(arg);
+		}
+	}
+	return ioUringEnter(ring_fd, pending, min_complete, flags, argp, size);
+}
+
+void UringLoop::reap()
+{
+	unsigned int head = *cq_head;
+	unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+	while (head != tail)
+	{
+		complete(cqes[head & cq_mask]);
+		++head;
+	}
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+void UringLoop::recycle(uint16_t buffer_id)
+{
+	struct io_uring_buf& entry = buffer_ring[buffer_tail & (BUFFER_COUNT - 1)];
+	entry.addr = reinterpret_cast<uintptr_t>(buffers + static_cast<size_t>(buffer_id) * BUFFER_SIZE);
+	entry.len = BUFFER_SIZE;
+	entry.bid = buffer_id;
+	++buffer_tail;
+	// La queue de l'anneau recouvre le champ resv de la premiere entree
+	__atomic_store_n(&buffer_ring[0].resv, buffer_tail, __ATOMIC_RELEASE);
+	buffers_returned = true;
+}
+
+void UringLoop::signal(int fd, Registration& reg, int events)
+{
+	reg.ready |= events;
+	if (!reg.queued)
+	{
+		reg.queued = true;
+		ready_fds.push_back(fd);
+	}
+}
+
+//----------------------REQUETES-----
+
+void UringLoop::armRead(int fd, Registration& reg)
+{
+	struct io_uring_sqe *sqe = quiesced ? NULL : nextSqe();
+	if (sqe == NULL)
+	{
+		rearm.push_back(fd);
+		return;
+	}
+	sqe->fd = fd;
+	sqe->user_data = tag(readOperation(reg), reg.generation, fd);
+	if (reg.mode == MODE_ACCEPT)
+	{
+		sqe->opcode = IORING_OP_ACCEPT;
+		sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+		sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	}
+	else if (reg.mode == MODE_RECV)
+	{
+		// Le noyau choisit le tampon a l'arrivee des donnees
+		sqe->opcode = IORING_OP_RECV;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->flags = IOSQE_BUFFER_SELECT;
+		sqe->buf_group = BUFFER_GROUP;
+	}
+	else
+	{
+		sqe->opcode = IORING_OP_POLL_ADD;
+		sqe->len = IORING_POLL_ADD_MULTI;
+		sqe->poll32_events = POLLIN;
+	}
+	reg.read_live = true;
+	++inflight;
+}
+
+// Attente d'ecriture a un coup : le sendmsg suivant dira si la place manque encore
+void UringLoop::armWrite(int fd, Registration& reg)
+{
+	struct io_uring_sqe *sqe = quiesced ? NULL : nextSqe();
+	if (sqe == NULL)
+	{
+		rearm.push_back(fd);
+		return;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll32_events = POLLOUT;
+	sqe->user_data = tag(OP_POLL_WRITE, reg.generation, fd);
+	reg.write_live = true;
+	++inflight;
+}
+
+void UringLoop::cancel(uint64_t user_data, int fd, unsigned int flags)
+{
+	struct io_uring_sqe *sqe = nextSqe();
+	if (sqe == NULL)
+		return;
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->addr = user_data;
+	sqe->fd = fd;
+	sqe->cancel_flags = flags;
+	sqe->user_data = tag(OP_CANCEL, 0, 0);
+	++inflight;
+}
+
+void UringLoop::complete(const struct io_uring_cqe& cqe)
+{
+	Operation op = static_cast<Operation>(cqe.user_data >> 56);
+	uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32) & 0xffffff;
+	int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+	bool more = cqe.flags & IORING_CQE_F_MORE;
+	if (!more)
+		--inflight;
+	if (op == OP_CANCEL)
+		return;
+	Registration *reg = lookup(fd);
+	if (reg == NULL || !reg->active || reg->generation != generation)
+	{
+		// fd retire entre-temps : on ne fait que rendre les ressources
+		if (cqe.flags & IORING_CQE_F_BUFFER)
+			recycle(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+		if (op == OP_ACCEPT && cqe.res >= 0)
+			close(cqe.res);
+		return;
+	}
+	switch (op)
+	{
+		case OP_ACCEPT:
+			if (cqe.res >= 0)
+				reg->accepted.push_back(cqe.res);
+			else if (cqe.res != -ECANCELED)
+				reg->status = cqe.res;
+			if (cqe.res != -ECANCELED)
+				signal(fd, *reg, EV_READ);
+			if (!more)
+			{
+				reg->read_live = false;
+				reg->read_cancel = false;
+				if (reg->interest & EV_READ)
+					rearm.push_back(fd);
+			}
+			break;
+		case OP_RECV:
+			if (cqe.flags & IORING_CQE_F_BUFFER)
+			{
+				uint16_t id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+				if (cqe.res > 0)
+				{
+					Chunk chunk = { id, 0, static_cast<uint16_t>(cqe.res) };
+					reg->chunks.push_back(chunk);
+				}
+				else
+					recycle(id);
+			}
+			if (cqe.res == 0)
+				reg->status = 1;
+			else if (cqe.res < 0 && cqe.res != -ECANCELED && cqe.res != -ENOBUFS)
+				reg->status = cqe.res;
+			if (cqe.res >= 0 || reg->status < 0)
+				signal(fd, *reg, EV_READ);
+			if (!more)
+			{
+				reg->read_live = false;
+				reg->read_cancel = false;
+				// Plus de tampon libre : inutile de rearmer avant qu'un lecteur en rende
+				if (cqe.res == -ENOBUFS)
+					starved.push_back(fd);
+				else if (reg->status == 0 && (reg->interest & EV_READ))
+					rearm.push_back(fd);
+			}
+			break;
+		case OP_POLL_READ:
+			if (cqe.res > 0)
+				signal(fd, *reg, EV_READ);
+			if (!more)
+			{
+				reg->read_live = false;
+				reg->read_cancel = false;
+				if (reg->interest & EV_READ)
+					rearm.push_back(fd);
+			}
+			break;
+		case OP_POLL_WRITE:
+			reg->write_live = false;
+			if (cqe.res != -ECANCELED)
+				signal(fd, *reg, EV_WRITE);
+			break;
+		case OP_SEND:
+		{
+			Event ev;
+			ev.data = reg->data;
+			ev.events = EV_SENT;
+			ev.result = cqe.res;
+			sent.push_back(ev);
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void UringLoop::release(Registration& reg)
+{
+	for (size_t i = reg.chunk_head; i < reg.chunks.size(); ++i)
+		recycle(reg.chunks[i].buffer_id);
+	reg.chunks.clear();
+	reg.chunk_head = 0;
+	for (size_t i = reg.accepted_head; i < reg.accepted.size(); ++i)
+		close(reg.accepted[i]);
+	reg.accepted.clear();
+	reg.accepted_head = 0;
+	// `queued` reste tel quel : le fd est peut-etre encore dans ready_fds
+	reg.generation = (reg.generation + 1) & 0xffffff;
+	reg.data = NULL;
+	reg.interest = 0;
+	reg.active = false;
+	reg.read_live = false;
+	reg.read_cancel = false;
+	reg.write_live = false;
+	reg.ready = 0;
+	reg.status = 0;
+}
+
+//----------------------INTERFACE-----
+
+bool UringLoop::add(int fd, void *data, int events)
+{
+	if (fd < 0)
+		return false;
+	if (registrations.size() <= static_cast<size_t>(fd))
+		registrations.resize(fd + 1);
+	Registration& reg = registrations[fd];
+	if (reg.active)
+		release(reg);
+	// Socket d'ecoute, socket connecte, ou autre (pipe de reveil)
+	int listening = 0;
+	socklen_t length = sizeof(listening);
+	if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length) < 0)
+		reg.mode = MODE_POLL;
+	else
+		reg.mode = listening ? MODE_ACCEPT : MODE_RECV;
+	reg.data = data;
+	reg.interest = events;
+	reg.active = true;
+	if (events & EV_READ)
+		armRead(fd, reg);
+	if (events & EV_WRITE)
+		armWrite(fd, reg);
+	return true;
+}
+
+bool UringLoop::modify(int fd, void *data, int events)
+{
+	Registration *reg = lookup(fd);
+	if (reg == NULL || !reg->active)
+		return false;
+	reg->data = data;
+	reg->interest = events;
+	if (events & EV_READ)
+	{
+		// Une annulation en cours rearme a sa completion finale
+		if (!reg->read_live && (reg->mode != MODE_RECV || reg->status == 0))
+			armRead(fd, *reg);
+	}
+	else if (reg->read_live && !reg->read_cancel)
+	{
+		// Lecture bridee : plus rien ne doit arriver dans les tampons partages
+		cancel(tag(readOperation(*reg), reg->generation, fd), 0, 0);
+		reg->read_cancel = true;
+	}
+	if ((events & EV_WRITE) && !reg->write_live)
+		armWrite(fd, *reg);
+	return true;
+}
+
+void UringLoop::remove(int fd)
+{
+	Registration *reg = lookup(fd);
+	if (reg == NULL || !reg->active)
+		return;
+	// Toutes les requetes du fd, envois compris. Soumis tout de suite :
+	// l'appelant ferme le fd, que le prochain accept peut reutiliser.
+	cancel(0, fd, IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL);
+	release(*reg);
+	submit(0, 0);
+}
+
+int UringLoop::wait(std::vector<Event>& events, int timeout_ms)
+{
+	events.clear();
+	quiesced = false;
+	// Rearmements differes : fin de multishot, ou tampons rendus apres un ENOBUFS
+	arming.swap(rearm);
+	if (buffers_returned)
+	{
+		arming.insert(arming.end(), starved.begin(), starved.end());
+		starved.clear();
+		buffers_returned = false;
+	}
+	for (size_t i = 0; i < arming.size(); ++i)
+	{
+		Registration *reg = lookup(arming[i]);
+		if (reg == NULL || !reg->active)
+			continue;
+		if ((reg->interest & EV_READ) && !reg->read_live
+			&& (reg->mode != MODE_RECV || reg->status == 0))
+			armRead(arming[i], *reg);
+		if ((reg->interest & EV_WRITE) && !reg->write_live)
+			armWrite(arming[i], *reg);
+	}
+	arming.clear();
+
+	// Evenements deja prets (donnees, envois) : on soumet sans bloquer
+	unsigned int wanted = ready_fds.empty() && sent.empty() ? 1 : 0;
+	if (submit(wanted, wanted ? timeout_ms : 0) < 0 && errno != ETIME && errno != EBUSY)
+	{
+		if (errno == EINTR)
+			reap();
+		return -1;
+	}
+	reap();
+
+	events.swap(sent);
+	for (size_t i = 0; i < ready_fds.size(); ++i)
+	{
+		Registration& reg = registrations[ready_fds[i]];
+		reg.queued = false;
+		if (!reg.active || reg.ready == 0)
+			continue;
+		Event ev;
+		ev.data = reg.data;
+		ev.events = reg.ready;
+		ev.result = 0;
+		reg.ready = 0;
+		events.push_back(ev);
+	}
+	ready_fds.clear();
+	return static_cast<int>(events.size());
+}
+
+const char *UringLoop::name() const
+{
+	return "io_uring";
+}
+
+//----------------------E/S-----
+
+int UringLoop::accept(int listen_fd, struct sockaddr_in& address)
+{
+	Registration *reg = lookup(listen_fd);
+	if (reg == NULL || !reg->active || reg->mode != MODE_ACCEPT)
+		return EventLoop::accept(listen_fd, address);
+	if (reg->accepted_head == reg->accepted.size())
+	{
+		reg->accepted.clear();
+		reg->accepted_head = 0;
+		errno = EAGAIN;
+		if (reg->status < 0)
+		{
+			errno = -reg->status;
+			reg->status = 0;
+		}
+		return -1;
+	}
+	int fd = reg->accepted[reg->accepted_head++];
+	// L'accept multishot ne rend pas l'adresse du pair
+	socklen_t length = sizeof(address);
+	if (getpeername(fd, reinterpret_cast<struct sockaddr*>(&address), &length) < 0)
+	{
+		close(fd);
+		errno = ECONNABORTED;
+		return -1;
+	}
+	return fd;
+}
+
+ssize_t UringLoop::receive(int fd, char *buffer, size_t size)
+{
+	Registration *reg = lookup(fd);
+	if (reg == NULL || !reg->active)
+	{
+		errno = EBADF;
+		return -1;
+	}
+	size_t copied = 0;
+	while (copied < size && reg->chunk_head < reg->chunks.size())
+	{
+		Chunk& chunk = reg->chunks[reg->chunk_head];
+		size_t n = std::min(size - copied, static_cast<size_t>(chunk.length - chunk.offset));
+		std::memcpy(buffer + copied,
+			buffers + static_cast<size_t>(chunk.buffer_id) * BUFFER_SIZE + chunk.offset, n);
+		copied += n;
+		chunk.offset += n;
+		if (chunk.offset == chunk.length)
+		{
+			recycle(chunk.buffer_id);
+			++reg->chunk_head;
+		}
+	}
+	if (reg->chunk_head == reg->chunks.size())
+	{
+		reg->chunks.clear();
+		reg->chunk_head = 0;
+	}
+	if (copied > 0 || size == 0)
+		return copied;
+	// Fin de flux ou erreur : rendues apres les donnees, a chaque appel
+	if (reg->status > 0)
+		return 0;
+	errno = reg->status < 0 ? -reg->status : EAGAIN;
+	return -1;
+}
+
+bool UringLoop::completesIo() const
+{
+	return true;
+}
+
+int UringLoop::queueSend(int fd, const struct iovec *iov, size_t count)
+{
+	Registration *reg = lookup(fd);
+	if (reg == NULL || !reg->active || count == 0)
+	{
+		errno = EBADF;
+		return -1;
+	}
+	unsigned int links = (count + IOV_PER_SEND - 1) / IOV_PER_SEND;
+	// Une chaine ne doit pas etre coupee par une soumission intermediaire
+	if (sq_entries - (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)) < links)
+		submit(0, 0);
+	if (sq_entries - (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)) < links)
+	{
+		errno = EAGAIN;
+		return -1;
+	}
+	for (unsigned int i = 0; i < links; ++i)
+	{
+		struct io_uring_sqe *sqe = nextSqe();
+		SendSlot& slot = slots[sqe - sqes];
+		size_t first = i * IOV_PER_SEND;
+		size_t n = std::min(static_cast<size_t>(IOV_PER_SEND), count - first);
+		std::memcpy(slot.iov, iov + first, n * sizeof(struct iovec));
+		std::memset(&slot.message, 0, sizeof(slot.message));
+		slot.message.msg_iov = slot.iov;
+		slot.message.msg_iovlen = n;
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->fd = fd;
+		sqe->addr = reinterpret_cast<uintptr_t>(&slot.message);
+		sqe->len = 1;
+		// Jamais d'attente dans le noyau ; un envoi partiel compte comme un
+		// echec (MSG_WAITALL) et annule la suite, qui serait desordonnee
+		sqe->msg_flags = MSG_DONTWAIT | MSG_WAITALL | MSG_NOSIGNAL;
+		if (i + 1 < links)
+			sqe->flags = IOSQE_IO_LINK;
+		sqe->user_data = tag(OP_SEND, reg->generation, fd);
+		++inflight;
+	}
+	return links;
+}
+
+void UringLoop::quiesce(std::vector<Event>& events)
+{
+	events.clear();
+	quiesced = true;
+	cancel(0, 0, IORING_ASYNC_CANCEL_ANY | IORING_ASYNC_CANCEL_ALL);
+	// Chaque requete rend une completion finale, annulee ou non ; les
+	// donnees deja recues restent lisibles par receive()
+	for (int round = 0; inflight > 0 && round < 50; ++round)
+	{
+		if (submit(1, 100) < 0 && errno != ETIME && errno != EINTR && errno != EBUSY)
+			break;
+		reap();
+	}
+	if (inflight > 0)
+		LOG_WARN << "io_uring: " << inflight << " request(s) still in flight";
+	events.swap(sent);
+}
+
+#endif
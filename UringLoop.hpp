@@ -0,0 +1,176 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   UringLoop.hpp                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef URINGLOOP_HPP
+#define URINGLOOP_HPP
+
+#include "EventLoop.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define HAVE_IO_URING 1
+# endif
+#endif
+
+#ifdef HAVE_IO_URING
+
+#include <stdint.h>
+#include <linux/io_uring.h>
+#include <sys/socket.h> // msghdr
+#include <sys/uio.h> // iovec
+
+// Backend io_uring (Linux >= 6.0), en appels systeme directs :
+//  - socket d'ecoute : un accept multishot, les fd acceptes attendent dans
+//    la file de l'enregistrement jusqu'a accept() ;
+//  - clients : un recv multishot qui puise dans un anneau de tampons fournis
+//    (aucun tampon immobilise par les connexions inactives), receive() copie
+//    ensuite dans le RecvBuffer et rend le tampon a l'anneau ;
+//  - sorties : des sendmsg lies (MSG_WAITALL : un envoi partiel annule la
+//    suite de la chaine), tous soumis avec l'attente du tour suivant ;
+//  - le reste (pipe de reveil, attente d'ecriture) : des poll.
+// Tout ce que ServerSocket voit reste des evenements EV_READ/EV_WRITE, plus
+// EV_SENT pour les envois termines.
+class UringLoop : public EventLoop
+{
+	private:
+		enum
+		{
+			SQ_ENTRIES = 256,
+			CQ_ENTRIES = 4096,
+			BUFFER_COUNT = 1024, // Puissance de deux (anneau de tampons)
+			BUFFER_SIZE = 2048, // Un RecvBuffer
+			IOV_PER_SEND = 64, // Tampons par sendmsg de la chaine
+			BUFFER_GROUP = 0
+		};
+
+		enum Operation // Octet de poids fort de user_data
+		{
+			OP_ACCEPT = 1,
+			OP_RECV,
+			OP_POLL_READ,
+			OP_POLL_WRITE,
+			OP_SEND,
+			OP_CANCEL
+		};
+
+		enum Mode // Nature du fd, determinee a l'enregistrement
+		{
+			MODE_POLL, // Pipe de reveil : simple disponibilite
+			MODE_ACCEPT,
+			MODE_RECV
+		};
+
+		// Donnees recues dans un tampon fourni, pas encore lues
+		struct Chunk
+		{
+			uint16_t	buffer_id;
+			uint16_t	offset;
+			uint16_t	length;
+		};
+
+		struct Registration
+		{
+			void				*data;
+			uint32_t			generation; // Ecarte les completions d'un fd reutilise
+			int					interest;
+			unsigned char		mode;
+			bool				active;
+			bool				read_live; // Recv/accept/poll multishot en cours
+			bool				read_cancel; // Annulation demandee (lecture bridee)
+			bool				write_live; // Poll POLLOUT en cours
+			bool				queued; // Dans la liste des fd a signaler
+			int					ready; // Evenements a signaler au prochain wait()
+			int					status; // Fin de flux (1) ou -errno, apres les donnees
+			std::vector<Chunk>	chunks;
+			size_t				chunk_head;
+			std::vector<int>	accepted;
+			size_t				accepted_head;
+
+			Registration();
+		};
+
+		// Copie stable des tampons d'un sendmsg, jusqu'a sa soumission
+		struct SendSlot
+		{
+			struct msghdr	message;
+			struct iovec	iov[IOV_PER_SEND];
+		};
+
+		int ring_fd;
+		void *ring; // SQ et CQ dans une seule projection (IORING_FEAT_SINGLE_MMAP)
+		size_t ring_size;
+		struct io_uring_sqe *sqes;
+		size_t sqes_size;
+		unsigned int *sq_head;
+		unsigned int *sq_tail;
+		unsigned int *sq_array;
+		unsigned int sq_mask;
+		unsigned int sq_entries;
+		unsigned int sq_local_tail; // Entrees preparees, publiees a la soumission
+		unsigned int *cq_head;
+		unsigned int *cq_tail;
+		unsigned int cq_mask;
+		struct io_uring_cqe *cqes;
+		struct io_uring_buf *buffer_ring;
+		size_t buffer_ring_size;
+		char *buffers;
+		uint16_t buffer_tail;
+		bool buffers_returned; // Des tampons sont revenus depuis le dernier wait()
+		bool quiesced; // Apres quiesce() : rien n'est arme avant le prochain wait()
+		unsigned int inflight; // Requetes dont la completion finale n'est pas arrivee
+		std::vector<SendSlot> slots; // Paralleles aux entrees de la SQ
+		std::vector<Registration> registrations; // Indexe par fd
+		std::vector<int> ready_fds; // fd ayant des evenements a signaler
+		std::vector<int> rearm; // fd a rearmer au prochain wait() (fin de multishot)
+		std::vector<int> starved; // Recv arretes faute de tampon, rearmes a leur retour
+		std::vector<int> arming;
+		std::vector<Event> sent; // Completions d'envoi a rendre
+
+		UringLoop(const UringLoop&);
+		UringLoop& operator=(const UringLoop&);
+
+		bool setupRing();
+		bool setupBuffers();
+		bool probeOperations();
+		struct io_uring_sqe *nextSqe();
+		int submit(unsigned int min_complete, int timeout_ms);
+		void reap();
+		void complete(const struct io_uring_cqe& cqe);
+		void signal(int fd, Registration& reg, int events);
+		void recycle(uint16_t buffer_id);
+		void armRead(int fd, Registration& reg);
+		void armWrite(int fd, Registration& reg);
+		void cancel(uint64_t user_data, int fd, unsigned int flags);
+		void release(Registration& reg);
+		Registration *lookup(int fd);
+		static uint64_t tag(Operation op, uint32_t generation, int fd);
+		static Operation readOperation(const Registration& reg);
+
+	public:
+		UringLoop();
+		virtual ~UringLoop();
+		bool isValid() const;
+		virtual bool add(int fd, void *data, int events);
+		virtual bool modify(int fd, void *data, int events);
+		virtual void remove(int fd);
+		virtual int wait(std::vector<Event>& events, int timeout_ms);
+		virtual const char *name() const;
+		virtual int accept(int listen_fd, struct sockaddr_in& address);
+		virtual ssize_t receive(int fd, char *buffer, size_t size);
+		virtual bool completesIo() const;
+		virtual int queueSend(int fd, const struct iovec *iov, size_t count);
+		virtual void quiesce(std::vector<Event>& events);
+};
+
+#endif
+
+#endif
@@ -19,23 +19,45 @@
 
 int main(int argc, char* argv[])
 {
-	if (argc != 3)
+	if (argc < 3)
 	{
-		std::cerr << "Usage: " << argv[0] << " <port> <password>" << std::endl;
+		Config::printUsage(argv[0]);
 		return 1;
 	}
 
 	int port = std::atoi(argv[1]);
 	std::string password = argv[2];
-
-	ServerSocket server(password);
-	if (!server.setup(port))
+	Config config;
+	for (int i = 3; i < argc; ++i)
+	{
+		if (!config.parse(argv[i]))
+		{
+			Config::printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (!config.link_connect.empty() && config.link_password.empty())
 	{
-		std::cerr << "Failed to setup server" << std::endl;
+		std::cerr << "link_connect requires link_password" << std::endl;
 		return 1;
 	}
-	std::cout << "Server running on port " << port << std::endl;
-	server.run();
+
+	Logger::setLevel(config.log_level);
+	if (!Logger::start())
+		std::cerr << "Failed to start log writer, logging synchronously" << std::endl;
+	{
+		ServerSocket server(password, config);
+		server.setProgram(argv);
+		if (!server.setup(port))
+		{
+			LOG_ERROR << "Failed to setup server";
+			Logger::stop();
+			return 1;
+		}
+		std::cout << "Server running on port " << port << std::endl;
+		server.run();
+	}
+	Logger::stop();
 
 	return 0;
 }
@@ -0,0 +1,40 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   Check.hpp                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+
+// Outillage minimal des tests (make test) : un executable par module, qui
+// compte ses echecs et rend un code de sortie non nul s'il y en a.
+static int check_count = 0;
+static int check_failures = 0;
+
+static inline void checkResult(bool ok, const char *expression, const char *file, int line)
+{
+	++check_count;
+	if (ok)
+		return;
+	++check_failures;
+	std::cerr << file << ":" << line << ": echec : " << expression << std::endl;
+}
+
+#define CHECK(expression) checkResult((expression), #expression, __FILE__, __LINE__)
+
+static inline int checkReport(const char *suite)
+{
+	std::cout << suite << ": " << (check_count - check_failures) << "/" << check_count << " ok" << std::endl;
+	return check_failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_bucket.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "TokenBucket.hpp"
+
+static void testDisabled()
+{
+	TokenBucket bucket;
+	bucket.reset(0, 0);
+	for (int i = 0; i < 100; ++i)
+	{
+		CHECK(bucket.ready(0, 0, 0));
+		bucket.consume(1);
+	}
+	CHECK(bucket.isFull(0, 0, 0));
+	CHECK(bucket.msUntilReady(0) == 0);
+}
+
+// Plein au depart : burst commandes d'affilee, puis plus rien
+static void testBurst()
+{
+	TokenBucket bucket;
+	bucket.reset(1000, 5);
+	CHECK(bucket.isFull(1000, 2, 5));
+	for (int i = 0; i < 5; ++i)
+	{
+		CHECK(bucket.ready(1000, 2, 5));
+		bucket.consume(1);
+	}
+	CHECK(!bucket.ready(1000, 2, 5));
+	CHECK(!bucket.isFull(1000, 2, 5));
+}
+
+// rate jetons par seconde, jamais plus que burst
+static void testRefill()
+{
+	TokenBucket bucket;
+	bucket.reset(0, 4);
+	bucket.consume(4);
+	CHECK(!bucket.ready(0, 2, 4));
+	CHECK(bucket.ready(1, 2, 4)); // 2 milliemes suffisent pour repasser en positif
+	bucket.consume(1); // solde : 2 - 1000
+	CHECK(!bucket.ready(400, 2, 4));
+	CHECK(bucket.ready(600, 2, 4));
+	CHECK(bucket.isFull(100000, 2, 4));
+	for (int i = 0; i < 4; ++i)
+		bucket.consume(1);
+	CHECK(!bucket.ready(100000, 2, 4)); // plafonne a burst malgre la longue attente
+}
+
+// Une commande chere passe, mais retarde d'autant les suivantes
+static void testExpensive()
+{
+	TokenBucket bucket;
+	bucket.reset(0, 3);
+	CHECK(bucket.ready(0, 1, 3));
+	bucket.consume(10);
+	CHECK(!bucket.ready(0, 1, 3));
+	uint64_t wait = bucket.msUntilReady(1);
+	CHECK(wait == 7001);
+	CHECK(!bucket.ready(wait - 1, 1, 3));
+	CHECK(bucket.ready(wait, 1, 3));
+	CHECK(bucket.msUntilReady(1) == 0);
+}
+
+// L'horloge qui recule ne rend ni ne retire de jetons
+static void testClockBackwards()
+{
+	TokenBucket bucket;
+	bucket.reset(5000, 1);
+	bucket.consume(1);
+	CHECK(!bucket.ready(4000, 1, 1));
+	CHECK(!bucket.ready(5000, 1, 1));
+	CHECK(bucket.ready(5001, 1, 1));
+}
+
+int main()
+{
+	testDisabled();
+	testBurst();
+	testRefill();
+	testExpensive();
+	testClockBackwards();
+	return checkReport("bucket");
+}
@@ -0,0 +1,105 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_casemap.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "Casemap.hpp"
+#include "StringMap.hpp"
+#include <map>
+#include <string>
+#include <cstdio>
+#include <stdint.h>
+
+//----------------------CASEMAP-----
+
+static void testFold()
+{
+	CHECK(ircFold("NiCk[]\\^") == "nick{}|~");
+	CHECK(ircFold("#Chan-01_@`") == "#chan-01_@`"); // '_', '@' et '`' ne bougent pas
+	CHECK(ircFold("") == "");
+	CHECK(ircEquals("Foo[Bar]", "fOO{bAR}"));
+	CHECK(ircEquals("a\\b^", "A|B~"));
+	CHECK(!ircEquals("abc", "abd"));
+	CHECK(!ircEquals("abc", "abcd"));
+	CHECK(!ircEquals("a_", "a^")); // '_' n'est pas la forme repliee de '^'
+	std::string folded = ircFold("Caf\xc3\xa9"); // octets hors ASCII inchanges
+	CHECK(folded == "caf\xc3\xa9");
+}
+
+//----------------------STRINGMAP-----
+
+static void testBasic()
+{
+	StringMap<int> map;
+	CHECK(map.size() == 0);
+	CHECK(map.find("alice") == NULL);
+	CHECK(map.insert("alice", 1));
+	CHECK(!map.insert("alice", 2)); // deja la : rien ne change
+	CHECK(map.find("alice") != NULL && *map.find("alice") == 1);
+	CHECK(map.insert("", 3));
+	CHECK(map.find("") != NULL && *map.find("") == 3);
+	CHECK(map.size() == 2);
+	CHECK(map.erase("alice"));
+	CHECK(!map.erase("alice"));
+	CHECK(map.find("alice") == NULL);
+	CHECK(map.insert("alice", 4) && *map.find("alice") == 4);
+	map.clear();
+	CHECK(map.size() == 0 && map.find("") == NULL);
+}
+
+static uint32_t nextRandom(uint32_t& state)
+{
+	state = state * 1103515245u + 12345u;
+	return state >> 8;
+}
+
+// Insertions et suppressions melangees, comparees a std::map : les tombes
+// ne perdent aucune cle et ne font jamais boucler la recherche
+static void testChurn()
+{
+	StringMap<int> map;
+	std::map<std::string, int> reference;
+	uint32_t state = 7;
+	size_t mismatches = 0;
+	for (int step = 0; step < 200000; ++step)
+	{
+		char key[16];
+		std::snprintf(key, sizeof(key), "nick%u", nextRandom(state) % 3000);
+		if (nextRandom(state) % 3 == 0)
+		{
+			if (map.erase(key) != (reference.erase(key) == 1))
+				++mismatches;
+		}
+		else
+		{
+			bool inserted = reference.insert(std::make_pair(std::string(key), step)).second;
+			if (map.insert(key, step) != inserted)
+				++mismatches;
+		}
+	}
+	CHECK(mismatches == 0);
+	CHECK(map.size() == reference.size());
+	for (std::map<std::string, int>::const_iterator it = reference.begin(); it != reference.end(); ++it)
+	{
+		const int *value = map.find(it->first);
+		if (value == NULL || *value != it->second)
+			++mismatches;
+	}
+	CHECK(mismatches == 0);
+}
+
+int main()
+{
+	testFold();
+	testBasic();
+	testChurn();
+	return checkReport("casemap");
+}
@@ -0,0 +1,219 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_framer.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "RecvBuffer.hpp"
+#include "IrcMessage.hpp"
+#include <string>
+#include <cstring>
+
+// Comme recv() : jamais plus que writable()
+static void feed(RecvBuffer& buffer, const std::string& bytes)
+{
+	CHECK(bytes.size() <= buffer.writable());
+	if (bytes.size() > buffer.writable())
+		return;
+	std::memcpy(buffer.writePtr(), bytes.data(), bytes.size());
+	buffer.commit(bytes.size());
+}
+
+static bool nextIs(RecvBuffer& buffer, const std::string& expected)
+{
+	const char *line;
+	size_t len;
+	if (buffer.nextLine(line, len) != RecvBuffer::LINE_OK)
+		return false;
+	return std::string(line, len) == expected;
+}
+
+static RecvBuffer::LineStatus nextStatus(RecvBuffer& buffer)
+{
+	const char *line;
+	size_t len;
+	return buffer.nextLine(line, len);
+}
+
+static bool viewIs(const StringView& view, const char *expected)
+{
+	return view.str() == expected;
+}
+
+//----------------------FRAMING-----
+
+static void testTerminators()
+{
+	RecvBuffer buffer;
+	feed(buffer, "NICK a\r\nUSER a 0 * :A\nPING x\r\n");
+	CHECK(nextIs(buffer, "NICK a"));
+	CHECK(nextIs(buffer, "USER a 0 * :A")); // '\n' seul accepte
+	CHECK(nextIs(buffer, "PING x"));
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	CHECK(buffer.pending() == 0);
+}
+
+static void testPartialLine()
+{
+	RecvBuffer buffer;
+	feed(buffer, "PRIVMSG #c :hel");
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	CHECK(buffer.pending() == 15);
+	feed(buffer, "lo\r");
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	feed(buffer, "\nQUIT");
+	CHECK(nextIs(buffer, "PRIVMSG #c :hello"));
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	CHECK(std::string(buffer.pendingData(), buffer.pending()) == "QUIT");
+}
+
+static void testEmptyLines()
+{
+	RecvBuffer buffer;
+	feed(buffer, "\r\n\nPING x\r\n");
+	CHECK(nextIs(buffer, ""));
+	CHECK(nextIs(buffer, ""));
+	CHECK(nextIs(buffer, "PING x"));
+}
+
+// 512 octets CR LF compris : 510 octets de contenu au plus, quel que soit le terminateur
+static void testLineLimit()
+{
+	std::string longest(RecvBuffer::MAX_LINE - 2, 'a');
+	std::string too_long(RecvBuffer::MAX_LINE - 1, 'b');
+
+	RecvBuffer buffer;
+	feed(buffer, longest + "\r\n" + longest + "\n");
+	CHECK(nextIs(buffer, longest));
+	CHECK(nextIs(buffer, longest));
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	feed(buffer, too_long + "\r\n" + too_long + "\nPING x\n");
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_TOO_LONG);
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_TOO_LONG);
+	CHECK(nextIs(buffer, "PING x")); // la ligne suivante passe
+}
+
+// Sans fin de ligne dans la limite : signale une fois, puis saute jusqu'au '\n'
+static void testDiscardUnterminated()
+{
+	RecvBuffer buffer;
+	feed(buffer, std::string(RecvBuffer::MAX_LINE, 'c'));
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_TOO_LONG);
+	CHECK(buffer.isDiscarding());
+	feed(buffer, std::string(RecvBuffer::MAX_LINE, 'c'));
+	CHECK(nextStatus(buffer) == RecvBuffer::LINE_NONE);
+	feed(buffer, "ccc\r\nPING y\r\n");
+	CHECK(nextIs(buffer, "PING y"));
+	CHECK(!buffer.isDiscarding());
+}
+
+// Le tampon se recompacte : on peut y faire passer bien plus que CAPACITY
+static void testManyLines()
+{
+	RecvBuffer buffer;
+	size_t seen = 0;
+	for (int round = 0; round < 100; ++round)
+	{
+		feed(buffer, "PRIVMSG #channel :0123456789012345678901234567890123456789\r\nPRIV");
+		while (nextIs(buffer, "PRIVMSG #channel :0123456789012345678901234567890123456789"))
+			++seen;
+		feed(buffer, "MSG #channel :0123456789012345678901234567890123456789\r\n");
+		while (nextIs(buffer, "PRIVMSG #channel :0123456789012345678901234567890123456789"))
+			++seen;
+	}
+	CHECK(seen == 200);
+	CHECK(buffer.pending() == 0);
+}
+
+//----------------------PARSING-----
+
+// Lignes litterales : les vues doivent rester valides apres l'appel
+static bool parse(const char *line, IrcMessage& msg)
+{
+	return parseIrcMessage(line, std::strlen(line), msg);
+}
+
+static void testParseBasic()
+{
+	IrcMessage msg;
+	CHECK(parse("NICK alice", msg));
+	CHECK(viewIs(msg.command, "NICK"));
+	CHECK(msg.prefix.size == 0);
+	CHECK(msg.param_count == 1 && viewIs(msg.params[0], "alice"));
+
+	CHECK(parse(":alice!a@host   PRIVMSG   #c   :hi", msg));
+	CHECK(viewIs(msg.prefix, "alice!a@host"));
+	CHECK(viewIs(msg.command, "PRIVMSG"));
+	CHECK(msg.param_count == 2);
+	CHECK(viewIs(msg.params[0], "#c") && viewIs(msg.params[1], "hi"));
+}
+
+// Le parametre final est rendu tel quel : espaces, ':' et espaces finaux compris
+static void testParseTrailing()
+{
+	IrcMessage msg;
+	CHECK(parse("PRIVMSG #c :hello  world : x ", msg));
+	CHECK(msg.param_count == 2);
+	CHECK(viewIs(msg.params[1], "hello  world : x "));
+
+	CHECK(parse("TOPIC #c :", msg));
+	CHECK(msg.param_count == 2 && msg.params[1].size == 0);
+
+	CHECK(parse("USER a 0 * ::colon first", msg));
+	CHECK(msg.param_count == 4 && viewIs(msg.params[3], ":colon first"));
+
+	CHECK(parse("KICK #c bob", msg));
+	CHECK(msg.param_count == 2 && viewIs(msg.params[1], "bob"));
+}
+
+static void testParseMaxParams()
+{
+	IrcMessage msg;
+	CHECK(parse("CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17", msg));
+	CHECK(msg.param_count == IrcMessage::MAX_PARAMS);
+	CHECK(viewIs(msg.params[13], "14"));
+	CHECK(viewIs(msg.params[14], "15 16 17")); // le 15e prend le reste
+}
+
+static void testParseEmpty()
+{
+	IrcMessage msg;
+	CHECK(!parse("", msg));
+	CHECK(!parse("   ", msg));
+	CHECK(!parse(":prefix", msg));
+	CHECK(!parse(":prefix ", msg));
+	CHECK(parse("  PING", msg) && viewIs(msg.command, "PING") && msg.param_count == 0);
+}
+
+// Les vues pointent dans la ligne, sans copie
+static void testParseInPlace()
+{
+	std::string line = "JOIN #a,#b key";
+	IrcMessage msg;
+	CHECK(parseIrcMessage(line.data(), line.size(), msg));
+	CHECK(msg.params[0].data == line.data() + 5);
+	CHECK(msg.params[1].data == line.data() + 11);
+}
+
+int main()
+{
+	testTerminators();
+	testPartialLine();
+	testEmptyLines();
+	testLineLimit();
+	testDiscardUnterminated();
+	testManyLines();
+	testParseBasic();
+	testParseTrailing();
+	testParseMaxParams();
+	testParseEmpty();
+	testParseInPlace();
+	return checkReport("framer");
+}
@@ -0,0 +1,277 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_history.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "ChannelHistory.hpp"
+#include "Client.hpp"
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+static const uint64_t time_base = 1792213200000ULL; // 2026-10-17T05:00:00.000Z
+
+static std::string makeLine(uint64_t id)
+{
+	char text[64];
+	std::snprintf(text, sizeof(text), ":a!a@h PRIVMSG #c :message %llu\r\n", static_cast<unsigned long long>(id));
+	return text;
+}
+
+static void appendLine(HistoryArena& arena, ChannelHistory& history, size_t capacity, uint64_t time_ms)
+{
+	MessageTags tags(arena.nextId(), time_ms);
+	std::string line = makeLine(tags.id);
+	history.append(arena, capacity, tags, line.data(), line.size());
+}
+
+// Ligne stockee, a partir d'un decalage dans ses etiquettes
+static std::string stored(const HistoryArena& arena, const ChannelHistory::Entry& entry, size_t skip)
+{
+	return std::string(arena.at(entry.pos) + skip, entry.length - skip);
+}
+
+//----------------------ARENA-----
+
+// L'arene ne depasse jamais sa taille : les lignes ecrasees disparaissent
+// de tous les canaux, les plus anciennes d'abord, et les survivantes sont
+// intactes et jamais coupees en fin d'anneau
+static void testArenaLimit()
+{
+	enum { ARENA = 1000 };
+	HistoryArena arena;
+	arena.init(ARENA);
+	CHECK(arena.isEnabled());
+	ChannelHistory first, second;
+	for (int i = 0; i < 60; ++i)
+		appendLine(arena, i % 3 == 0 ? second : first, 100, time_base + i);
+
+	first.prune(arena);
+	second.prune(arena);
+	size_t live = 0;
+	uint64_t oldest = ~static_cast<uint64_t>(0);
+	ChannelHistory *histories[2] = { &first, &second };
+	for (int h = 0; h < 2; ++h)
+	{
+		const ChannelHistory& history = *histories[h];
+		CHECK(history.size() > 0);
+		for (size_t i = 0; i < history.size(); ++i)
+		{
+			const ChannelHistory::Entry& entry = history.at(i);
+			CHECK(arena.isLive(entry.pos));
+			CHECK(entry.pos % ARENA + entry.length <= ARENA);
+			CHECK(stored(arena, entry, entry.tags_length) == makeLine(entry.id));
+			if (i > 0)
+				CHECK(entry.id > history.at(i - 1).id);
+			if (entry.id < oldest)
+				oldest = entry.id;
+			live += entry.length;
+		}
+	}
+	CHECK(live <= ARENA);
+	// Tout ce qui est plus recent que la plus ancienne survivante est encore la
+	CHECK(first.size() + second.size() == 60 - oldest + 1);
+	CHECK(!arena.isLive(0));
+}
+
+// Une arene vide (history_memory=0) est desactivee
+static void testArenaDisabled()
+{
+	HistoryArena arena;
+	CHECK(!arena.isEnabled());
+	CHECK(!arena.isLive(0));
+	CHECK(arena.nextId() == 1 && arena.nextId() == 2);
+}
+
+//----------------------CHANNEL-----
+
+// Capacite par canal (history_lines) : seules les plus recentes restent
+static void testChannelCapacity()
+{
+	HistoryArena arena;
+	arena.init(1 << 16);
+	ChannelHistory history;
+	for (int i = 0; i < 10; ++i)
+		appendLine(arena, history, 4, time_base + i);
+	CHECK(history.size() == 4);
+	CHECK(history.at(0).id == 7 && history.at(3).id == 10);
+	// Changer la capacite repart de zero
+	appendLine(arena, history, 8, time_base + 10);
+	CHECK(history.size() == 1 && history.at(0).id == 11);
+}
+
+// L'horloge peut reculer, les horodatages stockes jamais
+static void testMonotonicTime()
+{
+	HistoryArena arena;
+	arena.init(1 << 16);
+	ChannelHistory history;
+	appendLine(arena, history, 8, time_base + 5000);
+	appendLine(arena, history, 8, time_base + 1000);
+	appendLine(arena, history, 8, time_base + 6000);
+	CHECK(history.at(0).time_ms == time_base + 5000);
+	CHECK(history.at(1).time_ms == time_base + 5000);
+	CHECK(history.at(2).time_ms == time_base + 6000);
+}
+
+// Relecture selon les capacites : toutes les etiquettes, server-time seul, rien
+static void testStoredTags()
+{
+	HistoryArena arena;
+	arena.init(1 << 16);
+	ChannelHistory history;
+	appendLine(arena, history, 8, time_base + 42);
+	const ChannelHistory::Entry& entry = history.at(0);
+	std::string line = makeLine(1);
+	CHECK(stored(arena, entry, 0) == "@msgid=1;time=2026-10-17T05:00:00.042Z " + line);
+	CHECK(stored(arena, entry, 1) == "msgid=1;time=2026-10-17T05:00:00.042Z " + line);
+	CHECK(stored(arena, entry, entry.time_offset) == "time=2026-10-17T05:00:00.042Z " + line);
+	CHECK(stored(arena, entry, entry.tags_length) == line);
+}
+
+//----------------------CHATHISTORY-----
+
+static HistoryRef ref(const char *text)
+{
+	HistoryRef parsed;
+	parsed.parse(text);
+	return parsed;
+}
+
+static void testRefParse()
+{
+	HistoryRef parsed;
+	CHECK(parsed.parse("*") && parsed.type == HistoryRef::NONE);
+	CHECK(parsed.parse("msgid=42") && parsed.type == HistoryRef::MSGID && parsed.value == 42);
+	CHECK(parsed.parse("timestamp=2026-10-17T05:00:00.042Z") && parsed.type == HistoryRef::TIME);
+	CHECK(parsed.value == time_base + 42);
+	CHECK(parsed.parse("timestamp=2026-10-17T05:00:01Z") && parsed.value == time_base + 1000);
+	const char *invalid[] = { "", "msgid=", "msgid=4x", "msgid=-1", "timestamp=2026-10-17", "timestamp=2026-10-17T05:00:00",
+		"timestamp=2026-10-17T05:00:00.042", "timestamp=2026-10-17T05:00:00Zjunk", "42" };
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+		CHECK(!parsed.parse(invalid[i]));
+}
+
+// Plage [first, last) traduite en msgid de la premiere et de la derniere
+static bool rangeIs(const ChannelHistory& history, size_t first, size_t last, uint64_t first_id, uint64_t last_id)
+{
+	if (first >= last)
+		return first_id == 0;
+	return history.at(first).id == first_id && history.at(last - 1).id == last_id;
+}
+
+// msgid 1 a 10, une seconde d'ecart
+static void testQueries()
+{
+	HistoryArena arena;
+	arena.init(1 << 16);
+	ChannelHistory history;
+	for (int i = 0; i < 10; ++i)
+		appendLine(arena, history, 16, time_base + i * 1000);
+	size_t first, last;
+
+	history.latest(ref("*"), 3, first, last);
+	CHECK(rangeIs(history, first, last, 8, 10));
+	history.latest(ref("msgid=9"), 5, first, last);
+	CHECK(rangeIs(history, first, last, 10, 10));
+	history.latest(ref("msgid=10"), 5, first, last);
+	CHECK(first == last);
+
+	history.before(ref("msgid=5"), 2, first, last);
+	CHECK(rangeIs(history, first, last, 3, 4));
+	history.before(ref("msgid=2"), 5, first, last);
+	CHECK(rangeIs(history, first, last, 1, 1));
+
+	history.after(ref("msgid=5"), 3, first, last);
+	CHECK(rangeIs(history, first, last, 6, 8));
+	history.after(ref("timestamp=2026-10-17T05:00:07.500Z"), 10, first, last);
+	CHECK(rangeIs(history, first, last, 9, 10));
+
+	history.around(ref("msgid=5"), 4, first, last);
+	CHECK(rangeIs(history, first, last, 3, 6));
+	history.around(ref("msgid=10"), 4, first, last);
+	CHECK(rangeIs(history, first, last, 7, 10));
+
+	// Bornes exclues ; a l'envers, les plus recentes sont gardees
+	history.between(ref("msgid=2"), ref("msgid=6"), 10, first, last);
+	CHECK(rangeIs(history, first, last, 3, 5));
+	history.between(ref("msgid=6"), ref("msgid=2"), 2, first, last);
+	CHECK(rangeIs(history, first, last, 4, 5));
+}
+
+// Un msgid plus ancien que le dernier (pris hors history_lock) est ramene
+// au dernier : l'ordre, et donc les recherches, tiennent
+static void testOutOfOrderIds()
+{
+	HistoryArena arena;
+	arena.init(1 << 16);
+	ChannelHistory history;
+	uint64_t ids[] = { 1, 2, 5, 4, 3, 6 };
+	for (size_t i = 0; i < sizeof(ids) / sizeof(*ids); ++i)
+	{
+		MessageTags tags(ids[i], time_base + i);
+		std::string line = makeLine(ids[i]);
+		history.append(arena, 16, tags, line.data(), line.size());
+	}
+	CHECK(history.size() == 6);
+	for (size_t i = 1; i < history.size(); ++i)
+		CHECK(history.at(i).id >= history.at(i - 1).id);
+	CHECK(history.at(3).id == 5 && history.at(4).id == 5);
+	// La ligne reste intacte, seul son rang change
+	CHECK(stored(arena, history.at(3), history.at(3).tags_length) == makeLine(4));
+
+	size_t first, last;
+	history.after(ref("msgid=2"), 10, first, last);
+	CHECK(first == 2 && last == 6);
+	history.before(ref("msgid=5"), 10, first, last);
+	CHECK(first == 0 && last == 2);
+	history.after(ref("msgid=5"), 10, first, last);
+	CHECK(first == 5 && last == 6 && history.at(first).id == 6);
+}
+
+//----------------------TAGGED-LINE-----
+
+// Une forme par jeu de capacites, construite une fois puis partagee
+static void testTaggedLine()
+{
+	MessageTags tags(7, time_base + 5);
+	std::string line = makeLine(7);
+	TaggedLine tagged(tags, SharedBuffer(line));
+	struct in_addr address;
+	address.s_addr = 0;
+	Client plain(-1, address), timed(-1, address), full(-1, address), full_too(-1, address);
+	timed.setCaps(Client::CAP_SERVER_TIME);
+	full.setCaps(Client::CAP_MESSAGE_TAGS | Client::CAP_SERVER_TIME);
+	full_too.setCaps(Client::CAP_MESSAGE_TAGS);
+
+	const SharedBuffer& for_plain = tagged.forClient(&plain);
+	CHECK(std::string(for_plain.data(), for_plain.size()) == line);
+	const SharedBuffer& for_timed = tagged.forClient(&timed);
+	CHECK(std::string(for_timed.data(), for_timed.size()) == "@time=2026-10-17T05:00:00.005Z " + line);
+	const SharedBuffer& for_full = tagged.forClient(&full);
+	CHECK(std::string(for_full.data(), for_full.size()) == "@msgid=7;time=2026-10-17T05:00:00.005Z " + line);
+	CHECK(tagged.forClient(&full_too).data() == for_full.data());
+	CHECK(tagged.getLine().data() == for_plain.data());
+}
+
+int main()
+{
+	testArenaLimit();
+	testArenaDisabled();
+	testChannelCapacity();
+	testMonotonicTime();
+	testStoredTags();
+	testRefParse();
+	testQueries();
+	testOutOfOrderIds();
+	testTaggedLine();
+	return checkReport("history");
+}
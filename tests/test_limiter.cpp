@@ -0,0 +1,206 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_limiter.cpp                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "ConnectionLimiter.hpp"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <arpa/inet.h>
+
+static struct in_addr ipv4(const char *text)
+{
+	struct in_addr address;
+	inet_pton(AF_INET, text, &address);
+	return address;
+}
+
+static uint32_t hostOrder(const char *text)
+{
+	return ntohl(ipv4(text).s_addr);
+}
+
+//----------------------CIDR-----
+
+static void testCidrParse()
+{
+	Cidr cidr;
+	CHECK(Cidr::parse("10.0.0.0/8", cidr));
+	CHECK(cidr.network == hostOrder("10.0.0.0") && cidr.mask == 0xff000000u);
+	CHECK(cidr.contains(hostOrder("10.255.1.2")));
+	CHECK(!cidr.contains(hostOrder("11.0.0.1")));
+
+	// Les bits d'hote sont ignores
+	CHECK(Cidr::parse("192.168.77.9/20", cidr));
+	CHECK(cidr.network == hostOrder("192.168.64.0"));
+	CHECK(cidr.contains(hostOrder("192.168.79.255")));
+	CHECK(!cidr.contains(hostOrder("192.168.80.0")));
+
+	// Sans longueur : une seule adresse
+	CHECK(Cidr::parse("1.2.3.4", cidr));
+	CHECK(cidr.mask == 0xffffffffu);
+	CHECK(cidr.contains(hostOrder("1.2.3.4")) && !cidr.contains(hostOrder("1.2.3.5")));
+
+	CHECK(Cidr::parse("0.0.0.0/0", cidr));
+	CHECK(cidr.mask == 0 && cidr.contains(hostOrder("203.0.113.7")));
+	CHECK(Cidr::parse("8.8.8.8/32", cidr) && cidr.contains(hostOrder("8.8.8.8")));
+}
+
+static void testCidrReject()
+{
+	const char *invalid[] = { "", "/8", "10.0.0.0/", "10.0.0.0/33", "10.0.0.0/-1", "10.0.0.0/+8",
+		"10.0.0.0/8 ", " 10.0.0.0/8", "10.0.0/8", "10.0.0.256/8", "host.example/8", "10.0.0.0/8/8", "::1/128" };
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(*invalid); ++i)
+	{
+		Cidr cidr;
+		bool parsed = Cidr::parse(invalid[i], cidr);
+		if (parsed)
+			std::fprintf(stderr, "accepte a tort : \"%s\"\n", invalid[i]);
+		CHECK(!parsed);
+	}
+}
+
+static void testCidrList()
+{
+	std::vector<Cidr> list;
+	CHECK(Cidr::parseList("127.0.0.0/8,192.168.0.0/16,10.1.2.3", list));
+	CHECK(list.size() == 3);
+	CHECK(list[1].network == hostOrder("192.168.0.0") && list[2].mask == 0xffffffffu);
+	CHECK(Cidr::parseList("none", list));
+	CHECK(list.empty());
+	CHECK(!Cidr::parseList("", list));
+	CHECK(!Cidr::parseList("10.0.0.0/8,", list));
+	CHECK(!Cidr::parseList(",10.0.0.0/8", list));
+	CHECK(!Cidr::parseList("10.0.0.0/8,,11.0.0.0/8", list));
+	CHECK(!Cidr::parseList("10.0.0.0/8,bad", list));
+}
+
+//----------------------LIMITER-----
+
+static std::vector<Cidr> noExempt()
+{
+	return std::vector<Cidr>();
+}
+
+static void testDisabled()
+{
+	ConnectionLimiter limiter;
+	limiter.configure(0, 0, 0, 24, noExempt());
+	for (int i = 0; i < 100; ++i)
+		CHECK(limiter.admit(ipv4("10.0.0.1"), 0) == ConnectionLimiter::ACCEPT);
+}
+
+// Les connexions sont comptees par prefixe, pas par adresse
+static void testPerPrefix()
+{
+	ConnectionLimiter limiter;
+	limiter.configure(2, 0, 0, 24, noExempt());
+	CHECK(limiter.admit(ipv4("10.0.0.1"), 0) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(ipv4("10.0.0.2"), 0) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(ipv4("10.0.0.3"), 0) == ConnectionLimiter::TOO_MANY);
+	CHECK(limiter.admit(ipv4("10.0.1.1"), 0) == ConnectionLimiter::ACCEPT);
+	limiter.release(ipv4("10.0.0.2"));
+	CHECK(limiter.admit(ipv4("10.0.0.3"), 0) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(ipv4("10.0.0.4"), 0) == ConnectionLimiter::TOO_MANY);
+}
+
+static void testExempt()
+{
+	std::vector<Cidr> exempt;
+	CHECK(Cidr::parseList("127.0.0.0/8,192.168.1.0/24", exempt));
+	ConnectionLimiter limiter;
+	limiter.configure(1, 0, 0, 32, exempt);
+	for (int i = 0; i < 10; ++i)
+	{
+		CHECK(limiter.admit(ipv4("127.0.0.1"), 0) == ConnectionLimiter::ACCEPT);
+		CHECK(limiter.admit(ipv4("192.168.1.20"), 0) == ConnectionLimiter::ACCEPT);
+	}
+	CHECK(limiter.admit(ipv4("192.168.2.20"), 0) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(ipv4("192.168.2.20"), 0) == ConnectionLimiter::TOO_MANY);
+}
+
+// Chaque tentative coute un jeton, meme refusee
+static void testRate()
+{
+	ConnectionLimiter limiter;
+	limiter.configure(0, 1, 2, 32, noExempt());
+	struct in_addr source = ipv4("198.51.100.7");
+	CHECK(limiter.admit(source, 1000) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(source, 1000) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(source, 1000) == ConnectionLimiter::TOO_FAST);
+	CHECK(limiter.admit(source, 2000) == ConnectionLimiter::TOO_FAST); // encore a sec
+	CHECK(limiter.admit(source, 4000) == ConnectionLimiter::ACCEPT);
+	CHECK(limiter.admit(ipv4("198.51.100.8"), 4000) == ConnectionLimiter::ACCEPT);
+}
+
+// Une connexion reprise d'un relais est comptee, sans controle
+static void testRestore()
+{
+	ConnectionLimiter limiter;
+	limiter.configure(2, 0, 0, 32, noExempt());
+	struct in_addr source = ipv4("203.0.113.5");
+	limiter.restore(source, 0);
+	limiter.restore(source, 0);
+	limiter.restore(source, 0);
+	CHECK(limiter.admit(source, 0) == ConnectionLimiter::TOO_MANY);
+	limiter.release(source);
+	limiter.release(source);
+	CHECK(limiter.admit(source, 0) == ConnectionLimiter::ACCEPT);
+}
+
+// Des milliers de prefixes : agrandissements et nettoyages ne perdent aucune
+// entree qui compte encore des connexions
+static void testGrowth()
+{
+	enum { PREFIXES = 3000 };
+	ConnectionLimiter limiter;
+	limiter.configure(1, 0, 0, 24, noExempt());
+	char text[32];
+	for (int i = 0; i < PREFIXES; ++i)
+	{
+		std::snprintf(text, sizeof(text), "10.%d.%d.1", i / 256, i % 256);
+		CHECK(limiter.admit(ipv4(text), i) == ConnectionLimiter::ACCEPT);
+	}
+	size_t refused = 0;
+	for (int i = 0; i < PREFIXES; ++i)
+	{
+		std::snprintf(text, sizeof(text), "10.%d.%d.2", i / 256, i % 256);
+		if (limiter.admit(ipv4(text), PREFIXES) == ConnectionLimiter::TOO_MANY)
+			++refused;
+	}
+	CHECK(refused == PREFIXES);
+	for (int i = 0; i < PREFIXES; ++i)
+	{
+		std::snprintf(text, sizeof(text), "10.%d.%d.1", i / 256, i % 256);
+		limiter.release(ipv4(text));
+	}
+	for (int i = 0; i < PREFIXES; ++i)
+	{
+		std::snprintf(text, sizeof(text), "11.%d.%d.1", i / 256, i % 256);
+		CHECK(limiter.admit(ipv4(text), PREFIXES + i) == ConnectionLimiter::ACCEPT);
+	}
+	CHECK(limiter.admit(ipv4("10.0.5.9"), 2 * PREFIXES) == ConnectionLimiter::ACCEPT);
+}
+
+int main()
+{
+	testCidrParse();
+	testCidrReject();
+	testCidrList();
+	testDisabled();
+	testPerPrefix();
+	testExempt();
+	testRate();
+	testRestore();
+	testGrowth();
+	return checkReport("limiter");
+}
@@ -0,0 +1,374 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_server.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "ServerSocket.hpp"
+#include "Casemap.hpp"
+#include "Logger.hpp"
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cstring>
+
+// Boucle qui refuse toute inscription et delegue le reste : chemin d'echec
+// de loop->add, introuvable autrement avec un vrai socket
+class RefusingLoop : public EventLoop
+{
+	private:
+		EventLoop *inner;
+
+	public:
+		explicit RefusingLoop(EventLoop *inner) : inner(inner) {}
+		bool add(int, void*, int) { return false; }
+		bool modify(int fd, void *data, int events) { return inner->modify(fd, data, events); }
+		void remove(int fd) { inner->remove(fd); }
+		int wait(std::vector<Event>& events, int timeout_ms) { return inner->wait(events, timeout_ms); }
+		const char *name() const { return "refusing"; }
+		int accept(int listen_fd, struct sockaddr_in& address) { return inner->accept(listen_fd, address); }
+};
+
+// Acces a l'etat prive du serveur : relais SIGUSR2 rejoue en memoire, sans
+// exec ni Handoff, entre deux ServerSocket successifs, et historique ecrit
+// par plusieurs threads comme sous le verrou partage
+class ServerSocketTest
+{
+	public:
+		static Config makeConfig()
+		{
+			Config config;
+			config.threads = 1;
+			config.backend = "epoll";
+			config.stats = "off";
+			config.channel_store = "off";
+			return config;
+		}
+
+		static Client *addClient(ServerSocket& server, int fd, const char *nickname)
+		{
+			Reactor& reactor = *server.reactors[0];
+			struct in_addr address;
+			address.s_addr = htonl(0x7f000001);
+			Client *client = reactor.createClient(fd, address);
+			reactor.getLoop()->add(fd, client, EventLoop::EV_READ);
+			server.setClientNickname(client, nickname);
+			client->setUsername(nickname);
+			client->setRegistered(true);
+			server.clients.insert(client);
+			return client;
+		}
+
+		static Channel *addChannel(ServerSocket& server, const char *name)
+		{
+			return server.channels.create(name);
+		}
+
+		static void join(Channel *channel, Client *client, bool op)
+		{
+			channel->addMember(client, op);
+			client->joinChannel(channel->getId());
+		}
+
+		static std::string serialize(ServerSocket& server, std::vector<int>& fds)
+		{
+			return server.serializeState(fds);
+		}
+
+		// Comme setup() : format et sockets d'ecoute lus avant restoreState()
+		static bool restore(ServerSocket& server, const std::string& state, const std::vector<int>& fds)
+		{
+			StateReader reader(state);
+			if (reader.getString() != "IRCSERV-STATE-4")
+				return false;
+			reader.getU32();
+			return server.restoreState(reader, fds, ServerSocket::STATE_VERSION);
+		}
+
+		static Channel *findChannel(ServerSocket& server, const char *name)
+		{
+			return server.channels.find(name);
+		}
+
+		static size_t clientCount(ServerSocket& server)
+		{
+			return server.clients.size();
+		}
+
+		static size_t timerCount(ServerSocket& server)
+		{
+			return server.reactors[0]->getTimers().size();
+		}
+
+		// Le reacteur detruit sa boucle : rendre la vraie avant la fin du test
+		static EventLoop *swapLoop(ServerSocket& server, EventLoop *loop)
+		{
+			EventLoop *previous = server.reactors[0]->loop;
+			server.reactors[0]->loop = loop;
+			return previous;
+		}
+
+		static Reactor& reactor(ServerSocket& server)
+		{
+			return *server.reactors[0];
+		}
+
+		static bool acceptConnection(ServerSocket& server)
+		{
+			return server.acceptConnection(*server.reactors[0]);
+		}
+
+		static void connectLinks(ServerSocket& server)
+		{
+			server.connectLinks(*server.reactors[0]);
+		}
+
+		static int linkFd(ServerSocket& server, size_t i)
+		{
+			return server.outgoing[i].handle.fd;
+		}
+
+		static MessageTags recordHistory(ServerSocket& server, Channel *channel, const SharedBuffer& line)
+		{
+			return server.recordHistory(channel, line);
+		}
+};
+
+static bool hasPending(Channel *channel, const char *folded_nick)
+{
+	const std::vector<std::string>& pending = channel->getPendingOperators();
+	return std::find(pending.begin(), pending.end(), folded_nick) != pending.end();
+}
+
+// Etat transmis par un premier serveur : alice operatrice de #p avec un
+// sujet et bob attendu comme operateur ; #q ne tient plus qu'a carol, son
+// operatrice relue du disque
+static std::string makeState(std::vector<int>& client_fds)
+{
+	ServerSocket server("pw", ServerSocketTest::makeConfig());
+	CHECK(server.setup(0));
+	int pair[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+	client_fds.push_back(pair[1]);
+	Client *alice = ServerSocketTest::addClient(server, pair[0], "Alice");
+	Channel *p = ServerSocketTest::addChannel(server, "#p");
+	ServerSocketTest::join(p, alice, true);
+	p->setTopic("kept across upgrades", "Alice", 1700000000);
+	p->addPendingOperator(ircFold("Bob[1]"));
+	Channel *q = ServerSocketTest::addChannel(server, "#Q");
+	q->addPendingOperator("carol");
+
+	std::vector<int> fds;
+	std::string state = ServerSocketTest::serialize(server, fds);
+	CHECK(fds.size() == 2 && fds[1] == pair[0]);
+	// Le nouveau processus recoit ses propres descripteurs
+	client_fds.insert(client_fds.begin(), dup(pair[0]));
+	return state;
+}
+
+static void testRoundTrip(const std::string& state, const std::vector<int>& client_fds)
+{
+	ServerSocket server("pw", ServerSocketTest::makeConfig());
+	CHECK(server.setup(0));
+	std::vector<int> fds;
+	fds.push_back(-1); // socket d'ecoute, non reprise ici
+	fds.push_back(client_fds[0]);
+	CHECK(ServerSocketTest::restore(server, state, fds));
+
+	Client *alice = server.findClientByNickname("alice");
+	CHECK(alice != NULL && alice->isFullyRegistered());
+	CHECK(ServerSocketTest::clientCount(server) == 1);
+	CHECK(ServerSocketTest::timerCount(server) == 1);
+
+	Channel *p = ServerSocketTest::findChannel(server, "#p");
+	CHECK(p != NULL);
+	if (p != NULL)
+	{
+		CHECK(p->memberCount() == 1 && alice != NULL && p->isOperator(alice));
+		CHECK(p->getTopic() == "kept across upgrades");
+		CHECK(hasPending(p, "bob{1}"));
+	}
+	// Sans membre ni mode ni sujet, #q ne survit que par son operatrice en attente
+	Channel *q = ServerSocketTest::findChannel(server, "#q");
+	CHECK(q != NULL && q->getName() == "#Q" && hasPending(q, "carol"));
+}
+
+// Un descripteur que la boucle refuse : aucune trace du client, ni dans
+// nick_index ni dans la roue, et les canaux sont repris sans lui
+static void testRestoreFailure(const std::string& state)
+{
+	ServerSocket server("pw", ServerSocketTest::makeConfig());
+	CHECK(server.setup(0));
+	int closed = dup(0);
+	close(closed);
+	std::vector<int> fds;
+	fds.push_back(-1);
+	fds.push_back(closed);
+	CHECK(ServerSocketTest::restore(server, state, fds));
+	CHECK(server.findClientByNickname("alice") == NULL);
+	CHECK(ServerSocketTest::clientCount(server) == 0);
+	CHECK(ServerSocketTest::timerCount(server) == 0);
+	Channel *p = ServerSocketTest::findChannel(server, "#p");
+	CHECK(p != NULL && p->memberCount() == 0 && hasPending(p, "bob{1}"));
+	CHECK(ServerSocketTest::findChannel(server, "#q") != NULL);
+}
+
+//----------------------REGISTRATION-----
+
+static int listenerPort(int fd)
+{
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+	getsockname(fd, (struct sockaddr*)&address, &length);
+	return ntohs(address.sin_port);
+}
+
+// Connexion acceptee mais refusee par la boucle : ni client ni minuterie
+// ne restent, le pair voit la fermeture
+static void testAcceptFailure()
+{
+	ServerSocket server("pw", ServerSocketTest::makeConfig());
+	CHECK(server.setup(0));
+	Reactor& reactor = ServerSocketTest::reactor(server);
+	struct sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(listenerPort(reactor.getListener()));
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int peer = socket(AF_INET, SOCK_STREAM, 0);
+	CHECK(connect(peer, (struct sockaddr*)&address, sizeof(address)) == 0);
+
+	RefusingLoop refusing(reactor.getLoop());
+	EventLoop *loop = ServerSocketTest::swapLoop(server, &refusing);
+	CHECK(ServerSocketTest::acceptConnection(server));
+	ServerSocketTest::swapLoop(server, loop);
+	CHECK(ServerSocketTest::clientCount(server) == 0);
+	CHECK(ServerSocketTest::timerCount(server) == 0);
+	char byte;
+	CHECK(recv(peer, &byte, 1, 0) == 0);
+	close(peer);
+}
+
+// Meme echec sur une liaison sortante : rien dans la roue, pas de poignee
+static void testLinkFailure()
+{
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in address;
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	bind(listener, (struct sockaddr*)&address, sizeof(address));
+	listen(listener, 1);
+
+	Config config = ServerSocketTest::makeConfig();
+	LinkPeer peer;
+	peer.address.s_addr = htonl(INADDR_LOOPBACK);
+	peer.port = listenerPort(listener);
+	config.link_connect.push_back(peer);
+	ServerSocket server("pw", config);
+	CHECK(server.setup(0));
+	Reactor& reactor = ServerSocketTest::reactor(server);
+	RefusingLoop refusing(reactor.getLoop());
+	EventLoop *loop = ServerSocketTest::swapLoop(server, &refusing);
+	ServerSocketTest::connectLinks(server);
+	ServerSocketTest::swapLoop(server, loop);
+	CHECK(ServerSocketTest::clientCount(server) == 0);
+	CHECK(ServerSocketTest::timerCount(server) == 0);
+	CHECK(ServerSocketTest::linkFd(server, 0) == -1);
+	close(listener);
+}
+
+//----------------------HISTORY-----
+
+enum { WRITERS = 4, LINES_PER_WRITER = 2000 };
+
+struct HistoryWriter
+{
+	ServerSocket *server;
+	Channel *channel;
+	std::vector<uint64_t> ids; // msgid rendus, comme envoyes en direct
+};
+
+static void *writeHistory(void *arg)
+{
+	HistoryWriter *writer = static_cast<HistoryWriter*>(arg);
+	SharedBuffer line(std::string(":a!a@h PRIVMSG #h :line\r\n"));
+	for (int i = 0; i < LINES_PER_WRITER; ++i)
+	{
+		writer->ids.push_back(ServerSocketTest::recordHistory(*writer->server, writer->channel, line).id);
+		if (i % 64 == 0)
+			sched_yield();
+	}
+	return NULL;
+}
+
+// Plusieurs reacteurs ecrivent dans un meme canal : l'historique reste trie
+// par msgid, et chaque msgid envoye en direct y est retrouve
+static void testConcurrentHistory()
+{
+	Config config = ServerSocketTest::makeConfig();
+	config.history_lines = WRITERS * LINES_PER_WRITER;
+	config.history_memory = 16 * 1024 * 1024;
+	ServerSocket server("pw", config);
+	CHECK(server.setup(0));
+	Channel *channel = ServerSocketTest::addChannel(server, "#h");
+
+	HistoryWriter writers[WRITERS];
+	pthread_t threads[WRITERS];
+	for (int i = 0; i < WRITERS; ++i)
+	{
+		writers[i].server = &server;
+		writers[i].channel = channel;
+		pthread_create(&threads[i], NULL, writeHistory, &writers[i]);
+	}
+	for (int i = 0; i < WRITERS; ++i)
+		pthread_join(threads[i], NULL);
+
+	const ChannelHistory& history = channel->getHistory();
+	CHECK(history.size() == WRITERS * LINES_PER_WRITER);
+	size_t unordered = 0;
+	for (size_t i = 1; i < history.size(); ++i)
+		if (history.at(i).id <= history.at(i - 1).id)
+			++unordered;
+	CHECK(unordered == 0);
+	size_t missing = 0;
+	for (int i = 0; i < WRITERS; ++i)
+	{
+		for (size_t j = 0; j < writers[i].ids.size(); ++j)
+		{
+			HistoryRef ref;
+			ref.type = HistoryRef::MSGID;
+			ref.value = writers[i].ids[j];
+			size_t first, last;
+			history.around(ref, 1, first, last);
+			if (first == last || history.at(first).id != ref.value)
+				++missing;
+		}
+	}
+	CHECK(missing == 0);
+}
+
+int main()
+{
+	Logger::setLevel(Logger::LEVEL_ERROR);
+	std::vector<int> client_fds;
+	std::string state = makeState(client_fds);
+	testRoundTrip(state, client_fds);
+	testRestoreFailure(state);
+	testAcceptFailure();
+	testLinkFailure();
+	testConcurrentHistory();
+	for (size_t i = 1; i < client_fds.size(); ++i)
+		close(client_fds[i]);
+	return checkReport("server");
+}
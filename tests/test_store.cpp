@@ -0,0 +1,323 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_store.cpp                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "ChannelStore.hpp"
+#include "Logger.hpp"
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <csignal>
+
+static std::string directory;
+
+static std::string storePath(const char *name)
+{
+	return directory + "/" + name;
+}
+
+static off_t fileSize(const std::string& path)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return -1;
+	return info.st_size;
+}
+
+static ChannelRecord makeRecord(const std::string& name, const std::string& topic)
+{
+	ChannelRecord record;
+	record.name = name;
+	record.modes = 5;
+	record.key = "secret";
+	record.limit = 12;
+	record.has_topic = true;
+	record.topic = topic;
+	record.topic_set_by = "alice";
+	record.topic_time = 1700000000;
+	record.invitations.push_back("bob");
+	record.operators.push_back("alice");
+	record.operators.push_back("carol");
+	return record;
+}
+
+static const ChannelRecord *findRecord(const std::vector<ChannelRecord>& records, const std::string& name)
+{
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		if (records[i].name == name)
+			return &records[i];
+	}
+	return NULL;
+}
+
+static bool sameRecord(const ChannelRecord *found, const ChannelRecord& expected)
+{
+	return found != NULL && found->name == expected.name && found->modes == expected.modes
+		&& found->key == expected.key && found->limit == expected.limit
+		&& found->has_topic == expected.has_topic && found->topic == expected.topic
+		&& found->topic_set_by == expected.topic_set_by && found->topic_time == expected.topic_time
+		&& found->invitations == expected.invitations && found->operators == expected.operators;
+}
+
+static bool reopen(const std::string& path, std::vector<ChannelRecord>& records)
+{
+	ChannelStore store;
+	records.clear();
+	return store.open(path, records);
+}
+
+// Sauvegardes, remplacement et suppression relus a la reouverture
+static void testRoundTrip()
+{
+	std::string path = storePath("roundtrip");
+	std::vector<ChannelRecord> records;
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		CHECK(store.isOpen());
+		CHECK(records.empty());
+		store.save("#a", makeRecord("#A", "first"));
+		store.save("#b", makeRecord("#b", "gone"));
+		store.save("#a", makeRecord("#A", "second"));
+		store.remove("#b");
+		store.close();
+		CHECK(!store.isOpen());
+	}
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 1);
+	CHECK(sameRecord(findRecord(records, "#A"), makeRecord("#A", "second")));
+}
+
+// Arret brutal au milieu d'une trame : le journal est coupe a la derniere
+// trame entiere, et les ajouts suivants repartent de la
+static void testTruncatedJournal()
+{
+	std::string path = storePath("truncated");
+	std::string journal = path + ".journal";
+	std::vector<ChannelRecord> records;
+	off_t before_last;
+	off_t full;
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		store.save("#a", makeRecord("#a", "one"));
+		store.save("#b", makeRecord("#b", "two"));
+		store.sync();
+		before_last = fileSize(journal);
+		store.save("#c", makeRecord("#c", "three"));
+		store.close();
+		full = fileSize(journal);
+	}
+	CHECK(before_last > 0 && full > before_last);
+
+	// Coupe en plein entete, puis en pleine charge utile
+	off_t cuts[2] = { before_last + 3, full - 1 };
+	for (int i = 0; i < 2; ++i)
+	{
+		CHECK(truncate(journal.c_str(), cuts[i]) == 0);
+		CHECK(reopen(path, records));
+		CHECK(records.size() == 2);
+		CHECK(sameRecord(findRecord(records, "#a"), makeRecord("#a", "one")));
+		CHECK(sameRecord(findRecord(records, "#b"), makeRecord("#b", "two")));
+		CHECK(findRecord(records, "#c") == NULL);
+		CHECK(fileSize(journal) == before_last);
+	}
+
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		store.save("#d", makeRecord("#d", "four"));
+		store.close();
+	}
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 3);
+	CHECK(sameRecord(findRecord(records, "#d"), makeRecord("#d", "four")));
+}
+
+// Une trame complete mais alteree est rejetee par sa somme, comme la suite
+static void testCorruptedFrame()
+{
+	std::string path = storePath("corrupted");
+	std::string journal = path + ".journal";
+	std::vector<ChannelRecord> records;
+	off_t before_last;
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		store.save("#a", makeRecord("#a", "kept"));
+		store.sync();
+		before_last = fileSize(journal);
+		store.save("#a", makeRecord("#a", "altered"));
+		store.close();
+	}
+	int fd = open(journal.c_str(), O_WRONLY);
+	CHECK(fd >= 0);
+	CHECK(pwrite(fd, "X", 1, fileSize(journal) - 4) == 1);
+	close(fd);
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 1);
+	CHECK(sameRecord(findRecord(records, "#a"), makeRecord("#a", "kept")));
+	CHECK(fileSize(journal) == before_last);
+}
+
+static void limitFileSize(rlim_t size)
+{
+	struct rlimit limit;
+	getrlimit(RLIMIT_FSIZE, &limit);
+	limit.rlim_cur = size;
+	setrlimit(RLIMIT_FSIZE, &limit);
+}
+
+// Disque plein au milieu d'un lot (RLIMIT_FSIZE : write() partiel puis
+// EFBIG) : aucune trame coupee ne reste dans le journal, le lot est garde
+// et reecrit des que possible, sans rien perdre ni sauter
+static void testWriteFailure()
+{
+	std::string path = storePath("full");
+	std::string journal = path + ".journal";
+	std::vector<ChannelRecord> records;
+	std::signal(SIGXFSZ, SIG_IGN);
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		store.save("#a", makeRecord("#a", "before"));
+		store.sync();
+		off_t before = fileSize(journal);
+		limitFileSize(before + 40);
+		store.save("#b", makeRecord("#b", std::string(200, 'b')));
+		store.save("#a", makeRecord("#a", "after"));
+		store.sync();
+		CHECK(fileSize(journal) == before + 40); // trame coupee par le noyau
+		store.sync();
+		CHECK(fileSize(journal) == before + 40);
+		limitFileSize(RLIM_INFINITY);
+		store.sync();
+		CHECK(fileSize(journal) > before + 40);
+		store.save("#c", makeRecord("#c", "last"));
+		store.close();
+	}
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 3);
+	CHECK(sameRecord(findRecord(records, "#a"), makeRecord("#a", "after")));
+	CHECK(sameRecord(findRecord(records, "#b"), makeRecord("#b", std::string(200, 'b'))));
+	CHECK(sameRecord(findRecord(records, "#c"), makeRecord("#c", "last")));
+}
+
+// Un lot qui n'a jamais pu etre ecrit avant close() ne laisse ni trame
+// coupee ni etat fantome : la reouverture retrouve le journal d'avant
+static void testUnwritableBatch()
+{
+	std::string path = storePath("lost");
+	std::string journal = path + ".journal";
+	std::vector<ChannelRecord> records;
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		store.save("#kept", makeRecord("#kept", "kept"));
+		store.sync();
+		limitFileSize(fileSize(journal));
+		store.save("#lost", makeRecord("#lost", "lost"));
+		store.close(); // le lot n'a jamais pu etre ecrit
+		limitFileSize(RLIM_INFINITY);
+	}
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 1 && findRecord(records, "#kept") != NULL);
+	CHECK(fileSize(journal) > 0);
+}
+
+// Au-dela de COMPACT_BYTES : instantane ecrit, journal vide, puis le journal
+// suivant se rejoue par-dessus l'instantane
+static void testCompaction()
+{
+	std::string path = storePath("compact");
+	std::vector<ChannelRecord> records;
+	std::string topic(400, 't');
+	{
+		ChannelStore store;
+		CHECK(store.open(path, records));
+		size_t saves = ChannelStore::COMPACT_BYTES / topic.size() + 1;
+		for (size_t i = 0; i < saves; ++i)
+		{
+			char name[16];
+			std::snprintf(name, sizeof(name), "#c%lu", static_cast<unsigned long>(i % 50));
+			store.save(name, makeRecord(name, topic));
+		}
+		store.remove("#c0");
+		store.sync();
+		// Le thread d'ecriture a pu compacter avant sync() : la fin du lot
+		// est alors dans le journal suivant
+		CHECK(fileSize(path + ".snap") > 0);
+		CHECK(fileSize(path + ".journal") < ChannelStore::COMPACT_BYTES);
+		store.save("#c1", makeRecord("#c1", "after snapshot"));
+		store.remove("#c2");
+		store.close();
+	}
+	CHECK(fileSize(path + ".snap.tmp") == -1);
+	CHECK(reopen(path, records));
+	CHECK(records.size() == 48);
+	CHECK(findRecord(records, "#c0") == NULL);
+	CHECK(findRecord(records, "#c2") == NULL);
+	CHECK(sameRecord(findRecord(records, "#c1"), makeRecord("#c1", "after snapshot")));
+	CHECK(sameRecord(findRecord(records, "#c49"), makeRecord("#c49", topic)));
+}
+
+// Un instantane altere n'est jamais rejoue a moitie : l'ouverture echoue
+static void testCorruptedSnapshot()
+{
+	std::string path = storePath("compact");
+	std::string snapshot = path + ".snap";
+	int fd = open(snapshot.c_str(), O_WRONLY);
+	CHECK(fd >= 0);
+	CHECK(pwrite(fd, "X", 1, fileSize(snapshot) / 2) == 1);
+	close(fd);
+	std::vector<ChannelRecord> records;
+	CHECK(!reopen(path, records));
+}
+
+static void removeFiles(const char *name)
+{
+	const char *suffixes[] = { ".snap", ".snap.tmp", ".journal" };
+	for (size_t i = 0; i < sizeof(suffixes) / sizeof(*suffixes); ++i)
+		unlink((storePath(name) + suffixes[i]).c_str());
+}
+
+int main()
+{
+	char pattern[] = "/tmp/ircserv-test-XXXXXX";
+	if (mkdtemp(pattern) == NULL)
+	{
+		std::perror("mkdtemp");
+		return 1;
+	}
+	directory = pattern;
+	Logger::setLevel(Logger::LEVEL_ERROR);
+
+	testRoundTrip();
+	testTruncatedJournal();
+	testCorruptedFrame();
+	testWriteFailure();
+	testUnwritableBatch();
+	testCompaction();
+	testCorruptedSnapshot();
+
+	const char *names[] = { "roundtrip", "truncated", "corrupted", "full", "lost", "compact" };
+	for (size_t i = 0; i < sizeof(names) / sizeof(*names); ++i)
+		removeFiles(names[i]);
+	rmdir(directory.c_str());
+	return checkReport("store");
+}
@@ -0,0 +1,171 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   test_timers.cpp                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "Check.hpp"
+#include "TimerWheel.hpp"
+#include <vector>
+
+enum { START_MS = 1000000 };
+
+static uint64_t nextRandom(uint64_t& state)
+{
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return state >> 33;
+}
+
+// Tick ou une echeance en ms doit expirer : arrondie au tick superieur
+static uint64_t expectedTick(uint64_t expires_ms)
+{
+	return (expires_ms + TimerWheel::TICK_MS - 1) / TimerWheel::TICK_MS;
+}
+
+static void testEmpty()
+{
+	TimerWheel wheel(START_MS);
+	std::vector<Timer*> expired;
+	CHECK(wheel.size() == 0);
+	CHECK(wheel.nextTimeout(START_MS) == -1);
+	wheel.advance(START_MS + 10000, expired);
+	CHECK(expired.empty());
+}
+
+// Chaque minuterie expire a son tick exact, a tous les niveaux de la roue
+// (jusqu'a 64^3 ticks ici), cascades comprises
+static void testExactExpiry()
+{
+	enum { TIMERS = 2000 };
+	TimerWheel wheel(START_MS);
+	std::vector<Timer> timers(TIMERS);
+	std::vector<uint64_t> deadlines(TIMERS);
+	uint64_t state = 42;
+	uint64_t last = 0;
+	for (size_t i = 0; i < TIMERS; ++i)
+	{
+		uint64_t spread = i % 4 == 0 ? 6000 : i % 4 == 1 ? 400000 : i % 4 == 2 ? 26000000 : 30000;
+		deadlines[i] = START_MS + 1 + nextRandom(state) % spread;
+		timers[i].data = &deadlines[i];
+		wheel.schedule(&timers[i], deadlines[i]);
+		if (expectedTick(deadlines[i]) > last)
+			last = expectedTick(deadlines[i]);
+	}
+	CHECK(wheel.size() == TIMERS);
+
+	size_t fired = 0;
+	size_t early = 0;
+	size_t late = 0;
+	std::vector<Timer*> expired;
+	for (uint64_t tick = START_MS / TimerWheel::TICK_MS + 1; tick <= last; ++tick)
+	{
+		expired.clear();
+		wheel.advance(tick * TimerWheel::TICK_MS, expired);
+		for (size_t i = 0; i < expired.size(); ++i)
+		{
+			uint64_t expected = expectedTick(*static_cast<uint64_t*>(expired[i]->data));
+			if (expected > tick)
+				++early;
+			else if (expected < tick)
+				++late;
+			CHECK(!expired[i]->isScheduled());
+		}
+		fired += expired.size();
+	}
+	CHECK(fired == TIMERS);
+	CHECK(early == 0);
+	CHECK(late == 0);
+	CHECK(wheel.size() == 0);
+}
+
+// Un grand saut d'horloge fait expirer tout ce qui est echu, rien de plus
+static void testJump()
+{
+	TimerWheel wheel(START_MS);
+	Timer near, far;
+	wheel.schedule(&near, START_MS + 500);
+	wheel.schedule(&far, START_MS + 3600000);
+	std::vector<Timer*> expired;
+	wheel.advance(START_MS + 3599900, expired);
+	CHECK(expired.size() == 1 && expired[0] == &near);
+	expired.clear();
+	wheel.advance(START_MS + 3600000, expired);
+	CHECK(expired.size() == 1 && expired[0] == &far);
+}
+
+static void testCancelAndReschedule()
+{
+	TimerWheel wheel(START_MS);
+	Timer a, b;
+	wheel.schedule(&a, START_MS + 1000);
+	wheel.schedule(&b, START_MS + 1000);
+	CHECK(wheel.size() == 2);
+	wheel.cancel(&a);
+	wheel.cancel(&a); // sans effet la seconde fois
+	CHECK(!a.isScheduled());
+	CHECK(wheel.size() == 1);
+	wheel.schedule(&b, START_MS + 20000); // reprogrammer remplace l'echeance
+	CHECK(wheel.size() == 1);
+
+	std::vector<Timer*> expired;
+	wheel.advance(START_MS + 19900, expired);
+	CHECK(expired.empty());
+	wheel.advance(START_MS + 20000, expired);
+	CHECK(expired.size() == 1 && expired[0] == &b);
+}
+
+// Une echeance passee expire au prochain tick
+static void testPastDeadline()
+{
+	TimerWheel wheel(START_MS);
+	Timer timer;
+	wheel.schedule(&timer, START_MS - 5000);
+	std::vector<Timer*> expired;
+	wheel.advance(START_MS, expired);
+	CHECK(expired.empty());
+	wheel.advance(START_MS + TimerWheel::TICK_MS, expired);
+	CHECK(expired.size() == 1);
+}
+
+static void testNextTimeout()
+{
+	TimerWheel wheel(START_MS);
+	Timer soon, later;
+	wheel.schedule(&soon, START_MS + 250);
+	CHECK(wheel.nextTimeout(START_MS) == 300); // arrondi au tick
+	CHECK(wheel.nextTimeout(START_MS + 120) == 180);
+	wheel.cancel(&soon);
+	// Rien au niveau 0 : reveil a la fin du tour pour la cascade
+	wheel.schedule(&later, START_MS + 60000);
+	int timeout = wheel.nextTimeout(START_MS);
+	CHECK(timeout > 0 && timeout <= TimerWheel::SLOTS * TimerWheel::TICK_MS);
+}
+
+// Au-dela de la portee de la roue, l'echeance est ramenee a la limite
+static void testClamp()
+{
+	TimerWheel wheel(START_MS);
+	Timer timer;
+	uint64_t range = (static_cast<uint64_t>(1) << (TimerWheel::SLOT_BITS * TimerWheel::LEVELS)) - 1;
+	wheel.schedule(&timer, START_MS + range * TimerWheel::TICK_MS * 4);
+	CHECK(timer.isScheduled());
+	CHECK(timer.expires == START_MS / TimerWheel::TICK_MS + range);
+}
+
+int main()
+{
+	testEmpty();
+	testExactExpiry();
+	testJump();
+	testCancelAndReschedule();
+	testPastDeadline();
+	testNextTimeout();
+	testClamp();
+	return checkReport("timers");
+}
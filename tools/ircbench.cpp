@@ -0,0 +1,640 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ircbench.cpp                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+// Generateur de charge pour ircserv : ouvre des milliers de connexions en
+// loopback, fait l'enregistrement PASS/NICK/USER, rejoint des canaux puis
+// envoie des PRIVMSG a debit fixe. Chaque message porte son heure d'envoi,
+// ce qui donne la latence de remise cote recepteur.
+//
+//   ./ircbench port=6667 password=pw clients=2000 channels=20 rate=5 duration=10
+
+#include "EventLoop.hpp"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdint.h>
+
+//----------------------OPTIONS-----------------------------------------
+
+struct BenchConfig
+{
+	std::string host;
+	int port;
+	std::string password;
+	size_t clients;
+	size_t channels; // Nombre de canaux distincts
+	size_t joins; // Canaux rejoints par client
+	double rate; // PRIVMSG par seconde et par client
+	double duration; // Secondes de trafic
+	size_t connect_rate; // Connexions ouvertes par seconde
+	size_t size; // Taille de la charge utile
+	std::string pattern; // channel, direct ou mixed
+	std::string backend;
+
+	BenchConfig() : host("127.0.0.1"), port(6667), password("pw"), clients(1000), channels(10), joins(1),
+		rate(1), duration(10), connect_rate(2000), size(64), pattern("channel"), backend("epoll") {}
+	bool parse(const std::string& option);
+};
+
+static void printUsage(const char *prog)
+{
+	std::cerr << "Usage: " << prog << " [key=value ...]" << std::endl;
+	std::cerr << "  host=127.0.0.1 port=6667 password=pw" << std::endl;
+	std::cerr << "  clients=1000        simulated clients" << std::endl;
+	std::cerr << "  channels=10         distinct channels" << std::endl;
+	std::cerr << "  joins=1             channels joined by each client" << std::endl;
+	std::cerr << "  rate=1              PRIVMSG per second per client" << std::endl;
+	std::cerr << "  duration=10         seconds of traffic" << std::endl;
+	std::cerr << "  connect_rate=2000   new connections per second" << std::endl;
+	std::cerr << "  size=64             payload bytes per message" << std::endl;
+	std::cerr << "  pattern=channel     channel | direct | mixed" << std::endl;
+	std::cerr << "  backend=epoll       epoll | poll" << std::endl;
+}
+
+static bool parseCount(const std::string& value, size_t& out)
+{
+	if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+	out = std::strtoul(value.c_str(), NULL, 10);
+	return true;
+}
+
+static bool parseReal(const std::string& value, double& out)
+{
+	char *end;
+	out = std::strtod(value.c_str(), &end);
+	return !value.empty() && *end == '\0' && out >= 0;
+}
+
+bool BenchConfig::parse(const std::string& option)
+{
+	std::string::size_type eq = option.find('=');
+	if (eq == std::string::npos)
+		return false;
+	std::string key = option.substr(0, eq);
+	std::string value = option.substr(eq + 1);
+	size_t number;
+
+	if (key == "host")
+		host = value;
+	else if (key == "port" && parseCount(value, number) && number > 0 && number < 65536)
+		port = number;
+	else if (key == "password")
+		password = value;
+	else if (key == "clients")
+		return parseCount(value, clients) && clients > 0;
+	else if (key == "channels")
+		return parseCount(value, channels) && channels > 0;
+	else if (key == "joins")
+		return parseCount(value, joins);
+	else if (key == "rate")
+		return parseReal(value, rate);
+	else if (key == "duration")
+		return parseReal(value, duration);
+	else if (key == "connect_rate")
+		return parseCount(value, connect_rate) && connect_rate > 0;
+	else if (key == "size")
+		return parseCount(value, size) && size < 400;
+	else if (key == "pattern" && (value == "channel" || value == "direct" || value == "mixed"))
+		pattern = value;
+	else if (key == "backend" && (value == "epoll" || value == "poll"))
+		backend = value;
+	else
+		return false;
+	return true;
+}
+
+static std::string toString(uint64_t value)
+{
+	char digits[24];
+	size_t pos = sizeof(digits);
+	do
+	{
+		digits[--pos] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0);
+	return std::string(digits + pos, sizeof(digits) - pos);
+}
+
+//----------------------TIME-AND-HISTOGRAM-----------------------------------------
+
+static uint64_t nowMicros()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Histogramme log-lineaire : 32 sous-intervalles par puissance de 2, soit
+// une erreur relative < 3 % sur les percentiles, en memoire constante.
+class LatencyHistogram
+{
+	private:
+		static const int SUB_BITS = 5;
+		static const int BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+		std::vector<uint64_t> counts;
+		uint64_t total;
+
+		static int bucketOf(uint64_t value)
+		{
+			if (value < (1u << SUB_BITS))
+				return value;
+			int msb = 63 - __builtin_clzll(value);
+			int shift = msb - SUB_BITS;
+			return ((shift + 1) << SUB_BITS) + ((value >> shift) & ((1u << SUB_BITS) - 1));
+		}
+		static uint64_t lowerBound(int bucket)
+		{
+			if (bucket < (1 << SUB_BITS))
+				return bucket;
+			int shift = (bucket >> SUB_BITS) - 1;
+			uint64_t sub = bucket & ((1 << SUB_BITS) - 1);
+			return ((1ull << SUB_BITS) + sub) << shift;
+		}
+
+	public:
+		LatencyHistogram() : counts(BUCKETS, 0), total(0) {}
+		void record(uint64_t micros)
+		{
+			++counts[bucketOf(micros)];
+			++total;
+		}
+		uint64_t count() const { return total; }
+		uint64_t percentile(double p) const
+		{
+			uint64_t rank = static_cast<uint64_t>(p * total);
+			uint64_t seen = 0;
+			for (int i = 0; i < BUCKETS; ++i)
+			{
+				seen += counts[i];
+				if (seen > rank)
+					return lowerBound(i);
+			}
+			return 0;
+		}
+};
+
+//----------------------SIMULATED-CLIENT-----------------------------------------
+
+struct BenchClient
+{
+	enum State { CONNECTING, REGISTERING, JOINING, READY, DEAD };
+
+	int fd;
+	size_t index;
+	State state;
+	std::string nick;
+	std::string input;
+	std::string output;
+	bool write_armed;
+	size_t joins_pending;
+	uint64_t connect_started;
+	std::vector<size_t> channels;
+
+	BenchClient() : fd(-1), index(0), state(CONNECTING), write_armed(false), joins_pending(0), connect_started(0) {}
+};
+
+class Bench
+{
+	private:
+		const BenchConfig& config;
+		EventLoop *loop;
+		std::vector<EventLoop::Event> events;
+		std::vector<BenchClient> clients;
+		std::vector<size_t> channel_members;
+		struct sockaddr_in server_addr;
+
+		size_t opened;
+		size_t ready;
+		size_t dead;
+		uint64_t sent;
+		uint64_t expected;
+		uint64_t received;
+		uint64_t errors; // Lignes ERROR ou numeriques d'erreur recues
+		LatencyHistogram connect_latency;
+		LatencyHistogram delivery_latency;
+		size_t next_sender;
+		unsigned int random_state;
+		std::string padding;
+
+		unsigned int random();
+		bool openConnection(BenchClient& client);
+		void queue(BenchClient& client, const std::string& data);
+		void flush(BenchClient& client);
+		void kill(BenchClient& client);
+		void onReadable(BenchClient& client);
+		void onLine(BenchClient& client, const char *line, size_t len);
+		void sendOne();
+		void poll(int timeout_ms);
+
+	public:
+		Bench(const BenchConfig& config);
+		~Bench();
+		bool connectAll();
+		void traffic();
+		void report(double connect_seconds, double traffic_seconds) const;
+};
+
+Bench::Bench(const BenchConfig& config) : config(config), loop(EventLoop::create(config.backend)), clients(config.clients),
+	channel_members(config.channels, 0), opened(0), ready(0), dead(0), sent(0), expected(0), received(0), errors(0),
+	next_sender(0), random_state(12345), padding(config.size, 'x')
+{
+	std::memset(&server_addr, 0, sizeof(server_addr));
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(config.port);
+	inet_pton(AF_INET, config.host.c_str(), &server_addr.sin_addr);
+	for (size_t i = 0; i < clients.size(); ++i)
+	{
+		BenchClient& client = clients[i];
+		client.index = i;
+		client.nick = "bench" + toString(i);
+		size_t joins = std::min(config.joins, config.channels);
+		for (size_t k = 0; k < joins; ++k)
+		{
+			size_t channel = (i + k) % config.channels;
+			client.channels.push_back(channel);
+			++channel_members[channel];
+		}
+	}
+}
+
+Bench::~Bench()
+{
+	for (size_t i = 0; i < clients.size(); ++i)
+	{
+		if (clients[i].fd != -1)
+			close(clients[i].fd);
+	}
+	delete loop;
+}
+
+unsigned int Bench::random()
+{
+	random_state = random_state * 1103515245 + 12345;
+	return random_state >> 8;
+}
+
+//----------------------CONNECTION-----------------------------------------
+
+bool Bench::openConnection(BenchClient& client)
+{
+	client.fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (client.fd < 0)
+	{
+		std::cerr << "socket: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+	fcntl(client.fd, F_SETFL, O_NONBLOCK);
+	int one = 1;
+	setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	client.connect_started = nowMicros();
+	if (connect(client.fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0 && errno != EINPROGRESS)
+	{
+		std::cerr << "connect: " << std::strerror(errno) << std::endl;
+		close(client.fd);
+		client.fd = -1;
+		return false;
+	}
+	// La connexion est etablie quand le socket devient inscriptible
+	client.state = BenchClient::CONNECTING;
+	client.write_armed = true;
+	loop->add(client.fd, &client, EventLoop::EV_READ | EventLoop::EV_WRITE);
+	queue(client, "PASS " + config.password + "\r\nNICK " + client.nick + "\r\nUSER " + client.nick + " 0 * :ircbench\r\n");
+	++opened;
+	return true;
+}
+
+void Bench::queue(BenchClient& client, const std::string& data)
+{
+	client.output += data;
+	if (client.state != BenchClient::CONNECTING)
+		flush(client);
+}
+
+void Bench::flush(BenchClient& client)
+{
+	while (!client.output.empty())
+	{
+		ssize_t n = send(client.fd, client.output.data(), client.output.size(), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0)
+		{
+			kill(client);
+			return;
+		}
+		client.output.erase(0, n);
+	}
+	bool want_write = !client.output.empty();
+	if (want_write != client.write_armed)
+	{
+		loop->modify(client.fd, &client, EventLoop::EV_READ | (want_write ? EventLoop::EV_WRITE : 0));
+		client.write_armed = want_write;
+	}
+}
+
+void Bench::kill(BenchClient& client)
+{
+	if (client.state == BenchClient::DEAD)
+		return;
+	if (client.state == BenchClient::READY)
+		--ready;
+	client.state = BenchClient::DEAD;
+	loop->remove(client.fd);
+	close(client.fd);
+	client.fd = -1;
+	++dead;
+}
+
+//----------------------INPUT-----------------------------------------
+
+void Bench::onReadable(BenchClient& client)
+{
+	char buffer[16384];
+	for (;;)
+	{
+		ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0)
+		{
+			kill(client);
+			return;
+		}
+		client.input.append(buffer, n);
+	}
+	size_t start = 0;
+	size_t end;
+	while ((end = client.input.find('\n', start)) != std::string::npos)
+	{
+		size_t len = end - start;
+		if (len > 0 && client.input[start + len - 1] == '\r')
+			--len;
+		onLine(client, client.input.data() + start, len);
+		if (client.state == BenchClient::DEAD)
+			return;
+		start = end + 1;
+	}
+	client.input.erase(0, start);
+}
+
+static const char *findToken(const char *line, size_t len, const char *token)
+{
+	size_t token_len = std::strlen(token);
+	for (size_t i = 0; i + token_len <= len; ++i)
+	{
+		if (std::memcmp(line + i, token, token_len) == 0)
+			return line + i;
+	}
+	return NULL;
+}
+
+void Bench::onLine(BenchClient& client, const char *line, size_t len)
+{
+	const char *privmsg = findToken(line, len, " PRIVMSG ");
+	if (privmsg != NULL)
+	{
+		// ":nick PRIVMSG cible :<micros> <padding>"
+		const char *text = findToken(privmsg, len - (privmsg - line), " :");
+		if (text != NULL)
+		{
+			uint64_t stamp = std::strtoull(text + 2, NULL, 10);
+			uint64_t now = nowMicros();
+			delivery_latency.record(now > stamp ? now - stamp : 0);
+			++received;
+		}
+		return;
+	}
+	if (len >= 4 && std::memcmp(line, "PING", 4) == 0)
+	{
+		queue(client, "PONG" + std::string(line + 4, len - 4) + "\r\n");
+		return;
+	}
+	if (len >= 5 && std::memcmp(line, "ERROR", 5) == 0)
+	{
+		++errors;
+		return;
+	}
+	const char *numeric = findToken(line, len, " 001 ");
+	if (numeric == NULL && len >= 4 && std::memcmp(line, "001 ", 4) == 0)
+		numeric = line;
+	if (numeric != NULL && client.state == BenchClient::REGISTERING)
+	{
+		connect_latency.record(nowMicros() - client.connect_started);
+		std::string joins;
+		for (size_t i = 0; i < client.channels.size(); ++i)
+			joins += "JOIN #bench" + toString(client.channels[i]) + "\r\n";
+		client.joins_pending = client.channels.size();
+		client.state = BenchClient::JOINING;
+		if (client.joins_pending == 0)
+		{
+			client.state = BenchClient::READY;
+			++ready;
+		}
+		queue(client, joins);
+		return;
+	}
+	if (client.state == BenchClient::JOINING && findToken(line, len, " JOIN ") != NULL
+		&& len > client.nick.size() + 1 && line[0] == ':'
+		&& std::memcmp(line + 1, client.nick.data(), client.nick.size()) == 0)
+	{
+		if (--client.joins_pending == 0)
+		{
+			client.state = BenchClient::READY;
+			++ready;
+		}
+		return;
+	}
+	// Numeriques d'erreur (4xx/5xx) : pseudo pris, canal refuse, etc.
+	const char *space = static_cast<const char*>(std::memchr(line, ' ', len));
+	if (space != NULL && space + 4 <= line + len && (space[1] == '4' || space[1] == '5'))
+		++errors;
+}
+
+//----------------------PHASES-----------------------------------------
+
+void Bench::poll(int timeout_ms)
+{
+	if (loop->wait(events, timeout_ms) < 0)
+		return;
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		BenchClient& client = *static_cast<BenchClient*>(events[i].data);
+		if (client.state == BenchClient::DEAD)
+			continue;
+		if (client.state == BenchClient::CONNECTING && (events[i].events & (EventLoop::EV_WRITE | EventLoop::EV_ERROR)))
+		{
+			int error = 0;
+			socklen_t error_len = sizeof(error);
+			getsockopt(client.fd, SOL_SOCKET, SO_ERROR, &error, &error_len);
+			if (error != 0)
+			{
+				kill(client);
+				continue;
+			}
+			client.state = BenchClient::REGISTERING;
+		}
+		if (events[i].events & EventLoop::EV_WRITE)
+			flush(client);
+		if (client.state != BenchClient::DEAD && (events[i].events & (EventLoop::EV_READ | EventLoop::EV_ERROR)))
+			onReadable(client);
+	}
+}
+
+// Ouvre les connexions au debit demande et attend que toutes soient pretes
+bool Bench::connectAll()
+{
+	uint64_t start = nowMicros();
+	uint64_t deadline = start + 60 * 1000000ull;
+	while (ready + dead < clients.size() && nowMicros() < deadline)
+	{
+		uint64_t elapsed = nowMicros() - start;
+		size_t due = std::min(clients.size(), static_cast<size_t>(elapsed * config.connect_rate / 1000000) + 1);
+		while (opened + dead < due && opened < clients.size())
+		{
+			if (!openConnection(clients[opened]))
+				return false;
+		}
+		poll(1);
+	}
+	return ready > 0;
+}
+
+void Bench::sendOne()
+{
+	for (size_t tries = 0; tries < clients.size(); ++tries)
+	{
+		BenchClient& client = clients[next_sender];
+		next_sender = (next_sender + 1) % clients.size();
+		if (client.state != BenchClient::READY)
+			continue;
+		bool direct = config.pattern == "direct" || client.channels.empty()
+			|| (config.pattern == "mixed" && (random() & 1));
+		std::string target;
+		if (direct)
+		{
+			const BenchClient& peer = clients[random() % clients.size()];
+			if (peer.state != BenchClient::READY || &peer == &client)
+				continue;
+			target = peer.nick;
+			++expected;
+		}
+		else
+		{
+			size_t channel = client.channels[random() % client.channels.size()];
+			target = "#bench" + toString(channel);
+			expected += channel_members[channel] - 1;
+		}
+		queue(client, "PRIVMSG " + target + " :" + toString(nowMicros()) + " " + padding + "\r\n");
+		++sent;
+		return;
+	}
+}
+
+// Debit global constant : a chaque tour on rattrape le nombre de messages
+// qui auraient du partir depuis le debut de la phase.
+void Bench::traffic()
+{
+	double total_rate = config.rate * clients.size();
+	uint64_t start = nowMicros();
+	uint64_t stop = start + static_cast<uint64_t>(config.duration * 1000000);
+	uint64_t now;
+	while ((now = nowMicros()) < stop && ready > 0)
+	{
+		uint64_t due = static_cast<uint64_t>(total_rate * (now - start) / 1000000.0);
+		// Pas de rafale geante si le generateur a pris du retard
+		if (due > sent + total_rate)
+			sent = due - static_cast<uint64_t>(total_rate);
+		while (sent < due)
+			sendOne();
+		poll(1);
+	}
+	// Laisse arriver les messages encore en vol
+	uint64_t drain_end = nowMicros() + 2000000;
+	while (received < expected && nowMicros() < drain_end)
+		poll(10);
+}
+
+//----------------------REPORT-----------------------------------------
+
+void Bench::report(double connect_seconds, double traffic_seconds) const
+{
+	std::cout << std::fixed << std::setprecision(1);
+	std::cout << "clients       " << ready << " ready, " << dead << " dropped, " << errors << " error replies" << std::endl;
+	std::cout << "connect rate  " << (connect_seconds > 0 ? ready / connect_seconds : 0) << " conn/s"
+		<< " (p50 " << connect_latency.percentile(0.50) / 1000.0 << " ms, p99 "
+		<< connect_latency.percentile(0.99) / 1000.0 << " ms)" << std::endl;
+	std::cout << "sent          " << sent << " msgs, " << sent / traffic_seconds << " msgs/s" << std::endl;
+	std::cout << "delivered     " << received << " / " << expected << " expected, "
+		<< received / traffic_seconds << " msgs/s" << std::endl;
+	std::cout << std::setprecision(3);
+	std::cout << "latency       p50 " << delivery_latency.percentile(0.50) / 1000.0
+		<< " ms, p99 " << delivery_latency.percentile(0.99) / 1000.0
+		<< " ms, p999 " << delivery_latency.percentile(0.999) / 1000.0 << " ms" << std::endl;
+}
+
+//----------------------MAIN-----------------------------------------
+
+int main(int argc, char *argv[])
+{
+	BenchConfig config;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!config.parse(argv[i]))
+		{
+			std::cerr << "Invalid option: " << argv[i] << std::endl;
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	std::signal(SIGPIPE, SIG_IGN);
+
+	// Deux fd par client en loopback si le serveur tourne sur la meme machine
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+
+	Bench bench(config);
+	uint64_t start = nowMicros();
+	if (!bench.connectAll())
+	{
+		std::cerr << "No client could register" << std::endl;
+		return 1;
+	}
+	double connect_seconds = (nowMicros() - start) / 1000000.0;
+	start = nowMicros();
+	bench.traffic();
+	double traffic_seconds = config.duration > 0 ? config.duration : (nowMicros() - start) / 1000000.0;
+	bench.report(connect_seconds, traffic_seconds);
+	return 0;
+}
@@ -0,0 +1,383 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ircstat.cpp                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: bberthod <bberthod@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2026/10/17 10:00:00 by bberthod          #+#    #+#             */
+/*   Updated: 2026/10/17 10:00:00 by bberthod         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+// Lecteur du segment de statistiques d'ircserv. Le segment est mappe en
+// lecture seule : aucune interaction avec le serveur, qui ne fait aucun
+// appel systeme pour publier ses compteurs.
+//
+//   ./ircstat port=6667                 vue type top, rafraichie chaque seconde
+//   ./ircstat port=6667 mode=prometheus format texte Prometheus, une fois
+
+#include "Stats.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//----------------------SEGMENT-----------------------------------------
+
+// Somme des shards a un instant donne
+struct Snapshot
+{
+	uint64_t accepted;
+	uint64_t closed;
+	uint64_t registrations;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t lines_in;
+	uint64_t messages_out;
+	uint64_t sendq_bytes;
+	uint64_t sendq_exceeded;
+	uint64_t cross_posts;
+	uint64_t unknown_commands;
+	uint64_t throttled;
+	uint64_t write_calls;
+	uint64_t buffer_hits;
+	uint64_t buffer_misses;
+	uint64_t accept_batches;
+	uint64_t accept_capped;
+	uint64_t accept_errors;
+	uint64_t accept_queue_peak;
+	uint64_t rejected_ip_limit;
+	uint64_t rejected_ip_rate;
+	uint64_t commands[StatsShard::MAX_COMMANDS];
+
+	Snapshot() { std::memset(this, 0, sizeof(*this)); }
+	void add(const StatsShard& shard)
+	{
+		accepted += shard.accepted;
+		closed += shard.closed;
+		registrations += shard.registrations;
+		bytes_in += shard.bytes_in;
+		bytes_out += shard.bytes_out;
+		lines_in += shard.lines_in;
+		messages_out += shard.messages_out;
+		sendq_bytes += shard.sendq_bytes;
+		sendq_exceeded += shard.sendq_exceeded;
+		cross_posts += shard.cross_posts;
+		unknown_commands += shard.unknown_commands;
+		throttled += shard.throttled;
+		write_calls += shard.write_calls;
+		buffer_hits += shard.buffer_hits;
+		buffer_misses += shard.buffer_misses;
+		accept_batches += shard.accept_batches;
+		accept_capped += shard.accept_capped;
+		accept_errors += shard.accept_errors;
+		accept_queue_peak = std::max(accept_queue_peak, static_cast<uint64_t>(shard.accept_queue_peak));
+		rejected_ip_limit += shard.rejected_ip_limit;
+		rejected_ip_rate += shard.rejected_ip_rate;
+		for (int i = 0; i < StatsShard::MAX_COMMANDS; ++i)
+			commands[i] += shard.commands[i];
+	}
+};
+
+class Segment
+{
+	private:
+		std::string path;
+		void *base;
+		size_t length;
+		ino_t inode;
+
+	public:
+		Segment(const std::string& path) : path(path), base(NULL), length(0), inode(0) {}
+		~Segment() { unmap(); }
+
+		void unmap()
+		{
+			if (base != NULL)
+				munmap(base, length);
+			base = NULL;
+		}
+
+		// Remappe si le serveur a redemarre (nouveau fichier au meme chemin)
+		bool refresh()
+		{
+			struct stat st;
+			if (stat(path.c_str(), &st) < 0)
+			{
+				unmap();
+				return false;
+			}
+			if (base != NULL && st.st_ino == inode)
+				return true;
+			unmap();
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			length = st.st_size;
+			if (length >= sizeof(StatsHeader))
+			{
+				base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+				if (base == MAP_FAILED)
+					base = NULL;
+			}
+			close(fd);
+			inode = st.st_ino;
+			if (base != NULL && (std::memcmp(header().magic, STATS_MAGIC, sizeof(header().magic)) != 0
+				|| header().version != STATS_VERSION
+				|| length < StatsHeader::segmentSize(header().shard_count)))
+				unmap();
+			return base != NULL;
+		}
+
+		const StatsHeader& header() const { return *static_cast<const StatsHeader*>(base); }
+		const StatsShard& shard(size_t i) const
+		{
+			return reinterpret_cast<const StatsShard*>(static_cast<const char*>(base) + StatsHeader::shardsOffset())[i];
+		}
+		Snapshot total() const
+		{
+			Snapshot snapshot;
+			for (size_t i = 0; i < header().shard_count; ++i)
+				snapshot.add(shard(i));
+			return snapshot;
+		}
+};
+
+//----------------------KERNEL-----------------------------------------
+
+// Debordements des files d'acceptation, pour toute la machine : le noyau ne
+// les compte pas par socket. Lus dans /proc/net/netstat (ligne "TcpExt:" des
+// noms suivie de celle des valeurs).
+static bool readListenOverflows(uint64_t& overflows, uint64_t& drops)
+{
+	std::ifstream netstat("/proc/net/netstat");
+	std::string names;
+	std::string values;
+	while (std::getline(netstat, names) && std::getline(netstat, values))
+	{
+		if (names.compare(0, 7, "TcpExt:") != 0)
+			continue;
+		std::istringstream name_stream(names);
+		std::istringstream value_stream(values);
+		std::string name;
+		std::string value;
+		bool found = false;
+		while (name_stream >> name && value_stream >> value)
+		{
+			if (name == "ListenOverflows")
+				overflows = std::strtoull(value.c_str(), NULL, 10);
+			else if (name == "ListenDrops")
+				drops = std::strtoull(value.c_str(), NULL, 10);
+			else
+				continue;
+			found = true;
+		}
+		return found;
+	}
+	return false;
+}
+
+//----------------------PROMETHEUS-----------------------------------------
+
+static void metric(const char *name, const char *type, const char *help, uint64_t value)
+{
+	std::cout << "# HELP ircserv_" << name << " " << help << "\n";
+	std::cout << "# TYPE ircserv_" << name << " " << type << "\n";
+	std::cout << "ircserv_" << name << " " << value << "\n";
+}
+
+static void printPrometheus(const Segment& segment)
+{
+	const StatsHeader& head = segment.header();
+	Snapshot total = segment.total();
+	metric("uptime_seconds", "gauge", "Seconds since server start.", time(NULL) - head.started);
+	metric("reactors", "gauge", "Reactor threads.", head.shard_count);
+	metric("connections_accepted_total", "counter", "Accepted connections.", total.accepted);
+	metric("connections_closed_total", "counter", "Closed connections.", total.closed);
+	metric("connections", "gauge", "Open connections.", total.accepted - total.closed);
+	metric("registrations_total", "counter", "Completed registrations.", total.registrations);
+	metric("nicknames", "gauge", "Nicknames in use.", head.nicknames);
+	metric("channels", "gauge", "Existing channels.", head.channels);
+	metric("channel_members", "gauge", "Channel memberships.", head.members);
+	metric("bytes_in_total", "counter", "Bytes received from clients.", total.bytes_in);
+	metric("bytes_out_total", "counter", "Bytes sent to clients.", total.bytes_out);
+	metric("lines_in_total", "counter", "Protocol lines received.", total.lines_in);
+	metric("messages_out_total", "counter", "Messages queued for clients.", total.messages_out);
+	metric("write_calls_total", "counter", "writev() calls to client sockets.", total.write_calls);
+	metric("sendq_bytes", "gauge", "Bytes waiting in output queues.", total.sendq_bytes);
+	metric("sendq_exceeded_total", "counter", "Clients dropped for exceeding sendq.", total.sendq_exceeded);
+	metric("cross_reactor_messages_total", "counter", "Messages handed to another reactor.", total.cross_posts);
+	metric("unknown_commands_total", "counter", "Unknown commands received.", total.unknown_commands);
+	metric("throttled_total", "counter", "Times a client was paused by flood control.", total.throttled);
+	metric("buffer_pool_hits_total", "counter", "Message buffers served from a reactor pool.", total.buffer_hits);
+	metric("buffer_pool_misses_total", "counter", "Message buffers allocated with operator new.", total.buffer_misses);
+	metric("accept_batches_total", "counter", "Listener wakeups with pending connections.", total.accept_batches);
+	metric("accept_capped_total", "counter", "Accept batches stopped at accept_batch.", total.accept_capped);
+	metric("accept_errors_total", "counter", "Failed accept() calls (EMFILE, ENFILE, ENOBUFS...).", total.accept_errors);
+	metric("accept_queue_peak", "gauge", "Longest accept queue seen on a listener.", total.accept_queue_peak);
+	metric("rejected_ip_limit_total", "counter", "Connections refused: too many open from the source prefix.", total.rejected_ip_limit);
+	metric("rejected_ip_rate_total", "counter", "Connections refused: source prefix reconnecting too fast.", total.rejected_ip_rate);
+	uint64_t overflows = 0;
+	uint64_t drops = 0;
+	if (readListenOverflows(overflows, drops))
+	{
+		metric("host_listen_overflows_total", "counter", "Accept queue overflows on this host (all sockets).", overflows);
+		metric("host_listen_drops_total", "counter", "SYNs dropped by listeners on this host (all sockets).", drops);
+	}
+	std::cout << "# HELP ircserv_commands_total Commands received, by command.\n";
+	std::cout << "# TYPE ircserv_commands_total counter\n";
+	for (size_t i = 0; i < head.command_count; ++i)
+		std::cout << "ircserv_commands_total{command=\"" << head.command_names[i] << "\"} " << total.commands[i] << "\n";
+	std::cout << "# HELP ircserv_reactor_connections Open connections, by reactor.\n";
+	std::cout << "# TYPE ircserv_reactor_connections gauge\n";
+	for (size_t i = 0; i < head.shard_count; ++i)
+		std::cout << "ircserv_reactor_connections{reactor=\"" << i << "\"} " << segment.shard(i).accepted - segment.shard(i).closed << "\n";
+	std::cout << std::flush;
+}
+
+//----------------------TOP-----------------------------------------
+
+static std::string rate(uint64_t now, uint64_t before, double seconds)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(1) << (now - before) / seconds << "/s";
+	return out.str();
+}
+
+// Part des blocs de message servis par les reserves sur l'intervalle
+static std::string hitRate(const Snapshot& now, const Snapshot& before)
+{
+	uint64_t hits = now.buffer_hits - before.buffer_hits;
+	uint64_t total = hits + now.buffer_misses - before.buffer_misses;
+	if (total == 0)
+		return "-";
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(1) << 100.0 * hits / total << "% hit";
+	return out.str();
+}
+
+static void printTop(const Segment& segment, const Snapshot& now, const Snapshot& before, double seconds)
+{
+	const StatsHeader& head = segment.header();
+	std::cout << "\033[H\033[2J";
+	std::cout << "ircserv pid " << head.pid << ", up " << time(NULL) - head.started << "s, "
+		<< head.shard_count << " reactor(s)\n\n";
+	std::cout << std::left;
+	std::cout << std::setw(16) << "connections" << std::setw(12) << now.accepted - now.closed
+		<< "accept " << rate(now.accepted, before.accepted, seconds)
+		<< "  close " << rate(now.closed, before.closed, seconds) << "\n";
+	std::cout << std::setw(16) << "registered" << std::setw(12) << head.nicknames
+		<< "reg " << rate(now.registrations, before.registrations, seconds) << "\n";
+	std::cout << std::setw(16) << "channels" << std::setw(12) << head.channels
+		<< "members " << head.members << "\n";
+	std::cout << std::setw(16) << "in" << std::setw(12) << rate(now.bytes_in, before.bytes_in, seconds)
+		<< "lines " << rate(now.lines_in, before.lines_in, seconds) << "\n";
+	std::cout << std::setw(16) << "out" << std::setw(12) << rate(now.bytes_out, before.bytes_out, seconds)
+		<< "msgs " << rate(now.messages_out, before.messages_out, seconds)
+		<< "  writes " << rate(now.write_calls, before.write_calls, seconds)
+		<< "  cross-reactor " << rate(now.cross_posts, before.cross_posts, seconds) << "\n";
+	std::cout << std::setw(16) << "sendq" << std::setw(12) << now.sendq_bytes
+		<< "exceeded " << now.sendq_exceeded
+		<< "  throttled " << rate(now.throttled, before.throttled, seconds) << "\n";
+	std::cout << std::setw(16) << "buffers" << std::setw(12) << hitRate(now, before)
+		<< "hits " << rate(now.buffer_hits, before.buffer_hits, seconds)
+		<< "  misses " << rate(now.buffer_misses, before.buffer_misses, seconds) << "\n";
+	uint64_t overflows = 0;
+	uint64_t drops = 0;
+	readListenOverflows(overflows, drops);
+	std::cout << std::setw(16) << "accept queue" << std::setw(12) << now.accept_queue_peak
+		<< "capped " << rate(now.accept_capped, before.accept_capped, seconds)
+		<< "  errors " << now.accept_errors
+		<< "  host overflows " << overflows << "\n";
+	std::cout << std::setw(16) << "rejected" << std::setw(12) << now.rejected_ip_limit + now.rejected_ip_rate
+		<< "per-ip limit " << rate(now.rejected_ip_limit, before.rejected_ip_limit, seconds)
+		<< "  rate " << rate(now.rejected_ip_rate, before.rejected_ip_rate, seconds) << "\n\n";
+
+	std::cout << std::setw(12) << "COMMAND" << std::setw(14) << "TOTAL" << "RATE\n";
+	for (size_t i = 0; i < head.command_count; ++i)
+		std::cout << std::setw(12) << head.command_names[i] << std::setw(14) << now.commands[i]
+			<< rate(now.commands[i], before.commands[i], seconds) << "\n";
+	std::cout << std::setw(12) << "(unknown)" << std::setw(14) << now.unknown_commands
+		<< rate(now.unknown_commands, before.unknown_commands, seconds) << "\n\n";
+
+	std::cout << std::setw(12) << "REACTOR" << std::setw(14) << "CONNECTIONS" << std::setw(14) << "SENDQ" << "OUT\n";
+	for (size_t i = 0; i < head.shard_count; ++i)
+	{
+		const StatsShard& shard = segment.shard(i);
+		std::cout << std::setw(12) << i << std::setw(14) << shard.accepted - shard.closed
+			<< std::setw(14) << shard.sendq_bytes << shard.bytes_out << "\n";
+	}
+	std::cout << std::flush;
+}
+
+//----------------------MAIN-----------------------------------------
+
+static void printUsage(const char *prog)
+{
+	std::cerr << "Usage: " << prog << " [port=6667 | path=<file>] [mode=top|prometheus] [interval=1]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	std::string path = "/tmp/ircserv-6667.stats";
+	std::string mode = "top";
+	double interval = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string option = argv[i];
+		std::string::size_type eq = option.find('=');
+		std::string key = option.substr(0, eq);
+		std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+		if (key == "port" && !value.empty())
+			path = "/tmp/ircserv-" + value + ".stats";
+		else if (key == "path" && !value.empty())
+			path = value;
+		else if (key == "mode" && (value == "top" || value == "prometheus"))
+			mode = value;
+		else if (key == "interval" && std::strtod(value.c_str(), NULL) > 0)
+			interval = std::strtod(value.c_str(), NULL);
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	Segment segment(path);
+	if (!segment.refresh())
+	{
+		std::cerr << "No stats segment at " << path << std::endl;
+		return 1;
+	}
+	if (mode == "prometheus")
+	{
+		printPrometheus(segment);
+		return 0;
+	}
+
+	Snapshot before = segment.total();
+	for (;;)
+	{
+		usleep(static_cast<useconds_t>(interval * 1000000));
+		if (!segment.refresh())
+		{
+			std::cout << "\033[H\033[2JWaiting for " << path << "..." << std::endl;
+			continue;
+		}
+		Snapshot now = segment.total();
+		printTop(segment, now, before, interval);
+		before = now;
+	}
+	return 0;
+}